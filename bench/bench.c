@@ -0,0 +1,663 @@
+/** @file bench.c
+ * 
+ * @brief 
+ * Benchmarks of the solvers and the game loop, run with 'make bench'.
+ * Results are written as CSV or JSON, and can be compared against a
+ * baseline written by an earlier run to catch regressions.
+ *
+ * @par       
+ * COPYRIGHT NOTICE: (c) 2021 Graham Power.  All rights reserved.
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */ 
+
+/***************************** Include Files *********************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+
+#include "status.h"
+
+#include "game.h"
+#include "actors.h"
+#include "dynamic.h"
+#include "compiled.h"
+#include "ttable.h"
+#include "bitset.h"
+#include "query.h"
+#include "gamebatch.h"
+#include "batch.h"
+#include "random.h"
+
+/************************** Constant Definitions *****************************/
+
+#define BENCH_MAX_RECORDS		1024U
+#define BENCH_MIN_TARGET		16U
+#define BENCH_DEFAULT_TARGET	256U
+#define BENCH_DEFAULT_GAMES		2000U
+#define BENCH_DEFAULT_SLACK		10.0
+#define BENCH_WARM_SECONDS		0.05	// How long warm calls are repeated for
+#define BENCH_WARM_CALLS		100000U	// The most warm calls measured
+#define BENCH_COLD_RUNS			5U		// Cold calls and solves keep the fastest of this many runs
+#define BENCH_QUERIES			4096U	// The positions of a query batch
+#define BENCH_QUERY_CONFIGS		4U		// The rules a query batch mixes
+#define BENCH_LANES				4096U	// The games of a game batch
+#define BENCH_PAIR_GAMES		256U	// The least games of an inlined batch pairing, they are cheap
+#define BENCH_MCTS_ITERATIONS	64U		// The playouts of mcts players in games, enough to play these rules well
+
+// Which way a metric should move
+#define BENCH_LOWER				0
+#define BENCH_HIGHER			1
+
+/**************************** Type Definitions *******************************/
+
+struct bench_record
+{
+	char Suite[16];
+	char Name[32];
+	char Metric[16];
+	double Value;
+	const char *Unit;
+	int Better;
+};
+
+struct bench_record records[BENCH_MAX_RECORDS];
+uint32_t recordCount = 0U;
+
+/************************** Function Prototypes ******************************/
+
+/************************** Function Definitions *****************************/
+
+static void Usage(const char *name)
+{
+	fprintf(stderr, "Usage: %s [-n target] [-k max advancement] [-g games] [-f csv|json] [-o file] [-c baseline] [-r percent]\n", name);
+	fprintf(stderr, "  -n  The largest target the solvers are timed at, doubling from %u (default %u)\n", BENCH_MIN_TARGET, BENCH_DEFAULT_TARGET);
+	fprintf(stderr, "  -k  The max advancement the solvers are timed at (default %u)\n", MAX_STATE_ADVANCEMENT);
+	fprintf(stderr, "  -g  The games played by every pairing, with the rules in parameters.h (default %u)\n", BENCH_DEFAULT_GAMES);
+	fprintf(stderr, "  -f  The format of the results (default csv)\n");
+	fprintf(stderr, "  -o  The file to write the results to (default stdout)\n");
+	fprintf(stderr, "  -c  A CSV file written by an earlier run to compare against. Exits with 1\n");
+	fprintf(stderr, "      if any metric got worse by more than -r percent\n");
+	fprintf(stderr, "  -r  The change allowed before a metric counts as a regression (default %.0f)\n", BENCH_DEFAULT_SLACK);
+}
+
+static double Now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (double) ts.tv_sec + (double) ts.tv_nsec * 1e-9;
+}
+
+static void Record(const char *suite, const char *name, const char *metric, double value, const char *unit, int better)
+{
+	struct bench_record *record;
+
+	if (recordCount >= BENCH_MAX_RECORDS)
+	{
+		return;
+	}
+	record = &records[recordCount++];
+	snprintf(record->Suite, sizeof(record->Suite), "%s", suite);
+	snprintf(record->Name, sizeof(record->Name), "%s", name);
+	snprintf(record->Metric, sizeof(record->Metric), "%s", metric);
+	record->Value = value;
+	record->Unit = unit;
+	record->Better = better;
+}
+
+/**
+ * @brief 
+ * Times Dynamic_AI from the first state of games with targets from 
+ * BENCH_MIN_TARGET up to maxTarget. Cold calls start from an empty 
+ * transposition table, warm calls reuse the entries the cold call 
+ * stored. The table and bitset solvers are timed on the same games.
+ */
+static void Bench_Dynamic(uint64_t maxTarget, uint64_t maxAdvancement)
+{
+	struct rules rules_s;
+	struct ttable table_s;
+	struct dynamic_stats stats;
+	struct Dynamic Dynamic;
+	struct Actor Actor;
+	struct Bitset Bitset;
+	uint64_t Advancement;
+	uint64_t target;
+	uint64_t calls;
+	uint32_t run;
+	double start;
+	double elapsed;
+	double fastest;
+	char name[32];
+
+	for (target = BENCH_MIN_TARGET; target <= maxTarget; target *= 2U)
+	{
+		if (Game_InitRules(&rules_s, target, maxAdvancement) != GST_SUCCESS ||
+			TTable_Init(&table_s, TTABLE_CAPACITY) != GST_SUCCESS)
+		{
+			continue;
+		}
+		snprintf(name, sizeof(name), "n%" PRIu64 "_k%" PRIu64, target, maxAdvancement);
+
+		fastest = 0.0;
+		for (run = 0U; run < BENCH_COLD_RUNS; run++)
+		{
+			TTable_Clear(&table_s);
+			start = Now();
+			Dynamic_AI(&table_s, &rules_s, 0U, &Advancement, &stats);
+			elapsed = Now() - start;
+			fastest = (run == 0U || elapsed < fastest) ? elapsed : fastest;
+		}
+		Record("dynamic", name, "cold_us", fastest * 1e6, "us", BENCH_LOWER);
+		Record("dynamic", name, "cold_nodes", (double) stats.Nodes, "nodes", BENCH_LOWER);
+		Record("dynamic", name, "cold_probes", (double) stats.Probes, "probes", BENCH_LOWER);
+		Record("dynamic", name, "max_depth", (double) stats.MaxDepth, "plies", BENCH_LOWER);
+		Record("dynamic", name, "hit_rate", (stats.Probes > 0U) ? (double) stats.Hits / (double) stats.Probes : 0.0, "ratio", BENCH_HIGHER);
+
+		start = Now();
+		calls = 0U;
+		do
+		{
+			Dynamic_AI(&table_s, &rules_s, 0U, &Advancement, NULL);
+			calls++;
+			elapsed = Now() - start;
+		} while (elapsed < BENCH_WARM_SECONDS && calls < BENCH_WARM_CALLS);
+		Record("dynamic", name, "warm_us", elapsed * 1e6 / (double) calls, "us", BENCH_LOWER);
+		TTable_Free(&table_s);
+
+		fastest = 0.0;
+		for (run = 0U; run < BENCH_COLD_RUNS; run++)
+		{
+			start = Now();
+			if (Dynamic_InitTable(&Actor, &Dynamic, &rules_s) != GST_SUCCESS)
+			{
+				Dynamic_Free(&Dynamic);
+				break;
+			}
+			elapsed = Now() - start;
+			fastest = (run == 0U || elapsed < fastest) ? elapsed : fastest;
+			Dynamic_Free(&Dynamic);
+		}
+		if (run == BENCH_COLD_RUNS)
+		{
+			Record("table", name, "solve_us", fastest * 1e6, "us", BENCH_LOWER);
+		}
+
+		fastest = 0.0;
+		for (run = 0U; run < BENCH_COLD_RUNS; run++)
+		{
+			start = Now();
+			if (Bitset_Init(&Actor, &Bitset, &rules_s) != GST_SUCCESS)
+			{
+				Bitset_Free(&Bitset);
+				break;
+			}
+			elapsed = Now() - start;
+			fastest = (run == 0U || elapsed < fastest) ? elapsed : fastest;
+			Bitset_Free(&Bitset);
+		}
+		if (run == BENCH_COLD_RUNS)
+		{
+			Record("bitset", name, "solve_us", fastest * 1e6, "us", BENCH_LOWER);
+		}
+	}
+}
+
+/**
+ * @brief 
+ * Times answering a batch of positions, mixed over a few rules with 
+ * targets from maxTarget up, one Dynamic_AI call at a time against a 
+ * warm transposition table, and as one Query_Batch with the tables 
+ * already solved.
+ */
+static void Bench_Query(uint64_t maxTarget, uint64_t maxAdvancement)
+{
+	struct rules configs[BENCH_QUERY_CONFIGS];
+	struct query *queries;
+	struct ttable table_s;
+	struct Query query_s;
+	uint64_t *moves;
+	int64_t *values;
+	uint64_t state = 1U;
+	uint64_t calls;
+	uint64_t i;
+	double start;
+	double elapsed;
+	char name[32];
+
+	queries = malloc(BENCH_QUERIES*sizeof(struct query));
+	moves = malloc(BENCH_QUERIES*sizeof(uint64_t));
+	values = malloc(BENCH_QUERIES*sizeof(int64_t));
+	if (queries == NULL || moves == NULL || values == NULL || TTable_Init(&table_s, TTABLE_CAPACITY) != GST_SUCCESS)
+	{
+		free(queries);
+		free(moves);
+		free(values);
+		return;
+	}
+	for (i = 0U; i < BENCH_QUERY_CONFIGS; i++)
+	{
+		Game_InitRules(&configs[i], maxTarget + i, maxAdvancement);
+	}
+	for (i = 0U; i < BENCH_QUERIES; i++)
+	{
+		state = state*6364136223846793005ULL + 1442695040888963407ULL;
+		queries[i].Rules = &configs[(state >> 33) % BENCH_QUERY_CONFIGS];
+		queries[i].Score = (state >> 17) % queries[i].Rules->Target;
+	}
+	snprintf(name, sizeof(name), "n%" PRIu64 "_k%" PRIu64 "_x%u", maxTarget, maxAdvancement, BENCH_QUERY_CONFIGS);
+
+	for (i = 0U; i < BENCH_QUERIES; i++)
+	{
+		Dynamic_AI(&table_s, queries[i].Rules, queries[i].Score, &moves[i], NULL);
+	}
+	start = Now();
+	calls = 0U;
+	do
+	{
+		for (i = 0U; i < BENCH_QUERIES; i++)
+		{
+			Dynamic_AI(&table_s, queries[i].Rules, queries[i].Score, &moves[i], NULL);
+		}
+		calls++;
+		elapsed = Now() - start;
+	} while (elapsed < BENCH_WARM_SECONDS);
+	Record("query", name, "single_ns", elapsed * 1e9 / (double) (calls*BENCH_QUERIES), "ns", BENCH_LOWER);
+
+	if (Query_Init(&query_s, 0U) == GST_SUCCESS && Query_Batch(&query_s, queries, BENCH_QUERIES, moves, values) == GST_SUCCESS)
+	{
+		start = Now();
+		calls = 0U;
+		do
+		{
+			Query_Batch(&query_s, queries, BENCH_QUERIES, moves, values);
+			calls++;
+			elapsed = Now() - start;
+		} while (elapsed < BENCH_WARM_SECONDS);
+		Record("query", name, "batch_ns", elapsed * 1e9 / (double) (calls*BENCH_QUERIES), "ns", BENCH_LOWER);
+	}
+	Query_Free(&query_s);
+
+	TTable_Free(&table_s);
+	free(queries);
+	free(moves);
+	free(values);
+}
+
+/**
+ * @brief 
+ * Plays games between random players as game batches with every 
+ * kernel the CPU supports, on the same rules as Bench_Games, and 
+ * records the games a second and the time of a step per game. Moves 
+ * are drawn from the legal ones, as Random_Choose does.
+ */
+static void Bench_GameBatch(uint64_t games)
+{
+	struct game_batch batch_s;
+	struct rules rules_s;
+	struct Random random_s = { .State = 1U };
+	uint64_t *moves;
+	uint64_t played;
+	uint64_t steps;
+	uint64_t legal;
+	uint64_t i;
+	uint8_t kernel;
+	double start;
+	double stepping;
+	double elapsed;
+	char name[32];
+
+	moves = malloc(BENCH_LANES*sizeof(uint64_t));
+	if (moves == NULL)
+	{
+		return;
+	}
+	Game_InitRules(&rules_s, MAX_STATE, MAX_STATE_ADVANCEMENT);
+
+	for (kernel = GAME_BATCH_KERNEL_SCALAR; kernel <= GameBatch_BestKernel(); kernel++)
+	{
+		if (GameBatch_Init(&batch_s, &rules_s, BENCH_LANES, kernel) != GST_SUCCESS)
+		{
+			GameBatch_Free(&batch_s);
+			continue;
+		}
+
+		played = 0U;
+		steps = 0U;
+		stepping = 0.0;
+		start = Now();
+		while (played < games)
+		{
+			GameBatch_Reset(&batch_s);
+			while (batch_s.Live > 0U)
+			{
+				// Games that are over ignore their move
+				for (i = 0U; i < BENCH_LANES; i++)
+				{
+					legal = Game_LegalMoves(&rules_s, rules_s.Target - batch_s.States[i]);
+					moves[i] = (legal > 0U) ? RULES_MOVE(&rules_s, Random_Next(&random_s) % legal) : 1U;
+				}
+				elapsed = Now();
+				GameBatch_Step(&batch_s, moves);
+				stepping += Now() - elapsed;
+				steps++;
+			}
+			played += BENCH_LANES;
+		}
+		elapsed = Now() - start;
+
+		snprintf(name, sizeof(name), "random_%s", GameBatch_KernelName(kernel));
+		Record("gamebatch", name, "games_per_s", (double) played / elapsed, "games/s", BENCH_HIGHER);
+		Record("gamebatch", name, "step_ns", stepping * 1e9 / (double) (steps*BENCH_LANES), "ns", BENCH_LOWER);
+		GameBatch_Free(&batch_s);
+	}
+
+	free(moves);
+}
+
+/**
+ * @brief 
+ * Plays batches between every pairing of random, closed form and 
+ * compiled players, with Batch_Play, which inlines both players, and 
+ * with Batch_PlayActors, which calls them through the Actors. Records 
+ * the time of a move with both.
+ */
+static void Bench_Pairs(uint64_t games)
+{
+	static const uint8_t types[] = { RANDOM, CLOSED_FORM, COMPILED };
+	struct actor_config config1 = { .Seed = 1U };
+	struct actor_config config2 = { .Seed = 2U };
+	struct batch_result result_s;
+	struct rules rules_s;
+	struct Actor player1_s;
+	struct Actor player2_s;
+	uint64_t i;
+	uint64_t j;
+	uint64_t path;
+	double start;
+	double elapsed;
+	char name[32];
+
+	// The moves are a few nanoseconds, so far more games are needed to time them
+	games = (games < BENCH_PAIR_GAMES) ? BENCH_PAIR_GAMES*BENCH_PAIR_GAMES : games*BENCH_PAIR_GAMES;
+	Game_InitRules(&rules_s, MAX_STATE, MAX_STATE_ADVANCEMENT);
+	for (i = 0U; i < sizeof(types); i++)
+	{
+		for (j = 0U; j < sizeof(types); j++)
+		{
+			config1.Type = types[i];
+			config2.Type = types[j];
+			if (Actors_Create(&player1_s, &config1, &rules_s) != GST_SUCCESS)
+			{
+				continue;
+			}
+			if (Actors_Create(&player2_s, &config2, &rules_s) != GST_SUCCESS)
+			{
+				Actors_Destroy(&player1_s);
+				continue;
+			}
+
+			for (path = 0U; path < 2U && Batch_InitResult(&result_s, &rules_s) == GST_SUCCESS; path++)
+			{
+				start = Now();
+				if (path == 0U)
+				{
+					Batch_Play(&rules_s, &player1_s, &player2_s, games, &result_s);
+				}
+				else
+				{
+					Batch_PlayActors(&rules_s, &player1_s, &player2_s, games, &result_s);
+				}
+				elapsed = Now() - start;
+
+				snprintf(name, sizeof(name), "%s_vs_%s_%s", Actors_Name(types[i]), Actors_Name(types[j]), (path == 0U) ? "inlined" : "called");
+				Record("pairs", name, "move_ns", elapsed * 1e9 / (double) result_s.TotalMoves, "ns", BENCH_LOWER);
+				Batch_FreeResult(&result_s);
+			}
+
+			Actors_Destroy(&player1_s);
+			Actors_Destroy(&player2_s);
+		}
+	}
+}
+
+/**
+ * @brief 
+ * Plays games with Game_Spin between every pair of player types 
+ * that can play on their own, and records how many games a second 
+ * each pairing gets through. Mcts players run BENCH_MCTS_ITERATIONS 
+ * playouts a move, at the default every pairing with them takes 
+ * minutes.
+ */
+static void Bench_Games(uint64_t games)
+{
+	struct actor_config config1 = { .Seed = 1U, .Iterations = BENCH_MCTS_ITERATIONS };
+	struct actor_config config2 = { .Seed = 2U, .Iterations = BENCH_MCTS_ITERATIONS };
+	struct rules rules_s;
+	struct Actor player1_s;
+	struct Actor player2_s;
+	struct game game_s;
+	uint8_t type1;
+	uint8_t type2;
+	uint64_t i;
+	double start;
+	double elapsed;
+	char name[32];
+
+	Game_InitRules(&rules_s, MAX_STATE, MAX_STATE_ADVANCEMENT);
+	for (type1 = 0U; type1 < PLAYER_TYPES; type1++)
+	{
+		for (type2 = 0U; type2 < PLAYER_TYPES; type2++)
+		{
+			config1.Type = type1;
+			config2.Type = type2;
+			if (type1 == USER || type2 == USER || type1 == TABLEBASE || type2 == TABLEBASE)
+			{
+				continue;
+			}
+			if (Actors_Create(&player1_s, &config1, &rules_s) != GST_SUCCESS)
+			{
+				continue;
+			}
+			if (Actors_Create(&player2_s, &config2, &rules_s) != GST_SUCCESS)
+			{
+				Actors_Destroy(&player1_s);
+				continue;
+			}
+
+			start = Now();
+			for (i = 0U; i < games; i++)
+			{
+				Game_Init(&game_s, &rules_s, &player1_s, &player2_s);
+				Game_Spin(&game_s);
+			}
+			elapsed = Now() - start;
+
+			snprintf(name, sizeof(name), "%s_vs_%s", Actors_Name(type1), Actors_Name(type2));
+			Record("spin", name, "games_per_s", (double) games / elapsed, "games/s", BENCH_HIGHER);
+
+			Actors_Destroy(&player1_s);
+			Actors_Destroy(&player2_s);
+		}
+	}
+}
+
+static void Write_CSV(FILE *out)
+{
+	uint32_t i;
+
+	fprintf(out, "suite,name,metric,value,unit,better\n");
+	for (i = 0U; i < recordCount; i++)
+	{
+		fprintf(out, "%s,%s,%s,%.6g,%s,%s\n", records[i].Suite, records[i].Name, records[i].Metric,
+			records[i].Value, records[i].Unit, (records[i].Better == BENCH_HIGHER) ? "higher" : "lower");
+	}
+}
+
+static void Write_JSON(FILE *out)
+{
+	uint32_t i;
+
+	fprintf(out, "[\n");
+	for (i = 0U; i < recordCount; i++)
+	{
+		fprintf(out, "  {\"suite\": \"%s\", \"name\": \"%s\", \"metric\": \"%s\", \"value\": %.6g, \"unit\": \"%s\", \"better\": \"%s\"}%s\n",
+			records[i].Suite, records[i].Name, records[i].Metric, records[i].Value, records[i].Unit,
+			(records[i].Better == BENCH_HIGHER) ? "higher" : "lower", (i + 1U < recordCount) ? "," : "");
+	}
+	fprintf(out, "]\n");
+}
+
+/**
+ * @brief 
+ * Compares the results against a CSV file written by an earlier run. 
+ * Metrics missing from either side are skipped. The comparison is 
+ * printed to stderr.
+ * 
+ * @return GStatus GST_FAILURE if the baseline can't be read or any metric regressed, GST_SUCCESS otherwise.
+ */
+static GStatus Compare(const char *path, double slack)
+{
+	char line[256];
+	char suite[16];
+	char name[32];
+	char metric[16];
+	double value;
+	double change;
+	uint32_t regressions = 0U;
+	uint32_t i;
+	FILE *baseline = fopen(path, "r");
+
+	if (baseline == NULL)
+	{
+		fprintf(stderr, "Could not open the baseline %s\n", path);
+		return GST_FAILURE;
+	}
+
+	fprintf(stderr, "%-8s %-24s %-12s %14s %14s %9s\n", "Suite", "Name", "Metric", "Baseline", "Now", "Change");
+	while (fgets(line, sizeof(line), baseline) != NULL)
+	{
+		if (sscanf(line, "%15[^,],%31[^,],%15[^,],%lf", suite, name, metric, &value) != 4)
+		{
+			continue;
+		}
+		for (i = 0U; i < recordCount; i++)
+		{
+			if (strcmp(records[i].Suite, suite) != 0 || strcmp(records[i].Name, name) != 0 || strcmp(records[i].Metric, metric) != 0)
+			{
+				continue;
+			}
+			change = (value != 0.0) ? (records[i].Value - value) / value * 100.0 : 0.0;
+			fprintf(stderr, "%-8s %-24s %-12s %14.6g %14.6g %+8.1f%%", suite, name, metric, value, records[i].Value, change);
+			if ((records[i].Better == BENCH_LOWER && change > slack) || (records[i].Better == BENCH_HIGHER && change < -slack))
+			{
+				fprintf(stderr, "  REGRESSION");
+				regressions++;
+			}
+			fprintf(stderr, "\n");
+			break;
+		}
+	}
+	fclose(baseline);
+	fprintf(stderr, "%u regressions\n", regressions);
+
+	return (regressions == 0U) ? GST_SUCCESS : GST_FAILURE;
+}
+
+int main(int argc, char *argv[])
+{
+	uint64_t target = BENCH_DEFAULT_TARGET;
+	uint64_t maxAdvancement = MAX_STATE_ADVANCEMENT;
+	uint64_t games = BENCH_DEFAULT_GAMES;
+	const char *format = "csv";
+	const char *outPath = NULL;
+	const char *baseline = NULL;
+	double slack = BENCH_DEFAULT_SLACK;
+	GStatus status = GST_SUCCESS;
+	FILE *out;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "n:k:g:f:o:c:r:h")) != -1)
+	{
+		switch (opt)
+		{
+		case 'n':
+			target = strtoull(optarg, NULL, 10);
+			break;
+		case 'k':
+			maxAdvancement = strtoull(optarg, NULL, 10);
+			break;
+		case 'g':
+			games = strtoull(optarg, NULL, 10);
+			break;
+		case 'f':
+			format = optarg;
+			break;
+		case 'o':
+			outPath = optarg;
+			break;
+		case 'c':
+			baseline = optarg;
+			break;
+		case 'r':
+			slack = strtod(optarg, NULL);
+			break;
+		default:
+			Usage(argv[0]);
+			return (opt == 'h') ? 0 : 1;
+		}
+	}
+	if (strcmp(format, "csv") != 0 && strcmp(format, "json") != 0)
+	{
+		Usage(argv[0]);
+		return (1);
+	}
+
+	// Only the work of the players is timed, not their output
+	Log_SetLevel(LOG_QUIET);
+	out = (outPath != NULL) ? fopen(outPath, "w") : stdout;
+	if (out == NULL)
+	{
+		fprintf(stderr, "Could not open the output\n");
+		return (1);
+	}
+
+	Bench_Dynamic(target, maxAdvancement);
+	Bench_Query(target, maxAdvancement);
+	Bench_Games(games);
+	Bench_GameBatch(games);
+	Bench_Pairs(games);
+
+	if (strcmp(format, "json") == 0)
+	{
+		Write_JSON(out);
+	}
+	else
+	{
+		Write_CSV(out);
+	}
+	if (out != stdout)
+	{
+		fclose(out);
+	}
+
+	if (baseline != NULL)
+	{
+		status = Compare(baseline, slack);
+	}
+
+	return (status == GST_SUCCESS) ? 0 : 1;
+}
@@ -0,0 +1,72 @@
+/** @file actors.h
+ * 
+ * @brief 
+ * Creates any type of player from a small configuration, so code 
+ * that plays many games (self-play, tournaments) doesn't have to 
+ * know how each type is set up.
+ *
+ * @par       
+ * COPYRIGHT NOTICE: (c) 2021 Graham Power.  All rights reserved.
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */ 
+
+#ifndef GNP_ACTORS_H		/* prevent circular inclusions */
+#define GNP_ACTORS_H		/* by using protection macros */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/***************************** Include Files *********************************/
+
+#include "parameters.h"
+
+#include <stdint.h>
+
+#include "status.h"
+#include "game.h"
+
+/************************** Constant Definitions *****************************/
+
+/**************************** Type Definitions *******************************/
+
+struct actor_config
+{
+    uint8_t Type;       // Any of the player types in parameters.h
+    uint64_t Seed;      // Only used by RANDOM players
+    const char *Path;   // Only used by TABLEBASE players, the tablebase file to map
+    uint64_t Budget;    // Only used by ALPHABETA and MCTS players, the microseconds per move, 0 for the default
+    uint64_t Iterations; // Only used by MCTS players, the playouts per move, 0 for the default
+    uint32_t Threads;   // Only used by MCTS players, the threads playouts run on, 0 for MCTS_THREADS
+};
+typedef struct actor_config *actor_config_t;
+
+/***************** Macros (Inline Functions) Definitions *********************/
+
+/************************** Function Prototypes ******************************/
+
+GStatus Actors_Create(Actor_t Actor, const struct actor_config *Config, rules_t rules);
+GStatus Actors_Destroy(Actor_t Actor);
+GStatus Actors_Supports(uint8_t Type, rules_t rules);
+GStatus Actors_Reseed(Actor_t Actor, uint64_t Seed);
+GStatus Actors_Parse(const char *Name, uint8_t *Type);
+const char *Actors_Name(uint8_t Type);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* GNP_ACTORS_H */
+
+/*** end of file ***/
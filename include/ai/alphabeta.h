@@ -0,0 +1,108 @@
+/** @file alphabeta.h
+ * 
+ * @brief 
+ * A depth limited negamax search with alpha-beta pruning, for games too
+ * large to solve exactly. The search deepens one ply at a time until
+ * the per-move time budget runs out, and plays the best move of the
+ * deepest search it finished.
+ *
+ * @par       
+ * COPYRIGHT NOTICE: (c) 2021 Graham Power.  All rights reserved.
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */ 
+
+#ifndef GNP_ALPHABETA_H		/* prevent circular inclusions */
+#define GNP_ALPHABETA_H		/* by using protection macros */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/***************************** Include Files *********************************/
+
+#include "parameters.h"
+
+#include <stdio.h>
+#include <stdint.h>
+#include <inttypes.h>
+
+#include "status.h"
+#include "game.h"
+#include "ttable.h"
+#include "dynamic.h"
+
+/************************** Constant Definitions *****************************/
+
+// Scores are for the player to move. A state known to be won scores
+// ALPHABETA_WIN less the plies to the end of the game, so quicker wins
+// score higher, and a lost state the negative of that. States the
+// search doesn't see the end of score 0.
+#define ALPHABETA_WIN           1000000
+#define ALPHABETA_INFINITY      (ALPHABETA_WIN + 1)
+
+// The deepest search, it has to fit in the Depth of a ttdata.
+#define ALPHABETA_MAX_DEPTH     250U
+
+// How many nodes are searched between reads of the clock.
+#define ALPHABETA_CHECK_NODES   256U
+
+// Passed as the budget for a search without a deadline.
+#define ALPHABETA_NO_DEADLINE   UINT64_MAX
+
+/**************************** Type Definitions *******************************/
+
+// One move from the state searched, kept between iterations so each
+// one starts with the best moves of the last.
+struct alphabeta_move
+{
+    uint32_t Counter;
+    uint64_t Advancement;
+    int32_t Score;
+};
+
+struct AlphaBeta
+{
+    struct ttable Table;        // Bounds and best moves found, kept for the whole game
+    uint64_t Budget;            // Microseconds per move, ALPHABETA_NO_DEADLINE for none
+    uint64_t Deadline;          // Monotonic nanoseconds the current search has to end by
+    uint8_t TimedOut;
+    rules_t Rules;              // The rules of the game being searched
+    uint64_t *Scores;           // The counters of the state being searched
+    uint32_t Counters;
+    struct alphabeta_move *Root;   // Every move from the state searched
+    uint64_t RootCapacity;
+    struct dynamic_stats MoveStats;
+    struct dynamic_stats GameStats;
+    uint64_t LastSum;           // The sum of the counters at the last move
+};
+typedef struct AlphaBeta *alphabeta_t;
+
+/***************** Macros (Inline Functions) Definitions *********************/
+
+/************************** Function Prototypes ******************************/
+
+GStatus AlphaBeta_Init(Actor_t Actor, alphabeta_t AlphaBeta, uint64_t Budget);
+GStatus AlphaBeta_Free(alphabeta_t AlphaBeta);
+GStatus AlphaBeta_Act(game_t game, void *ActorBase);
+GStatus AlphaBeta_Choose(game_t game, void *ActorBase, uint64_t *Advancement);
+GStatus AlphaBeta_Search(alphabeta_t AlphaBeta, game_t game, uint32_t *Counter, uint64_t *Advancement, int32_t *Score);
+GStatus AlphaBeta_Verify(uint64_t maxTarget, uint64_t maxAdvancement, uint64_t *Mismatches);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* GNP_ALPHABETA_H */
+
+/*** end of file ***/
@@ -0,0 +1,107 @@
+/** @file bitset.h
+ * 
+ * @brief 
+ * A win/loss solver that keeps one bit per position, for games with
+ * any set of allowed moves. Positions are counted by their distance
+ * from the target, and solved 64 at a time with word-wide and SIMD
+ * bit operations.
+ *
+ * @par       
+ * COPYRIGHT NOTICE: (c) 2021 Graham Power.  All rights reserved.
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */ 
+
+#ifndef GNP_BITSET_H		/* prevent circular inclusions */
+#define GNP_BITSET_H		/* by using protection macros */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/***************************** Include Files *********************************/
+
+#include "parameters.h"
+
+#include <stdio.h>
+#include <stdint.h>
+#include <inttypes.h>
+
+#include "status.h"
+#include "game.h"
+
+/************************** Constant Definitions *****************************/
+
+// The kernels that solve moves of at least BITSET_BLOCK_BITS.
+#define BITSET_KERNEL_AUTO      0U  // The fastest one the CPU supports
+#define BITSET_KERNEL_SCALAR    1U
+#define BITSET_KERNEL_SSE2      2U
+#define BITSET_KERNEL_AVX2      3U
+#define BITSET_KERNELS          4U
+
+// Positions are solved in blocks of this many 64-bit words.
+#define BITSET_BLOCK_WORDS      4U
+#define BITSET_BLOCK_BITS       (64U*BITSET_BLOCK_WORDS)
+
+// The fewest positions Bitset_SolvePeriodic solves before looking for a period.
+#define BITSET_PERIOD_START     (64U*BITSET_BLOCK_BITS)
+
+/**************************** Type Definitions *******************************/
+
+struct Bitset
+{
+    // Bit d is set when the player to move loses from d short of the
+    // target. Lost[-1] and below are padding, so moves past the
+    // target read as not lost.
+    uint64_t *Words;
+    uint64_t *Lost;
+    uint64_t Positions;     // Distances 0 to Positions - 1 are solved
+    // When Period isn't 0, every position from PrePeriod on is lost
+    // exactly when the one Period closer to the target is, so positions
+    // past the solved ones are answered from PrePeriod to PrePeriod + Period.
+    uint64_t PrePeriod;
+    uint64_t Period;
+    uint64_t *Moves;        // The allowed moves, ascending
+    uint32_t MoveCount;
+    uint8_t Kernel;         // The kernel used by the last solve
+};
+typedef struct Bitset *bitset_t;
+
+/***************** Macros (Inline Functions) Definitions *********************/
+
+// Only for solved distances, below Positions. Bitset_IsLost answers any distance.
+#define BITSET_IS_LOST(Bitset, Distance) \
+    (((Bitset)->Lost[(Distance) >> 6] >> ((Distance) & 63U)) & 1U)
+
+/************************** Function Prototypes ******************************/
+
+GStatus Bitset_Solve(bitset_t Bitset, const uint64_t *Moves, uint32_t MoveCount, uint64_t MaxDistance, uint8_t Kernel);
+GStatus Bitset_SolvePeriodic(bitset_t Bitset, const uint64_t *Moves, uint32_t MoveCount, uint64_t MaxDistance, uint8_t Kernel);
+GStatus Bitset_FindPeriod(bitset_t Bitset);
+GStatus Bitset_Free(bitset_t Bitset);
+uint8_t Bitset_IsLost(bitset_t Bitset, uint64_t Distance);
+GStatus Bitset_Move(bitset_t Bitset, uint64_t Distance, uint64_t *Advancement);
+GStatus Bitset_Init(Actor_t Actor, bitset_t Bitset, rules_t rules);
+GStatus Bitset_Act(game_t game, void *ActorBase);
+GStatus Bitset_Choose(game_t game, void *ActorBase, uint64_t *Advancement);
+uint8_t Bitset_BestKernel(void);
+const char *Bitset_KernelName(uint8_t Kernel);
+GStatus Bitset_Verify(uint64_t maxTarget, uint64_t maxAdvancement, uint64_t *Mismatches);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* GNP_BITSET_H */
+
+/*** end of file ***/
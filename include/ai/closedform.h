@@ -0,0 +1,69 @@
+/** @file closedform.h
+ * 
+ * @brief 
+ * A constant time player for the game "Who Says 20 First". Moving to
+ * the nearest score congruent to the target modulo (max advancement + 1)
+ * is the known optimal strategy, so no search or table is needed.
+ *
+ * @par       
+ * COPYRIGHT NOTICE: (c) 2021 Graham Power.  All rights reserved.
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */ 
+
+#ifndef GNP_CLOSEDFORM_H		/* prevent circular inclusions */
+#define GNP_CLOSEDFORM_H		/* by using protection macros */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/***************************** Include Files *********************************/
+
+#include "parameters.h"
+
+#include <stdio.h>
+#include <stdint.h>
+#include <inttypes.h>
+
+#include "status.h"
+#include "game.h"
+
+/************************** Constant Definitions *****************************/
+
+/**************************** Type Definitions *******************************/
+
+/***************** Macros (Inline Functions) Definitions *********************/
+
+// The move ClosedForm_Move picks with Remaining left to the target,
+// for rules it supports. Both arguments are evaluated several times.
+#define CLOSEDFORM_ADVANCE(rules, Remaining) \
+    (((Remaining) <= (rules)->MaxAdvancement) ? (Remaining) : \
+    ((Remaining) % ((rules)->MaxAdvancement + 1U) == 0U) ? 1U : (Remaining) % ((rules)->MaxAdvancement + 1U))
+
+/************************** Function Prototypes ******************************/
+
+GStatus ClosedForm_Init(Actor_t Actor);
+GStatus ClosedForm_Act(game_t game, void *ActorBase);
+GStatus ClosedForm_Choose(game_t game, void *ActorBase, uint64_t *Advancement);
+GStatus ClosedForm_Move(rules_t rules, uint64_t Score, uint64_t *Advancement);
+GStatus ClosedForm_Supports(rules_t rules);
+GStatus ClosedForm_Verify(uint64_t maxTarget, uint64_t maxAdvancement, uint64_t *Mismatches);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* GNP_CLOSEDFORM_H */
+
+/*** end of file ***/
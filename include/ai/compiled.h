@@ -1,8 +1,9 @@
-/** @file hashtable.h
+/** @file compiled.h
  * 
  * @brief 
- * A hashtable to store the results of AI actions. So trees don't
- * have to be explored more than once
+ * A player for the game "Who Says 20 First" that plays from a policy 
+ * table generated at build time for the rules in parameters.h. It 
+ * needs no solving, no heap and no files at runtime.
  *
  * @par       
  * COPYRIGHT NOTICE: (c) 2021 Graham Power.  All rights reserved.
@@ -20,8 +21,8 @@
  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */ 
 
-#ifndef GNP_HASHT_H		/* prevent circular inclusions */
-#define GNP_HASHT_H		/* by using protection macros */
+#ifndef GNP_COMPILED_H		/* prevent circular inclusions */
+#define GNP_COMPILED_H		/* by using protection macros */
 
 #ifdef __cplusplus
 extern "C" {
@@ -29,35 +30,32 @@ extern "C" {
 
 /***************************** Include Files *********************************/
 
-#include "status.h"
+#include "parameters.h"
 
+#include <stdio.h>
 #include <stdint.h>
+#include <inttypes.h>
 
-/************************** Constant Definitions *****************************/
+#include "status.h"
+#include "game.h"
 
-#define HASH_MAX_CAPACITY   50U
+/************************** Constant Definitions *****************************/
 
 /**************************** Type Definitions *******************************/
 
-struct hashtable
-{
-    float hash_map[HASH_MAX_CAPACITY];
-    uint8_t hash_used[HASH_MAX_CAPACITY];
-};
-typedef struct hashtable *hashtable_t;
-
 /***************** Macros (Inline Functions) Definitions *********************/
 
 /************************** Function Prototypes ******************************/
 
-GStatus Hashtable_Init(hashtable_t table);
-GStatus Hashtable_Put(hashtable_t table, uint8_t Score, uint8_t MyTurn, float Reward);
-GStatus Hashtable_Get(hashtable_t table, uint8_t Score, uint8_t MyTurn, float *Reward);
+GStatus Compiled_Init(Actor_t Actor);
+GStatus Compiled_Act(game_t game, void *ActorBase);
+GStatus Compiled_Choose(game_t game, void *ActorBase, uint64_t *Advancement);
+GStatus Compiled_Supports(rules_t rules);
 
 #ifdef __cplusplus
 }
 #endif
 
-#endif /* GNP_HASHT_H */
+#endif /* GNP_COMPILED_H */
 
-/*** end of file ***/
\ No newline at end of file
+/*** end of file ***/
@@ -34,18 +34,54 @@ extern "C" {
 
 #include <math.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <time.h>
 
 #include "status.h"
 #include "game.h"
-#include "hashtable.h"
+#include "ttable.h"
 
 /************************** Constant Definitions *****************************/
 
+// How a Dynamic instance calculates its moves.
+#define DYNAMIC_MODE_RECURSIVE  0U  // Explore the game tree from the current state on every move.
+#define DYNAMIC_MODE_TABLE      1U  // Solve every state once at init, then look moves up.
+
+// The value of a won state in the table, see Dynamic_Solve.
+#define DYNAMIC_WIN_VALUE       (INT64_C(1) << 62)
+
 /**************************** Type Definitions *******************************/
 
+// Counters of the search behind a move, or summed over the moves of a game.
+struct dynamic_stats
+{
+    uint64_t Calls;         // Moves calculated
+    uint64_t Nodes;         // States expanded by Dynamic_Reward
+    uint64_t Terminals;     // States evaluated as the end of the game
+    uint64_t Probes;        // Transposition table lookups
+    uint64_t Hits;
+    uint64_t Misses;
+    uint64_t Stores;
+    uint64_t MaxDepth;      // Deepest ply reached below the state moved from
+    uint64_t Nanoseconds;   // Wall time spent calculating
+};
+
 struct Dynamic
 {
-    hashtable_t table;
+    uint8_t Mode;
+    ttable_t table;
+    // The search of the last move, and the sum over the current game. A
+    // new game is detected when the score is not above the last one seen.
+    struct dynamic_stats MoveStats;
+    struct dynamic_stats GameStats;
+    uint64_t LastScore;
+    // Only used by DYNAMIC_MODE_TABLE. Values are indexed by [2*Score + MyTurn],
+    // both tables hold Rules.Target + 1 scores.
+    struct rules Rules;
+    int64_t *Values;
+    uint32_t *Moves;
 };
 typedef struct Dynamic *dynamic_t;
 
@@ -53,8 +89,18 @@ typedef struct Dynamic *dynamic_t;
 
 /************************** Function Prototypes ******************************/
 
-GStatus Dynamic_Init(Actor_t Actor, dynamic_t Dynamic, hashtable_t table);
+GStatus Dynamic_Init(Actor_t Actor, dynamic_t Dynamic, ttable_t table);
+GStatus Dynamic_InitTable(Actor_t Actor, dynamic_t Dynamic, rules_t rules);
+GStatus Dynamic_Free(dynamic_t Dynamic);
 GStatus Dynamic_Act(game_t game, void *ActorBase);
+GStatus Dynamic_Choose(game_t game, void *ActorBase, uint64_t *Advancement);
+GStatus Dynamic_AI(ttable_t table, rules_t rules, uint64_t Score, uint64_t *Advancement, struct dynamic_stats *Stats);
+GStatus Dynamic_GetMoveStats(dynamic_t Dynamic, struct dynamic_stats *Stats);
+GStatus Dynamic_GetGameStats(dynamic_t Dynamic, struct dynamic_stats *Stats);
+GStatus Dynamic_ResetGameStats(dynamic_t Dynamic);
+GStatus Dynamic_PrintStats(const char *Label, const struct dynamic_stats *Stats);
+GStatus Dynamic_AddStats(struct dynamic_stats *Total, const struct dynamic_stats *Stats);
+GStatus Dynamic_Verify(uint64_t maxTarget, uint64_t maxAdvancement, uint64_t *Mismatches);
 
 #ifdef __cplusplus
 }
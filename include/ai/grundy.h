@@ -0,0 +1,76 @@
+/** @file grundy.h
+ * 
+ * @brief 
+ * A Sprague-Grundy player for games played on many counters at once.
+ * Every counter is an independent game, so the Grundy value of each
+ * score is worked out once, and a move is picked from the nim-sum of
+ * the values of the counters, in time linear in the number of counters
+ * instead of a search over every combination of their scores.
+ *
+ * @par       
+ * COPYRIGHT NOTICE: (c) 2021 Graham Power.  All rights reserved.
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */ 
+
+#ifndef GNP_GRUNDY_H		/* prevent circular inclusions */
+#define GNP_GRUNDY_H		/* by using protection macros */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/***************************** Include Files *********************************/
+
+#include "parameters.h"
+
+#include <stdio.h>
+#include <stdint.h>
+#include <inttypes.h>
+
+#include "status.h"
+#include "game.h"
+
+/************************** Constant Definitions *****************************/
+
+/**************************** Type Definitions *******************************/
+
+struct Grundy
+{
+    struct rules Rules;     // The rules the values were worked out for
+    // The Grundy value of every distance from 0 to Rules.Target short
+    // of the target. NULL for ranges of moves, whose value is the
+    // distance modulo (MaxAdvancement + 1).
+    uint32_t *Values;
+};
+typedef struct Grundy *grundy_t;
+
+/***************** Macros (Inline Functions) Definitions *********************/
+
+/************************** Function Prototypes ******************************/
+
+GStatus Grundy_Init(Actor_t Actor, grundy_t Grundy, rules_t rules);
+GStatus Grundy_Free(grundy_t Grundy);
+GStatus Grundy_Act(game_t game, void *ActorBase);
+GStatus Grundy_Choose(game_t game, void *ActorBase, uint64_t *Advancement);
+uint64_t Grundy_Value(grundy_t Grundy, uint64_t Distance);
+GStatus Grundy_Move(grundy_t Grundy, game_t game, uint32_t *Counter, uint64_t *Advancement);
+GStatus Grundy_Verify(uint64_t maxTarget, uint64_t maxAdvancement, uint64_t *Mismatches);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* GNP_GRUNDY_H */
+
+/*** end of file ***/
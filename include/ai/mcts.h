@@ -0,0 +1,113 @@
+/** @file mcts.h
+ * 
+ * @brief 
+ * A Monte Carlo tree search player. States are scored by the results of
+ * random games played out from them, and the tree grows towards the
+ * moves that win most often by UCT selection. Playouts run in parallel
+ * on a thread pool, sharing one tree held in a preallocated arena.
+ *
+ * @par       
+ * COPYRIGHT NOTICE: (c) 2021 Graham Power.  All rights reserved.
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */ 
+
+#ifndef GNP_MCTS_H		/* prevent circular inclusions */
+#define GNP_MCTS_H		/* by using protection macros */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/***************************** Include Files *********************************/
+
+#include "parameters.h"
+
+#include <stdio.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <stdatomic.h>
+
+#include "status.h"
+#include "game.h"
+#include "random.h"
+#include "threadpool.h"
+
+/************************** Constant Definitions *****************************/
+
+// The Children of a node another thread is expanding.
+#define MCTS_EXPANDING          UINT32_MAX
+
+/**************************** Type Definitions *******************************/
+
+// A node of the tree, reached by moving Advancement on Counter from its
+// parent. Wins count the playouts through the node won by the player
+// who made that move. Virtual counts the threads whose playouts are
+// passing through the node right now, and is scored as that many extra
+// losses, so other threads spread out to other moves.
+struct mcts_node
+{
+    _Atomic uint32_t Visits;
+    _Atomic uint32_t Wins;
+    _Atomic uint32_t Virtual;
+    _Atomic uint32_t Children;  // Arena index of the first child, 0 until expanded
+    uint32_t ChildCount;
+    uint32_t Counter;
+    uint64_t Advancement;
+};
+
+// The per-thread state of a search. Every worker submits its own Task,
+// but the state used is the one of the thread that ends up running it.
+struct mcts_worker
+{
+    struct task Task;
+    struct Random Random;
+    uint64_t *Scores;           // The counters of the state being played out
+    uint32_t *Path;             // Arena indexes of the nodes selected from the root
+};
+
+struct Mcts
+{
+    struct mcts_node *Nodes;    // The arena, node 0 is the root of the search
+    uint32_t Capacity;
+    _Atomic uint64_t Used;      // Nodes allocated, may pass the Capacity once the arena is full
+    uint64_t Iterations;        // Playouts per move, 0 for no limit
+    uint64_t Budget;            // Microseconds per move, 0 for no limit
+    uint64_t Deadline;          // Monotonic nanoseconds the current search has to end by
+    _Atomic uint64_t Started;   // Playouts started by the current search
+    struct threadpool Pool;
+    struct mcts_worker *Workers;    // One per thread of the pool
+    rules_t Rules;              // The rules of the game being searched
+    uint64_t *Root;             // The counters of the state searched
+    uint32_t Counters;          // The length of Root and of every worker's Scores
+};
+typedef struct Mcts *mcts_t;
+
+/***************** Macros (Inline Functions) Definitions *********************/
+
+/************************** Function Prototypes ******************************/
+
+GStatus Mcts_Init(Actor_t Actor, mcts_t Mcts, uint64_t Iterations, uint64_t Budget, uint32_t Threads, uint64_t Seed);
+GStatus Mcts_Free(mcts_t Mcts);
+GStatus Mcts_Reseed(mcts_t Mcts, uint64_t Seed);
+GStatus Mcts_Act(game_t game, void *ActorBase);
+GStatus Mcts_Choose(game_t game, void *ActorBase, uint64_t *Advancement);
+GStatus Mcts_Search(mcts_t Mcts, game_t game, uint32_t *Counter, uint64_t *Advancement, double *WinRate);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* GNP_MCTS_H */
+
+/*** end of file ***/
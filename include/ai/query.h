@@ -0,0 +1,107 @@
+/** @file query.h
+ * 
+ * @brief 
+ * Answers batches of best move queries, each a score under its own rules.
+ * Queries are grouped by their rules so every solved Dynamic table is
+ * looked up for all of its queries in one pass, and tables are kept
+ * between batches.
+ *
+ * @par       
+ * COPYRIGHT NOTICE: (c) 2021 Graham Power.  All rights reserved.
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */ 
+
+#ifndef GNP_QUERY_H		/* prevent circular inclusions */
+#define GNP_QUERY_H		/* by using protection macros */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/***************************** Include Files *********************************/
+
+#include "parameters.h"
+
+#include <stdio.h>
+#include <stdint.h>
+#include <inttypes.h>
+
+#include "status.h"
+#include "game.h"
+#include "dynamic.h"
+
+/************************** Constant Definitions *****************************/
+
+// How many queries ahead of the one being answered the table is prefetched.
+#define QUERY_PREFETCH_DISTANCE 8U
+
+/**************************** Type Definitions *******************************/
+
+// One position to answer, the score of a game under its rules.
+struct query
+{
+    rules_t Rules;
+    uint64_t Score;
+};
+
+// A solved table, with its own copy of the moves of its rules.
+struct query_table
+{
+    uint64_t Key;           // Of Rules, from TTable_Key
+    struct rules Rules;
+    uint64_t *Moves;
+    struct Dynamic Dynamic;
+    uint64_t LastUsed;      // The batch that last looked it up, the oldest is replaced first
+};
+
+// The queries of a batch with the same rules, Order[Start] to Order[Start + Count - 1].
+struct query_group
+{
+    uint64_t Key;           // Of Rules, from TTable_Key
+    rules_t Rules;
+    uint64_t Start;
+    uint64_t Count;
+};
+
+// The scratch arrays are kept between batches, so they are only grown.
+struct Query
+{
+    struct query_table *Tables;
+    uint32_t TableCount;
+    uint32_t TableCapacity;
+    uint64_t Batches;
+    struct query_group *Groups;
+    uint32_t GroupCapacity;
+    uint32_t *Group;        // The group of every query
+    uint64_t *Order;        // The queries ordered by group
+    uint64_t OrderCapacity;
+};
+typedef struct Query *query_t;
+
+/***************** Macros (Inline Functions) Definitions *********************/
+
+/************************** Function Prototypes ******************************/
+
+GStatus Query_Init(query_t Query, uint32_t Tables);
+GStatus Query_Free(query_t Query);
+GStatus Query_Batch(query_t Query, const struct query *Queries, uint64_t Count, uint64_t *Moves, int64_t *Values);
+GStatus Query_Verify(uint64_t maxTarget, uint64_t maxAdvancement, uint64_t *Mismatches);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* GNP_QUERY_H */
+
+/*** end of file ***/
@@ -0,0 +1,73 @@
+/** @file random.h
+ * 
+ * @brief 
+ * A player for the game "Who Says 20 First" that picks a legal
+ * move uniformly at random. Used as an opponent in self-play.
+ *
+ * @par       
+ * COPYRIGHT NOTICE: (c) 2021 Graham Power.  All rights reserved.
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */ 
+
+#ifndef GNP_RANDOM_H		/* prevent circular inclusions */
+#define GNP_RANDOM_H		/* by using protection macros */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/***************************** Include Files *********************************/
+
+#include "parameters.h"
+
+#include <stdio.h>
+#include <stdint.h>
+#include <inttypes.h>
+
+#include "status.h"
+#include "game.h"
+
+/************************** Constant Definitions *****************************/
+
+/**************************** Type Definitions *******************************/
+
+struct Random
+{
+    uint64_t State;     // xorshift64* state, never 0
+};
+typedef struct Random *random_t;
+
+/***************** Macros (Inline Functions) Definitions *********************/
+
+// One xorshift64* step of State, which is evaluated several times.
+// Random_Next is built on it, loops that inline the random player
+// step a local copy of the state with it.
+#define RANDOM_NEXT(State) \
+    ((State) ^= (State) >> 12, (State) ^= (State) << 25, (State) ^= (State) >> 27, (State)*0x2545F4914F6CDD1DULL)
+
+/************************** Function Prototypes ******************************/
+
+GStatus Random_Init(Actor_t Actor, random_t Random, uint64_t Seed);
+GStatus Random_Act(game_t game, void *ActorBase);
+GStatus Random_Choose(game_t game, void *ActorBase, uint64_t *Advancement);
+uint64_t Random_Next(random_t Random);
+uint64_t Random_Seed(uint64_t Seed, uint64_t Stream);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* GNP_RANDOM_H */
+
+/*** end of file ***/
@@ -0,0 +1,117 @@
+/** @file tablebase.h
+ * 
+ * @brief 
+ * Solved strategy tables stored in versioned binary files. A table 
+ * is written once with Tablebase_Write, and players then map the 
+ * file read-only, so startup doesn't depend on the target and every 
+ * process on the host shares the same copy through the page cache.
+ * Games on many counters are solved with Tablebase_WriteCounters, 
+ * one byte for every combination of scores.
+ *
+ * @par       
+ * COPYRIGHT NOTICE: (c) 2021 Graham Power.  All rights reserved.
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */ 
+
+#ifndef GNP_TABLEBASE_H		/* prevent circular inclusions */
+#define GNP_TABLEBASE_H		/* by using protection macros */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/***************************** Include Files *********************************/
+
+#include "parameters.h"
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <inttypes.h>
+
+#include "status.h"
+#include "game.h"
+
+/************************** Constant Definitions *****************************/
+
+#define TABLEBASE_MAGIC         "WS20TB"
+#define TABLEBASE_VERSION       2U      // Version 1 files are still read, they have no Counters or Ending
+#define TABLEBASE_BYTE_ORDER    0x01020304U     // Reads back swapped on a host of the other endianness
+
+// What the entries of a table hold.
+#define TABLEBASE_KIND_MOVES    1U  // The best advancement for every score below the target
+#define TABLEBASE_KIND_COUNTERS 2U  // Whether the player to move wins, for every combination of Counters scores
+
+// The one byte entries of a TABLEBASE_KIND_COUNTERS table.
+#define TABLEBASE_LOST          1U
+#define TABLEBASE_WON           2U
+
+/**************************** Type Definitions *******************************/
+
+// The start of every tablebase file. The entries follow at DataOffset.
+struct tablebase_header
+{
+    char Magic[8];
+    uint32_t Version;
+    uint32_t ByteOrder;
+    uint32_t Kind;
+    uint32_t EntrySize;     // Bytes per entry, 2 or 4
+    uint64_t Target;
+    uint64_t MaxAdvancement;
+    uint64_t Entries;
+    uint64_t DataOffset;
+    uint32_t Counters;      // The number of counters the table was solved for, 0 in version 1
+    uint32_t Ending;        // The GAME_END value of the rules
+};
+
+struct Tablebase
+{
+    const struct tablebase_header *Header;
+    const void *Entries;
+    void *Map;
+    size_t Length;
+    // Only used by TABLEBASE_KIND_COUNTERS tables, see Tablebase_MoveCounters
+    uint64_t *Binomial;
+    uint64_t *Scores;
+};
+typedef struct Tablebase *tablebase_t;
+
+/***************** Macros (Inline Functions) Definitions *********************/
+
+// n choose k, from a table of Binomials built for up to counters scores.
+#define TABLEBASE_BINOMIAL(table, counters, n, k)   ((table)[(n)*((uint64_t) (counters) + 1U) + (k)])
+
+/************************** Function Prototypes ******************************/
+
+GStatus Tablebase_Write(const char *Path, rules_t rules);
+GStatus Tablebase_WriteCounters(const char *Path, rules_t rules, uint32_t counters, uint32_t threads);
+GStatus Tablebase_SolveCounters(rules_t rules, uint32_t counters, uint32_t threads, uint8_t *Entries);
+GStatus Tablebase_CountPositions(rules_t rules, uint32_t counters, uint64_t *Positions);
+GStatus Tablebase_Open(tablebase_t Tablebase, const char *Path);
+GStatus Tablebase_Close(tablebase_t Tablebase);
+GStatus Tablebase_Matches(tablebase_t Tablebase, rules_t rules);
+GStatus Tablebase_Lookup(tablebase_t Tablebase, rules_t rules, uint64_t Score, uint64_t *Advancement);
+GStatus Tablebase_MoveCounters(tablebase_t Tablebase, game_t game, uint32_t *Counter, uint64_t *Advancement);
+GStatus Tablebase_Init(Actor_t Actor, tablebase_t Tablebase, const char *Path);
+GStatus Tablebase_Act(game_t game, void *ActorBase);
+GStatus Tablebase_Choose(game_t game, void *ActorBase, uint64_t *Advancement);
+GStatus Tablebase_Verify(uint64_t maxTarget, uint64_t maxAdvancement, uint64_t *Mismatches);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* GNP_TABLEBASE_H */
+
+/*** end of file ***/
@@ -0,0 +1,75 @@
+/** @file batch.h
+ * 
+ * @brief 
+ * Plays many games of "Who Say's 20 First" between two players 
+ * without any output, and collects the results.
+ *
+ * @par       
+ * COPYRIGHT NOTICE: (c) 2021 Graham Power.  All rights reserved.
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */ 
+
+#ifndef GNP_BATCH_H		/* prevent circular inclusions */
+#define GNP_BATCH_H		/* by using protection macros */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/***************************** Include Files *********************************/
+
+#include "parameters.h"
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "status.h"
+#include "game.h"
+#include "actors.h"
+
+/************************** Constant Definitions *****************************/
+
+/**************************** Type Definitions *******************************/
+
+struct batch_result
+{
+    uint64_t Games;
+    uint64_t Wins[2];           // Games won by player 1 and player 2
+    uint64_t Errors;            // Games stopped by an illegal move
+    uint64_t TotalMoves;        // Moves taken over every game
+    uint64_t MaxAdvancement;    // The length of MoveCounts
+    uint64_t *MoveCounts;       // How often each advancement was played, [a - 1] counts adds of a
+};
+typedef struct batch_result *batch_result_t;
+
+/***************** Macros (Inline Functions) Definitions *********************/
+
+/************************** Function Prototypes ******************************/
+
+GStatus Batch_InitResult(batch_result_t result, rules_t rules);
+GStatus Batch_FreeResult(batch_result_t result);
+GStatus Batch_Run(rules_t rules, const struct actor_config *player1, const struct actor_config *player2, uint64_t games, batch_result_t result);
+GStatus Batch_Play(rules_t rules, Actor_t player1, Actor_t player2, uint64_t games, batch_result_t result);
+GStatus Batch_PlayActors(rules_t rules, Actor_t player1, Actor_t player2, uint64_t games, batch_result_t result);
+GStatus Batch_Merge(batch_result_t into, const struct batch_result *from);
+GStatus Batch_PrintResult(const struct batch_result *result);
+GStatus Batch_Verify(uint64_t maxTarget, uint64_t maxAdvancement, uint64_t *Mismatches);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* GNP_BATCH_H */
+
+/*** end of file ***/
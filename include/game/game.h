@@ -29,52 +29,99 @@ extern "C" {
 
 #include "parameters.h"
 
-#ifdef VERBOSE_OUTPUT
 #include <stdio.h>
-#endif
 #include <stdint.h>
+#include <inttypes.h>
 
 #include "status.h"
+#include "log.h"
 
 /************************** Constant Definitions *****************************/
 
 #define GAME_NOT_WON   0U
 #define GAME_WON       1U
 
-#define MAX_STATE               20U
-#define MAX_STATE_ADVANCEMENT   2U
-
 #define TURN_PLAYER1    1U
 #define TURN_PLAYER2    2U
 
+// How a game ends, see rules.Ending.
+#define GAME_END_NORMAL 0U  // The player who can't move loses
+#define GAME_END_MISERE 1U  // The player who can't move wins
+#define GAME_END_FIRST  2U  // The first player to say the target on any counter wins, or else the player who can't move loses
+
 /**************************** Type Definitions *******************************/
 
 typedef struct game *game_t;
 typedef struct Actor *Actor_t;
+typedef struct rules *rules_t;
 
+// The moves of a game are either every advancement from 1 to
+// MaxAdvancement, or the sparse set in Moves. Use RULES_MOVE_COUNT
+// and RULES_MOVE to go over them without caring which.
+struct rules
+{
+    uint64_t Target;            // The score that has to be said to win
+    uint64_t MaxAdvancement;    // The largest move, players can add anything from 1 to this when Moves is NULL
+    const uint64_t *Moves;      // The allowed moves in ascending order, NULL for the range 1 to MaxAdvancement
+    uint64_t MoveCount;         // The length of Moves
+    uint64_t MoveHash;          // Tells move sets apart in keys, 0 for ranges
+    uint8_t Ending;             // Any of the GAME_END values, GAME_END_NORMAL unless set after init
+};
+
+// A game is played on one counter, State, or on many independent
+// counters with the same rules. Then every turn advances exactly one
+// of them, and the player who can't advance any loses.
 struct game
 {
-    uint8_t State;
+    uint64_t State;
+    uint64_t *States;   // The counters of a many counter game, NULL when State is the only one
+    uint32_t Counters;  // The number of counters, 1 when States is NULL
+    uint32_t Live;      // Counters some move can still be made on
     uint8_t Won; 
+    rules_t Rules;
     Actor_t Player1;
     Actor_t Player2;
     uint8_t PlayerTurn;
 };
 
 struct Actor {
+    uint8_t Type;       // Any of the player types in parameters.h
     GStatus (*Action)(game_t, void *Actor);
+    // Picks the next move without taking it or printing anything.
+    // NULL for actors that can't decide on their own, like users.
+    GStatus (*Choose)(game_t, void *Actor, uint64_t *Advancement);
     void* ActorBase;   
 };
 
 /***************** Macros (Inline Functions) Definitions *********************/
 
+// The number of moves of the rules, and the i'th smallest of them.
+#define RULES_MOVE_COUNT(rules)     (((rules)->Moves == NULL) ? (rules)->MaxAdvancement : (rules)->MoveCount)
+#define RULES_MOVE(rules, i)        (((rules)->Moves == NULL) ? (uint64_t) (i) + 1U : (rules)->Moves[i])
+
+// Whether the player who made the last move of a game is its winner.
+#define GAME_MOVER_WINS(rules)      ((rules)->Ending != GAME_END_MISERE)
+
+// The score of counter i of a game.
+#define GAME_COUNTER(game, i)       (((game)->States == NULL) ? (game)->State : (game)->States[i])
+
 /************************** Function Prototypes ******************************/
 
-GStatus Game_Init (game_t game, Actor_t player1, Actor_t player2);
+GStatus Game_InitRules(rules_t rules, uint64_t target, uint64_t maxAdvancement);
+GStatus Game_InitMoveSet(rules_t rules, uint64_t target, const uint64_t *moves, uint64_t count);
+uint64_t Game_LegalMoves(rules_t rules, uint64_t remaining);
+uint8_t Game_IsLegalMove(rules_t rules, uint64_t advancement);
+uint8_t Game_Search(rules_t rules, uint32_t counters, uint64_t *States, int8_t *Won, uint64_t Index);
+GStatus Game_ParseEnding(const char *Name, uint8_t *Ending);
+GStatus Game_Init (game_t game, rules_t rules, Actor_t player1, Actor_t player2);
+GStatus Game_InitCounters(game_t game, rules_t rules, uint64_t *states, uint32_t counters, Actor_t player1, Actor_t player2);
 GStatus Game_SpinOnce(game_t game);
 GStatus Game_Spin(game_t game);
-GStatus Game_AdvanceState(game_t game, uint8_t advancement);
-GStatus Game_GetState(game_t game, uint8_t *state);
+GStatus Game_AdvanceState(game_t game, uint64_t advancement);
+GStatus Game_AdvanceCounter(game_t game, uint32_t counter, uint64_t advancement);
+uint8_t Game_IsOver(rules_t rules, const uint64_t *Scores, uint32_t counters, uint8_t *MoverWins);
+uint8_t Game_IsRepeated(const uint64_t *Scores, uint32_t Counter);
+GStatus Game_GetState(game_t game, uint64_t *state);
 GStatus Game_IsWon(game_t game, uint8_t *isWon);
 GStatus Game_PrintTurn(game_t game);
 GStatus Game_PrintScore(game_t game);
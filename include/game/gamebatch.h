@@ -0,0 +1,97 @@
+/** @file gamebatch.h
+ * 
+ * @brief 
+ * Many games with the same rules stored as parallel arrays, a struct of
+ * arrays, and stepped together. A step applies one move to every game
+ * without branching on any of them, with SIMD kernels where the CPU
+ * has them.
+ *
+ * @par       
+ * COPYRIGHT NOTICE: (c) 2021 Graham Power.  All rights reserved.
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */ 
+
+#ifndef GNP_GAMEBATCH_H		/* prevent circular inclusions */
+#define GNP_GAMEBATCH_H		/* by using protection macros */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/***************************** Include Files *********************************/
+
+#include "parameters.h"
+
+#include <stdio.h>
+#include <stdint.h>
+#include <inttypes.h>
+
+#include "status.h"
+#include "game.h"
+
+/************************** Constant Definitions *****************************/
+
+// The kernels that step a batch.
+#define GAME_BATCH_KERNEL_AUTO      0U  // The fastest one the CPU supports
+#define GAME_BATCH_KERNEL_SCALAR    1U
+#define GAME_BATCH_KERNEL_AVX2      2U
+#define GAME_BATCH_KERNELS          3U
+
+/**************************** Type Definitions *******************************/
+
+// Games on one counter each, all with the same rules. Game i is
+// States[i], Turns[i], Won[i] and Errors[i].
+struct game_batch
+{
+    uint64_t Games;
+    uint64_t *States;
+    uint8_t *Turns;         // The player to move, TURN_PLAYER1 or TURN_PLAYER2
+    uint8_t *Won;           // GAME_WON once the game is over
+    uint8_t *Errors;        // 1 once the game was stopped by an illegal move
+    uint64_t Live;          // Games neither won nor stopped
+    rules_t Rules;
+    // Bit a of Legal[a >> 6] is set when a is a move. Ranges have a single
+    // word of ones and a WordMask of 0, so every move up to the max is legal.
+    uint64_t *Legal;
+    uint64_t WordMask;
+    uint8_t Kernel;         // The kernel GameBatch_Step uses
+};
+typedef struct game_batch *game_batch_t;
+
+/***************** Macros (Inline Functions) Definitions *********************/
+
+// The winner of game i, TURN_PLAYER1 or TURN_PLAYER2, and 0 while it is
+// played or once it was stopped. The turn has already passed on from
+// the player who moved last.
+#define GAME_BATCH_WINNER(Batch, i) \
+    (((Batch)->Won[i] != GAME_WON) ? 0U : \
+    (((Batch)->Turns[i] == TURN_PLAYER1) == GAME_MOVER_WINS((Batch)->Rules)) ? TURN_PLAYER2 : TURN_PLAYER1)
+
+/************************** Function Prototypes ******************************/
+
+GStatus GameBatch_Init(game_batch_t Batch, rules_t rules, uint64_t Games, uint8_t Kernel);
+GStatus GameBatch_Reset(game_batch_t Batch);
+GStatus GameBatch_Free(game_batch_t Batch);
+GStatus GameBatch_Step(game_batch_t Batch, const uint64_t *Moves);
+uint8_t GameBatch_BestKernel(void);
+const char *GameBatch_KernelName(uint8_t Kernel);
+GStatus GameBatch_Verify(uint64_t maxTarget, uint64_t maxAdvancement, uint64_t *Mismatches);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* GNP_GAMEBATCH_H */
+
+/*** end of file ***/
@@ -1,6 +1,9 @@
 /** @file PLAYER.h
  * 
- * @brief A manual player for the game. 
+ * @brief 
+ * A manual player for the game. The player is a state machine fed 
+ * with whatever input has arrived, so it never waits on a human and 
+ * one thread can drive the turns of many of them.
  *
  * @par       
  * COPYRIGHT NOTICE: (c) 2021 Graham Power.  All rights reserved.
@@ -27,20 +30,60 @@ extern "C" {
 
 /***************************** Include Files *********************************/
 
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+
 #include "status.h"
 #include "game.h"
 
 /************************** Constant Definitions *****************************/
 
+// Where the player is in its turn
+#define PLAYER_IDLE         0U  // Not its turn, input is left unused
+#define PLAYER_COUNTER      1U  // Waiting for the counter to add to
+#define PLAYER_MOVE         2U  // Waiting for the amount to add
+#define PLAYER_CLOSED       3U  // The input ended, no move will come
+
+// The longest line read as a number, longer lines are refused whole
+#define PLAYER_LINE_MAX     32U
+
+// How much Player_Act reads from its descriptor at once
+#define PLAYER_READ_SIZE    256U
+
 /**************************** Type Definitions *******************************/
 
+struct Player
+{
+    uint8_t Phase;
+    uint32_t Counter;           // The counter picked this turn, from 0
+    char Line[PLAYER_LINE_MAX]; // The line being typed
+    uint32_t LineLength;
+    uint8_t Overlong;           // The line outgrew Line, it is dropped at its end
+    // Prompts and errors for the human, to be written out and passed to Player_Drain
+    char *Output;
+    size_t OutputLength;
+    size_t OutputCapacity;
+    // Only used by Player_Act, the descriptor it reads and the input after the last move
+    int Fd;
+    char Unread[PLAYER_READ_SIZE];
+    size_t UnreadStart;
+    size_t UnreadLength;
+};
+typedef struct Player *player_t;
+
 /***************** Macros (Inline Functions) Definitions *********************/
 
 /************************** Function Prototypes ******************************/
 
-GStatus Player_Init(Actor_t Actor);
-GStatus Player_Act(game_t game, void* ActorBase);
-
+GStatus Player_Init(Actor_t Actor, player_t Player, int Fd);
+GStatus Player_Free(player_t Player);
+GStatus Player_Act(game_t game, void *ActorBase);
+GStatus Player_Begin(player_t Player, game_t game);
+GStatus Player_Feed(player_t Player, game_t game, const char *Input, size_t Length, size_t *Used);
+GStatus Player_Close(player_t Player, game_t game);
+GStatus Player_Drain(player_t Player, size_t Written);
+GStatus Player_Verify(uint64_t maxTarget, uint64_t maxAdvancement, uint64_t *Mismatches);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,131 @@
+/** @file server.h
+ * 
+ * @brief 
+ * A long running server that plays games against clients over a Unix
+ * or localhost TCP socket. One thread multiplexes every connection
+ * with epoll, and the players are shared by every game with the same
+ * rules, so each game is solved once. The line protocol is described
+ * in server.c.
+ *
+ * @par       
+ * COPYRIGHT NOTICE: (c) 2021 Graham Power.  All rights reserved.
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */ 
+
+#ifndef GNP_SERVER_H		/* prevent circular inclusions */
+#define GNP_SERVER_H		/* by using protection macros */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/***************************** Include Files *********************************/
+
+#include "parameters.h"
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#include "status.h"
+#include "game.h"
+#include "actors.h"
+
+/************************** Constant Definitions *****************************/
+
+// The longest request line, longer lines are refused whole
+#define SERVER_LINE_MAX         128U
+
+// A session stops being read while this much of its output is unsent,
+// so a client that doesn't read can't make the server buffer forever
+#define SERVER_OUTPUT_MAX       (64U*1024U)
+
+// The events taken from epoll at once, and the backlog of the socket
+#define SERVER_EVENTS           256U
+#define SERVER_BACKLOG          128
+
+/**************************** Type Definitions *******************************/
+
+// A player shared by every session playing the same type and rules.
+// The rules live here, the players that keep a pointer to them need it.
+struct server_player
+{
+    uint8_t Used;
+    uint8_t Type;
+    struct rules Rules;
+    struct Actor Actor;
+    uint32_t Sessions;      // The sessions playing it, it is only replaced at 0
+    uint64_t LastUsed;
+};
+
+// One connection. A session plays one game at a time.
+struct server_session
+{
+    int Fd;
+    char In[SERVER_LINE_MAX];   // The request being received
+    uint32_t InLength;
+    uint8_t Overlong;           // The request outgrew In, it is refused at its end
+    char *Out;                  // Replies not yet sent
+    size_t OutLength;
+    size_t OutCapacity;
+    uint32_t Events;            // The epoll events the session waits for
+    uint8_t Closing;            // Closed once Out is sent
+    struct game Game;
+    struct server_player *Player;   // NULL when no game was started
+    uint8_t ClientTurn;         // TURN_PLAYER1 if the client moves first, TURN_PLAYER2 otherwise
+    struct server_session *Next;
+    struct server_session *Prev;
+};
+
+struct server_stats
+{
+    uint64_t Accepted;      // Connections taken
+    uint64_t Requests;      // Request lines answered
+    uint64_t Games;         // Games started
+    uint64_t Finished;      // Games played to the end
+    uint64_t Errors;        // Requests answered with ERR
+};
+
+struct server
+{
+    int Epoll;
+    int Listen;
+    char *Path;                 // The Unix socket to remove at the end, NULL for TCP
+    struct rules Rules;         // The rules of games that don't name their own
+    struct actor_config Config; // The settings every server player is made with
+    struct server_player Players[SERVER_PLAYERS];
+    uint64_t Clock;             // Counts player lookups, for LastUsed
+    struct server_session *Sessions;
+    uint64_t Open;              // Sessions connected now
+    struct server_stats Stats;
+};
+typedef struct server *server_t;
+
+/***************** Macros (Inline Functions) Definitions *********************/
+
+/************************** Function Prototypes ******************************/
+
+GStatus Server_Init(server_t Server, const char *Address, rules_t rules, const struct actor_config *Config);
+GStatus Server_Free(server_t Server);
+GStatus Server_Run(server_t Server);
+GStatus Server_Stop(void);
+GStatus Server_PrintStats(server_t Server);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* GNP_SERVER_H */
+
+/*** end of file ***/
@@ -0,0 +1,81 @@
+/** @file tournament.h
+ * 
+ * @brief 
+ * Plays round robin matches between player types on every core, 
+ * using a work-stealing thread pool.
+ *
+ * @par       
+ * COPYRIGHT NOTICE: (c) 2021 Graham Power.  All rights reserved.
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */ 
+
+#ifndef GNP_TOURNAMENT_H		/* prevent circular inclusions */
+#define GNP_TOURNAMENT_H		/* by using protection macros */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/***************************** Include Files *********************************/
+
+#include "parameters.h"
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "status.h"
+#include "game.h"
+#include "batch.h"
+#include "threadpool.h"
+
+/************************** Constant Definitions *****************************/
+
+// How many games one task plays. Small enough for the workers to
+// balance the load by stealing, large enough to hide the overhead.
+#define TOURNAMENT_CHUNK_GAMES  4096U
+
+/**************************** Type Definitions *******************************/
+
+struct tournament
+{
+    struct rules Rules;
+    uint8_t Types[PLAYER_TYPES];    // The player types that take part
+    uint32_t TypeCount;
+    uint64_t Games;                 // Games played by every pairing
+    uint64_t Seed;
+    uint64_t Iterations;            // The playouts of mcts players, see struct actor_config
+    uint64_t Budget;                // The search budget of alphabeta and mcts players
+    uint32_t Threads;
+    // [TypeCount * TypeCount], the pairing of Types[i] as player 1 and
+    // Types[j] as player 2 is at [i * TypeCount + j]
+    struct batch_result *Results;
+};
+typedef struct tournament *tournament_t;
+
+/***************** Macros (Inline Functions) Definitions *********************/
+
+/************************** Function Prototypes ******************************/
+
+GStatus Tournament_Init(tournament_t tournament, rules_t rules, uint64_t games, uint32_t threads, const struct actor_config *config);
+GStatus Tournament_Free(tournament_t tournament);
+GStatus Tournament_Run(tournament_t tournament);
+GStatus Tournament_PrintResult(tournament_t tournament);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* GNP_TOURNAMENT_H */
+
+/*** end of file ***/
@@ -31,21 +31,83 @@ extern "C" {
 
 /************************** Constant Definitions *****************************/
 
-// Enables game state and non-player state updates in the terminal.
-// Uncomment to remove.
-#define VERBOSE_OUTPUT
+// The log level games start with, see log.h. It can be changed at runtime
+// with Log_SetLevel, or with -l on the command line.
+// 0 = quiet, 1 = game updates, 2 = search counters, 3 = search trace.
+#define LOG_DEFAULT_LEVEL       1U
 
-// Enables detailed output about the calculations preformed by non-user players.
-// Uncomment to enable. This will make the terminal output very messy.
-#define TRACE_CALCS
+// The highest log level compiled in. Logging above it is removed by the
+// compiler, so it costs nothing at runtime.
+#define LOG_MAX_LEVEL           3U
+
+// The number of search trace records each thread keeps. Once full, the
+// oldest records are overwritten. Rounded up to a power of two.
+#define TRACE_RING_CAPACITY     (1UL << 16)
+
+// The default score that has to be said to win, and the default
+// maximum amount a player can add on their turn. Both can be changed
+// at game creation, see Game_InitRules.
+#define MAX_STATE               20U
+#define MAX_STATE_ADVANCEMENT   2U
+
+// The number of entries in a transposition table of a recursive
+// Dynamic player, and in the one table every recursive Dynamic player
+// of the process shares. Rounded up to a power of two.
+#define TTABLE_CAPACITY         (1UL << 16)
+#define TTABLE_SHARED_CAPACITY  (1UL << 20)
+
+// The microseconds an alphabeta player may spend on every move, unless
+// set on the command line, and the entries of its transposition table.
+#define ALPHABETA_BUDGET_US         10000U
+#define ALPHABETA_TTABLE_CAPACITY   (1UL << 20)
+
+// The playouts an mcts player runs for every move, unless a count or a
+// time budget is set on the command line, the nodes its tree may grow
+// to, and the threads the playouts run on, 0 for one per core. The
+// exploration constant weighs rarely tried moves against the win rate
+// of the others in UCT selection, sqrt(2) in theory.
+#define MCTS_ITERATIONS         4096U
+#define MCTS_ARENA_NODES        (1U << 18)
+#define MCTS_THREADS            0U
+#define MCTS_EXPLORATION        1.41421356
+
+// The most solved tables a batch query keeps between batches, the
+// least recently used one is replaced first.
+#define QUERY_CACHE_TABLES      64U
+
+// The most players a server keeps, one for every player type and rules
+// its clients play, shared by their games. The least recently used one
+// no game is playing is replaced first. Clients can't ask for a target
+// or max advancement above the cap, which bounds what one game solves.
+// Mcts plays every playout to the end of the game, so its moves take
+// time in proportion to the target, and it has a lower cap of its own.
+// Players that solve every state over every move are capped by the
+// target times the moves, see Server_Work. The cap is a few hundredths
+// of a second of the slowest of them, misere table.
+#define SERVER_PLAYERS          64U
+#define SERVER_MAX_TARGET       (1UL << 20)
+#define SERVER_MAX_MCTS_TARGET  (1UL << 12)
+#define SERVER_MAX_WORK         (1UL << 22)
 
 // Types of players.
 // Don't change these!
 #define USER    0U      // A manual player, who will interact with the terminal.
 #define DYNAMIC 1U      // An ai player, who will use dynamic programming to play.
+#define DYNAMIC_TABLE 2U // An ai player, who solves every state once up front and then plays by lookup.
+#define CLOSED_FORM 3U  // An ai player, who plays the known optimal strategy in constant time.
+#define RANDOM  4U      // An ai player, who picks a legal move at random.
+#define TABLEBASE 5U    // An ai player, who plays from a solved table mapped from a file.
+#define COMPILED 6U     // An ai player, who plays from a policy generated into the binary at build time.
+#define BITSET  7U      // An ai player, who solves every state once up front into one bit each.
+#define GRUNDY  8U      // An ai player, who plays games on many counters by the Sprague-Grundy theorem.
+#define ALPHABETA 9U    // An ai player, who searches as deep as its time budget per move allows.
+#define MCTS    10U     // An ai player, who plays the move that wins the most random games played out from it.
+#define PLAYER_TYPES 11U // The number of player types above.
 
 // Sets the type of player 1 and 2.
-// Can be any of 'USER', 'DYNAMIC'.
+// Can be any of 'USER', 'DYNAMIC', 'DYNAMIC_TABLE', 'CLOSED_FORM', 'RANDOM', 'COMPILED',
+// 'BITSET', 'GRUNDY', 'ALPHABETA', 'MCTS'.
+// 'TABLEBASE' needs a file, so it can only be picked on the command line.
 #define PLAYER1     USER
 #define PLAYER2     DYNAMIC
 
@@ -37,13 +37,14 @@ extern "C" {
 
 /***************** Common Components statuses 501 - 1000 *********************/
 
-/********************** Hash Table statuses 501 - 510 ************************/
+/***************** Transposition Table statuses 501 - 510 ********************/
 #define GST_HASH_EXISTS         501L
 
 /********************* Game State statuses 511 - 530 *************************/
 
 #define GST_INVALID_STATE       511L
 #define GST_GAME_WON            512L
+#define GST_NEEDS_INPUT         513L
 
 /**************************** Type Definitions *******************************/
 
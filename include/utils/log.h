@@ -0,0 +1,103 @@
+/** @file log.h
+ * 
+ * @brief 
+ * Runtime log levels, and a trace sink for the solvers. Trace records
+ * are written in binary to a ring buffer owned by the writing thread,
+ * and only formatted as text when they are dumped.
+ *
+ * @par       
+ * COPYRIGHT NOTICE: (c) 2021 Graham Power.  All rights reserved.
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */ 
+
+#ifndef GNP_LOG_H		/* prevent circular inclusions */
+#define GNP_LOG_H		/* by using protection macros */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/***************************** Include Files *********************************/
+
+#include "parameters.h"
+
+#include <stdio.h>
+#include <stdint.h>
+#include <inttypes.h>
+
+#include "status.h"
+
+/************************** Constant Definitions *****************************/
+
+// Log levels, every level includes the ones below it.
+#define LOG_QUIET   0U      // Nothing but what users have to see
+#define LOG_INFO    1U      // Game updates and the moves players take
+#define LOG_DEBUG   2U      // Search counters of every move and game
+#define LOG_TRACE   3U      // Every state searched, written to the trace sink
+
+// Trace events, see Trace_Dump for the fields each one uses.
+#define TRACE_REWARD        1U  // Dynamic_Reward calculated a state
+#define TRACE_REWARD_HIT    2U  // Dynamic_Reward found a state in the transposition table
+#define TRACE_CANDIDATE     3U  // Dynamic_AI is about to calculate a move
+#define TRACE_CANDIDATE_END 4U  // Dynamic_AI calculated a move
+#define TRACE_BEST          5U  // Dynamic_AI picked a move
+#define TRACE_SOLVE         6U  // Dynamic_Solve solved a state
+#define TRACE_LOOKUP        7U  // Dynamic_Lookup looked a move up
+
+/**************************** Type Definitions *******************************/
+
+// One trace event. Kept small and flat so writing one is a few stores.
+struct trace_record
+{
+    uint8_t Event;
+    uint8_t Turn;
+    uint64_t Score;
+    uint64_t Arg;           // The depth or the move, depending on the event
+    union
+    {
+        double Real;
+        int64_t Integer;
+    } Value;
+};
+
+/***************** Macros (Inline Functions) Definitions *********************/
+
+extern uint8_t Log_Level;
+
+// Constant folds to 0 for levels above LOG_MAX_LEVEL.
+#define LOG_ENABLED(level)  ((level) <= LOG_MAX_LEVEL && (level) <= Log_Level)
+
+#define LOG_PRINTF(level, ...) \
+    do { if (LOG_ENABLED(level)) { printf(__VA_ARGS__); } } while (0)
+
+// Writes a trace record with the passed in fields, e.g.
+// TRACE_EVENT(.Event = TRACE_BEST, .Arg = move)
+#define TRACE_EVENT(...) \
+    do { if (LOG_ENABLED(LOG_TRACE)) { struct trace_record record_ = { __VA_ARGS__ }; Trace_Write(&record_); } } while (0)
+
+/************************** Function Prototypes ******************************/
+
+GStatus Log_SetLevel(uint8_t Level);
+GStatus Log_Parse(const char *Name, uint8_t *Level);
+void Trace_Write(const struct trace_record *Record);
+GStatus Trace_Dump(FILE *Out);
+GStatus Trace_Free(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* GNP_LOG_H */
+
+/*** end of file ***/
@@ -0,0 +1,89 @@
+/** @file threadpool.h
+ * 
+ * @brief 
+ * A work-stealing thread pool. Every worker owns a deque of tasks,
+ * takes work from its own end, and steals from the other end of
+ * another worker's deque when it runs out.
+ *
+ * @par       
+ * COPYRIGHT NOTICE: (c) 2021 Graham Power.  All rights reserved.
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */ 
+
+#ifndef GNP_THREADPOOL_H		/* prevent circular inclusions */
+#define GNP_THREADPOOL_H		/* by using protection macros */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/***************************** Include Files *********************************/
+
+#include "status.h"
+
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+/************************** Constant Definitions *****************************/
+
+/**************************** Type Definitions *******************************/
+
+typedef struct threadpool *threadpool_t;
+
+// A unit of work. Tasks are owned by the caller and must stay valid
+// until ThreadPool_Run returns. Worker is the index of the worker
+// running the task, from 0 to Threads - 1, for per-thread state.
+struct task
+{
+    void (*Run)(threadpool_t pool, uint32_t Worker, void *Arg);
+    void *Arg;
+};
+
+// A Chase-Lev deque of task pointers with a fixed, power of two capacity.
+struct wsdeque
+{
+    _Atomic int64_t Top;
+    _Atomic int64_t Bottom;
+    _Atomic(struct task *) *Buffer;
+    int64_t Mask;
+};
+
+struct threadpool
+{
+    uint32_t Threads;
+    struct wsdeque *Deques;     // One per worker
+    pthread_t *Handles;
+    _Atomic uint64_t Pending;   // Tasks submitted but not yet finished
+    uint32_t NextSubmit;        // Round robin position of ThreadPool_Submit
+};
+
+/***************** Macros (Inline Functions) Definitions *********************/
+
+/************************** Function Prototypes ******************************/
+
+GStatus ThreadPool_Init(threadpool_t pool, uint32_t threads, uint64_t capacity);
+GStatus ThreadPool_Free(threadpool_t pool);
+GStatus ThreadPool_Submit(threadpool_t pool, struct task *task);
+GStatus ThreadPool_Spawn(threadpool_t pool, uint32_t Worker, struct task *task);
+GStatus ThreadPool_Run(threadpool_t pool);
+uint32_t ThreadPool_Cores(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* GNP_THREADPOOL_H */
+
+/*** end of file ***/
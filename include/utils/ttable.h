@@ -0,0 +1,109 @@
+/** @file ttable.h
+ * 
+ * @brief 
+ * A transposition table to store the results of AI searches, so
+ * game states don't have to be explored more than once. Entries
+ * are found by a 64-bit key over the game state using open
+ * addressing, in a table whose capacity is a power of two.
+ * Tables can be probed and stored to by many threads at once
+ * without locks, see TTable_Shared.
+ *
+ * @par       
+ * COPYRIGHT NOTICE: (c) 2021 Graham Power.  All rights reserved.
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */ 
+
+#ifndef GNP_TTABLE_H		/* prevent circular inclusions */
+#define GNP_TTABLE_H		/* by using protection macros */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/***************************** Include Files *********************************/
+
+#include "status.h"
+#include "game.h"
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdatomic.h>
+
+/************************** Constant Definitions *****************************/
+
+// How many consecutive slots a key may occupy. When they are all
+// taken by other keys, the one with the shallowest Depth is replaced.
+#define TTABLE_PROBE_LIMIT  4U
+
+/**************************** Type Definitions *******************************/
+
+// The data stored for a key. It is packed into a single 64-bit word.
+struct ttdata
+{
+    union
+    {
+        float Reward;       // Real valued rewards
+        int32_t Score;      // Integer scores, or plies to the end of the game
+    } Value;
+    uint16_t Move;          // The best advancement found from this state
+    uint8_t Depth;          // How much search the value is worth, used for replacement
+    uint8_t Flags;          // Free for the solver to use
+};
+
+// Key holds the key xor Data. A reader that races a writer sees a
+// key and data that don't belong together, and takes it as a miss.
+struct ttentry
+{
+    _Atomic uint64_t Key;
+    _Atomic uint64_t Data;
+};
+
+struct ttstats
+{
+    uint64_t Probes;
+    uint64_t Hits;
+    uint64_t Misses;
+    uint64_t Stores;
+    uint64_t Replacements;  // Stores that evicted a different key
+};
+
+struct ttable
+{
+    struct ttentry *Entries;
+    uint64_t Mask;          // Capacity - 1, the capacity is a power of two
+    struct ttstats Stats;   // Not kept by shared tables, threads would fight over them
+    uint8_t Shared;
+};
+typedef struct ttable *ttable_t;
+
+/***************** Macros (Inline Functions) Definitions *********************/
+
+/************************** Function Prototypes ******************************/
+
+GStatus TTable_Init(ttable_t table, uint64_t capacity);
+GStatus TTable_Free(ttable_t table);
+ttable_t TTable_Shared(void);
+GStatus TTable_Clear(ttable_t table);
+uint64_t TTable_Key(rules_t rules, uint64_t Score, uint8_t Turn, uint64_t Ply);
+GStatus TTable_Store(ttable_t table, uint64_t Key, const struct ttdata *Data);
+GStatus TTable_Probe(ttable_t table, uint64_t Key, struct ttdata *Data);
+GStatus TTable_GetStats(ttable_t table, struct ttstats *Stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* GNP_TTABLE_H */
+
+/*** end of file ***/
@@ -0,0 +1,365 @@
+/** @file actors.c
+ * 
+ * @brief 
+ * Creates any type of player from a small configuration, so code 
+ * that plays many games (self-play, tournaments) doesn't have to 
+ * know how each type is set up.
+ *
+ * @par       
+ * COPYRIGHT NOTICE: (c) 2021 Graham Power.  All rights reserved.
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */ 
+
+#include "actors.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "player.h"
+#include "dynamic.h"
+#include "closedform.h"
+#include "random.h"
+#include "tablebase.h"
+#include "compiled.h"
+#include "bitset.h"
+#include "grundy.h"
+#include "alphabeta.h"
+#include "mcts.h"
+
+/************************** Constant Definitions *****************************/
+
+/**************************** Type Definitions *******************************/
+
+// The names players are known by on the command line, indexed by type.
+static const char *const ActorNames[] = {
+    [USER]          = "user",
+    [DYNAMIC]       = "dynamic",
+    [DYNAMIC_TABLE] = "table",
+    [CLOSED_FORM]   = "closed",
+    [RANDOM]        = "random",
+    [TABLEBASE]     = "tablebase",
+    [COMPILED]      = "compiled",
+    [BITSET]        = "bitset",
+    [GRUNDY]        = "grundy",
+    [ALPHABETA]     = "alphabeta",
+    [MCTS]          = "mcts",
+};
+
+#define ACTOR_TYPES (sizeof(ActorNames)/sizeof(ActorNames[0]))
+
+_Static_assert(ACTOR_TYPES == PLAYER_TYPES, "Every player type in parameters.h needs a name");
+
+/************************** Function Prototypes ******************************/
+
+/************************** Function Definitions *****************************/
+
+/**
+ * @brief 
+ * Initializes an Actor of the configured type for games played 
+ * with the passed in rules. Any base structure the type needs is 
+ * allocated here, and released by Actors_Destroy.
+ * 
+ * @param Actor The actor to initialize.
+ * @param Config The type of the actor, and its settings.
+ * @param rules The rules of the games the actor will play.
+ * @return GStatus The success of the initialization.
+ */
+GStatus Actors_Create(Actor_t Actor, const struct actor_config *Config, rules_t rules)
+{
+    GStatus Status = GST_SUCCESS;
+    dynamic_t Dynamic;
+    ttable_t Table;
+    player_t Player;
+    random_t Random;
+    tablebase_t Tablebase;
+    bitset_t Bitset;
+    grundy_t Grundy;
+    alphabeta_t AlphaBeta;
+    mcts_t Mcts;
+
+    Actor->Type = Config->Type;
+    Actor->ActorBase = NULL;
+    if (Actors_Supports(Config->Type, rules) != GST_SUCCESS)
+    {
+        return GST_FAILURE;
+    }
+
+    switch (Config->Type)
+    {
+    case USER:
+        Player = malloc(sizeof(struct Player));
+        if (Player == NULL)
+        {
+            return GST_FAILURE;
+        }
+        Status = Player_Init(Actor, Player, STDIN_FILENO);
+        break;
+    case DYNAMIC:
+        // Rewards only depend on the state, so every game warms the table for the others
+        Dynamic = malloc(sizeof(struct Dynamic));
+        Table = TTable_Shared();
+        if (Dynamic == NULL || Table == NULL)
+        {
+            free(Dynamic);
+            return GST_FAILURE;
+        }
+        Status = Dynamic_Init(Actor, Dynamic, Table);
+        break;
+    case DYNAMIC_TABLE:
+        Dynamic = malloc(sizeof(struct Dynamic));
+        if (Dynamic == NULL)
+        {
+            return GST_FAILURE;
+        }
+        Status = Dynamic_InitTable(Actor, Dynamic, rules);
+        break;
+    case CLOSED_FORM:
+        Status = ClosedForm_Init(Actor);
+        break;
+    case RANDOM:
+        Random = malloc(sizeof(struct Random));
+        if (Random == NULL)
+        {
+            return GST_FAILURE;
+        }
+        Status = Random_Init(Actor, Random, Config->Seed);
+        break;
+    case TABLEBASE:
+        Tablebase = malloc(sizeof(struct Tablebase));
+        if (Tablebase == NULL || Config->Path == NULL)
+        {
+            free(Tablebase);
+            return GST_FAILURE;
+        }
+        Status = Tablebase_Init(Actor, Tablebase, Config->Path);
+        if (Status == GST_SUCCESS &&
+            Tablebase_Matches(Tablebase, rules) != GST_SUCCESS)
+        {
+            // The table was solved for a different game
+            Status = GST_FAILURE;
+        }
+        break;
+    case COMPILED:
+        Status = Compiled_Init(Actor);
+        break;
+    case BITSET:
+        Bitset = malloc(sizeof(struct Bitset));
+        if (Bitset == NULL)
+        {
+            return GST_FAILURE;
+        }
+        Status = Bitset_Init(Actor, Bitset, rules);
+        break;
+    case GRUNDY:
+        Grundy = malloc(sizeof(struct Grundy));
+        if (Grundy == NULL)
+        {
+            return GST_FAILURE;
+        }
+        Status = Grundy_Init(Actor, Grundy, rules);
+        break;
+    case ALPHABETA:
+        AlphaBeta = malloc(sizeof(struct AlphaBeta));
+        if (AlphaBeta == NULL)
+        {
+            return GST_FAILURE;
+        }
+        Status = AlphaBeta_Init(Actor, AlphaBeta, (Config->Budget != 0U) ? Config->Budget : ALPHABETA_BUDGET_US);
+        break;
+    case MCTS:
+        Mcts = malloc(sizeof(struct Mcts));
+        if (Mcts == NULL)
+        {
+            return GST_FAILURE;
+        }
+        // Without a count or a budget, MCTS_ITERATIONS playouts are run
+        Status = Mcts_Init(Actor, Mcts, Config->Iterations, Config->Budget,
+            (Config->Threads != 0U) ? Config->Threads : MCTS_THREADS, Config->Seed);
+        break;
+    default:
+        return GST_FAILURE;
+    }
+
+    if (Status != GST_SUCCESS)
+    {
+        Actors_Destroy(Actor);
+    }
+
+    return Status;
+};
+
+/**
+ * @brief 
+ * Checks if an Actor of a type can play games with the passed in 
+ * rules. Players that rely on a property of the normal game, like 
+ * the closed form or the bitset solve, can't play every variant.
+ * 
+ * @param Type Any of the player types in parameters.h.
+ * @param rules The rules of the games to play.
+ * @return GStatus GST_SUCCESS if the type can play the rules, GST_FAILURE otherwise.
+ */
+GStatus Actors_Supports(uint8_t Type, rules_t rules)
+{
+    switch (Type)
+    {
+    case CLOSED_FORM:
+        // The closed form only holds for ranges of moves
+        return ClosedForm_Supports(rules);
+    case COMPILED:
+        // The policy was generated for the rules in parameters.h
+        return Compiled_Supports(rules);
+    case BITSET:
+        return (rules->Ending != GAME_END_MISERE) ? GST_SUCCESS : GST_FAILURE;
+    case GRUNDY:
+        // Grundy values only add up for the normal ending
+        return (rules->Ending == GAME_END_NORMAL) ? GST_SUCCESS : GST_FAILURE;
+    default:
+        return (Type < PLAYER_TYPES) ? GST_SUCCESS : GST_FAILURE;
+    }
+};
+
+/**
+ * @brief Releases everything Actors_Create allocated for an Actor.
+ * 
+ * @param Actor The actor to release.
+ * @return GStatus The success of the release.
+ */
+GStatus Actors_Destroy(Actor_t Actor)
+{
+    dynamic_t Dynamic;
+
+    switch (Actor->Type)
+    {
+    case USER:
+        if (Actor->ActorBase != NULL)
+        {
+            Player_Free((player_t) Actor->ActorBase);
+        }
+        break;
+    case DYNAMIC:
+    case DYNAMIC_TABLE:
+        Dynamic = (dynamic_t) Actor->ActorBase;
+        if (Dynamic != NULL)
+        {
+            if (Dynamic->table != NULL && !Dynamic->table->Shared)
+            {
+                TTable_Free(Dynamic->table);
+                free(Dynamic->table);
+            }
+            Dynamic_Free(Dynamic);
+        }
+        break;
+    case TABLEBASE:
+        if (Actor->ActorBase != NULL)
+        {
+            Tablebase_Close((tablebase_t) Actor->ActorBase);
+        }
+        break;
+    case BITSET:
+        if (Actor->ActorBase != NULL)
+        {
+            Bitset_Free((bitset_t) Actor->ActorBase);
+        }
+        break;
+    case GRUNDY:
+        if (Actor->ActorBase != NULL)
+        {
+            Grundy_Free((grundy_t) Actor->ActorBase);
+        }
+        break;
+    case ALPHABETA:
+        if (Actor->ActorBase != NULL)
+        {
+            AlphaBeta_Free((alphabeta_t) Actor->ActorBase);
+        }
+        break;
+    case MCTS:
+        if (Actor->ActorBase != NULL)
+        {
+            Mcts_Free((mcts_t) Actor->ActorBase);
+        }
+        break;
+    default:
+        break;
+    }
+    free(Actor->ActorBase);
+    Actor->ActorBase = NULL;
+
+    return GST_SUCCESS;
+};
+
+/**
+ * @brief 
+ * Restarts the random number generator of an Actor, so the games it 
+ * plays don't depend on what it played before. Does nothing for 
+ * Actors that don't use randomness.
+ * 
+ * @param Actor The actor to reseed.
+ * @param Seed The new seed.
+ * @return GStatus The success of the reseed.
+ */
+GStatus Actors_Reseed(Actor_t Actor, uint64_t Seed)
+{
+    if (Actor->Type == RANDOM)
+    {
+        Random_Init(Actor, (random_t) Actor->ActorBase, Seed);
+    }
+    else if (Actor->Type == MCTS)
+    {
+        Mcts_Reseed((mcts_t) Actor->ActorBase, Seed);
+    }
+
+    return GST_SUCCESS;
+};
+
+/**
+ * @brief Finds the player type with the passed in name.
+ * 
+ * @param Name The name of the player type, as returned by Actors_Name.
+ * @param Type Pointer to a uint. Actors_Parse stores the type here.
+ * @return GStatus GST_SUCCESS if the name is known, GST_FAILURE otherwise.
+ */
+GStatus Actors_Parse(const char *Name, uint8_t *Type)
+{
+    uint8_t i;
+    for (i = 0U; i < ACTOR_TYPES; i++)
+    {
+        if (ActorNames[i] != NULL && strcmp(Name, ActorNames[i]) == 0)
+        {
+            *Type = i;
+            return GST_SUCCESS;
+        }
+    }
+
+    return GST_FAILURE;
+};
+
+/**
+ * @brief Gets the name of a player type.
+ * 
+ * @param Type The player type.
+ * @return const char* The name of the type, "unknown" if there is none.
+ */
+const char *Actors_Name(uint8_t Type)
+{
+    if (Type >= ACTOR_TYPES || ActorNames[Type] == NULL)
+    {
+        return "unknown";
+    }
+
+    return ActorNames[Type];
+};
+
+/*** end of file ***/
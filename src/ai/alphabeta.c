@@ -0,0 +1,603 @@
+/** @file alphabeta.c
+ * 
+ * @brief 
+ * A depth limited negamax search with alpha-beta pruning, for games too
+ * large to solve exactly. The search deepens one ply at a time until
+ * the per-move time budget runs out, and plays the best move of the
+ * deepest search it finished.
+ *
+ * @par       
+ * COPYRIGHT NOTICE: (c) 2021 Graham Power.  All rights reserved.
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */ 
+
+#include "alphabeta.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "clock.h"
+
+/************************** Constant Definitions *****************************/
+
+// Bounds stored in the Flags of a ttdata.
+#define ALPHABETA_EXACT         1U
+#define ALPHABETA_LOWER         2U  // The state scores at least the stored value
+#define ALPHABETA_UPPER         3U  // The state scores at most the stored value
+
+// Scores beyond this are known wins or losses, not estimates.
+#define ALPHABETA_KNOWN         (ALPHABETA_WIN - (int32_t) ALPHABETA_MAX_DEPTH - 1)
+
+// The largest games AlphaBeta_Verify searches exhaustively.
+#define ALPHABETA_VERIFY_COUNTERS   3U
+#define ALPHABETA_VERIFY_TARGET     8U
+#define ALPHABETA_VERIFY_MOVES      3U
+
+/**************************** Type Definitions *******************************/
+
+/************************** Function Prototypes ******************************/
+
+static int32_t AlphaBeta_Negamax(alphabeta_t AlphaBeta, uint32_t Depth, uint32_t Ply, int32_t Alpha, int32_t Beta, uint64_t Key);
+static int32_t AlphaBeta_Child(alphabeta_t AlphaBeta, uint32_t Counter, uint64_t Advancement, uint32_t Depth, uint32_t Ply, int32_t Alpha, int32_t Beta, uint64_t Key);
+static uint8_t AlphaBeta_Terminal(alphabeta_t AlphaBeta, uint32_t Ply, int32_t *Score);
+static uint64_t AlphaBeta_CounterKey(rules_t rules, uint64_t Score);
+
+/************************** Function Definitions *****************************/
+
+/**
+ * @brief 
+ * Initializes an alpha-beta controller Actor. The transposition table 
+ * is allocated here, and kept across moves, so every search starts 
+ * from the bounds and best moves of the ones before it.
+ * 
+ * @param Actor The actor who will use AlphaBeta_Act to advance a game state. 
+ * @param AlphaBeta The pointer to the alphabeta struct, used as a class-like representation.
+ * @param Budget The microseconds every move may take, ALPHABETA_NO_DEADLINE to always search to the end.
+ * @return GStatus GST_FAILURE if the table could not be allocated, GST_SUCCESS otherwise.
+ */
+GStatus AlphaBeta_Init(Actor_t Actor, alphabeta_t AlphaBeta, uint64_t Budget)
+{
+    Actor->Type = ALPHABETA;
+    Actor->Action = AlphaBeta_Act;
+    Actor->Choose = AlphaBeta_Choose;
+    Actor->ActorBase = AlphaBeta;
+
+    memset(AlphaBeta, 0, sizeof(*AlphaBeta));
+    AlphaBeta->Budget = Budget;
+
+    return TTable_Init(&AlphaBeta->Table, ALPHABETA_TTABLE_CAPACITY);
+};
+
+/**
+ * @brief Releases the storage allocated by AlphaBeta_Init and AlphaBeta_Search.
+ * 
+ * @param AlphaBeta The pointer to the alphabeta struct to release.
+ * @return GStatus The success of the release.
+ */
+GStatus AlphaBeta_Free(alphabeta_t AlphaBeta)
+{
+    TTable_Free(&AlphaBeta->Table);
+    free(AlphaBeta->Scores);
+    free(AlphaBeta->Root);
+    AlphaBeta->Scores = NULL;
+    AlphaBeta->Root = NULL;
+    AlphaBeta->Counters = 0U;
+    AlphaBeta->RootCapacity = 0U;
+
+    return GST_SUCCESS;
+};
+
+/**
+ * @brief 
+ * Takes an action of behalf of the Actor that called it, playing 
+ * the best move the search found in its budget.
+ * 
+ * @param game The game to take the action in.
+ * @param ActorBase The Actors base structure, an AlphaBeta structure.
+ * @return GStatus The success of the action.
+ */
+GStatus AlphaBeta_Act(game_t game, void *ActorBase)
+{
+    alphabeta_t AlphaBeta = (alphabeta_t) ActorBase;
+    uint32_t Counter = 0U;
+    uint64_t Advancement = 1U;
+    int32_t Score;
+    AlphaBeta_Search(AlphaBeta, game, &Counter, &Advancement, &Score);
+
+    if (game->Counters > 1U)
+    {
+        LOG_PRINTF(LOG_INFO, "AlphaBeta AI Adds: %" PRIu64 " To Counter %" PRIu32 "\n", Advancement, Counter + 1U);
+    }
+    else
+    {
+        LOG_PRINTF(LOG_INFO, "AlphaBeta AI Adds: %" PRIu64 "\n", Advancement);
+    }
+    if (LOG_ENABLED(LOG_DEBUG))
+    {
+        Dynamic_PrintStats("Move", &AlphaBeta->MoveStats);
+    }
+
+    return Game_AdvanceCounter(game, Counter, Advancement);
+};
+
+/**
+ * @brief 
+ * Calculates the move the Actor would take, without taking it. 
+ * Only games on one counter can be answered, since the advancement 
+ * alone doesn't say which counter it is for.
+ * 
+ * @param game The game to calculate the move in.
+ * @param ActorBase The Actors base structure, an AlphaBeta structure.
+ * @param Advancement Pointer to a uint. AlphaBeta_Choose stores the action to take here.
+ * @return GStatus GST_INVALID_STATE for games on many counters, the success of the search otherwise.
+ */
+GStatus AlphaBeta_Choose(game_t game, void *ActorBase, uint64_t *Advancement)
+{
+    uint32_t Counter;
+    int32_t Score;
+
+    if (game->Counters != 1U)
+    {
+        *Advancement = 1U;
+        return GST_INVALID_STATE;
+    }
+
+    return AlphaBeta_Search((alphabeta_t) ActorBase, game, &Counter, Advancement, &Score);
+};
+
+/**
+ * @brief 
+ * Searches a game to a depth of 1, then 2, and so on, until the 
+ * budget runs out, the result is known, or ALPHABETA_MAX_DEPTH is 
+ * reached. Each search tries the moves from the state searched in 
+ * the order the last one scored them, and the best move the table 
+ * holds first everywhere below it, so most of the tree is cut off 
+ * by the bounds of the first move tried.
+ * 
+ * The clock is read every ALPHABETA_CHECK_NODES nodes. A search cut 
+ * short by the deadline is thrown away, except for the moves it 
+ * finished: they include the best move of the last search, so the 
+ * best of them is at least as good a pick.
+ * 
+ * @param AlphaBeta The pointer to the initialized alphabeta struct.
+ * @param game The game to pick the move in.
+ * @param Counter Pointer to a uint. AlphaBeta_Search stores the counter to advance here.
+ * @param Advancement Pointer to a uint. AlphaBeta_Search stores the advancement here.
+ * @param Score 
+ * Pointer to an int. AlphaBeta_Search stores the score of the move 
+ * for the player to move here, see ALPHABETA_WIN.
+ * @return GStatus GST_INVALID_STATE if there is no move, GST_FAILURE if the storage could not be allocated, GST_SUCCESS otherwise.
+ */
+GStatus AlphaBeta_Search(alphabeta_t AlphaBeta, game_t game, uint32_t *Counter, uint64_t *Advancement, int32_t *Score)
+{
+    rules_t rules = game->Rules;
+    struct alphabeta_move *Root;
+    struct alphabeta_move move;
+    uint64_t Key = 0U;
+    uint64_t Sum = 0U;
+    uint64_t Count = 0U;
+    uint64_t legal;
+    uint64_t start;
+    uint64_t i;
+    uint64_t j;
+    uint64_t best;
+    uint64_t done;
+    int32_t alpha;
+    int32_t value;
+    uint32_t Depth;
+    uint32_t c;
+
+    *Counter = 0U;
+    *Advancement = RULES_MOVE(rules, 0U);
+    *Score = 0;
+
+    if (AlphaBeta->Counters != game->Counters || AlphaBeta->RootCapacity < game->Counters*RULES_MOVE_COUNT(rules))
+    {
+        free(AlphaBeta->Scores);
+        free(AlphaBeta->Root);
+        AlphaBeta->Counters = 0U;
+        AlphaBeta->RootCapacity = 0U;
+        AlphaBeta->Scores = malloc(game->Counters*sizeof(uint64_t));
+        AlphaBeta->Root = malloc(game->Counters*RULES_MOVE_COUNT(rules)*sizeof(struct alphabeta_move));
+        if (AlphaBeta->Scores == NULL || AlphaBeta->Root == NULL)
+        {
+            return GST_FAILURE;
+        }
+        AlphaBeta->Counters = game->Counters;
+        AlphaBeta->RootCapacity = game->Counters*RULES_MOVE_COUNT(rules);
+    }
+    AlphaBeta->Rules = rules;
+    Root = AlphaBeta->Root;
+
+    for (c = 0U; c < game->Counters; c++)
+    {
+        AlphaBeta->Scores[c] = GAME_COUNTER(game, c);
+        Sum += AlphaBeta->Scores[c];
+        Key += AlphaBeta_CounterKey(rules, AlphaBeta->Scores[c]);
+    }
+
+    // Counters only grow during a game, so a sum that didn't is a new game
+    if (Sum <= AlphaBeta->LastSum)
+    {
+        memset(&AlphaBeta->GameStats, 0, sizeof(AlphaBeta->GameStats));
+    }
+    AlphaBeta->LastSum = Sum;
+    memset(&AlphaBeta->MoveStats, 0, sizeof(AlphaBeta->MoveStats));
+    AlphaBeta->MoveStats.Calls = 1U;
+    start = Clock_Nanoseconds();
+    AlphaBeta->MoveStats.Nanoseconds = start;
+    AlphaBeta->Deadline = (AlphaBeta->Budget >= (UINT64_MAX - start) / 1000U) ? UINT64_MAX : start + AlphaBeta->Budget*1000U;
+    AlphaBeta->TimedOut = 0U;
+
+    for (c = 0U; c < game->Counters; c++)
+    {
+        legal = Game_LegalMoves(rules, rules->Target - AlphaBeta->Scores[c]);
+        for (i = 0U; i < legal && !Game_IsRepeated(AlphaBeta->Scores, c); i++)
+        {
+            Root[Count].Counter = c;
+            Root[Count].Advancement = RULES_MOVE(rules, i);
+            Root[Count].Score = 0;
+            Count++;
+        }
+    }
+    if (Count == 0U || AlphaBeta_Terminal(AlphaBeta, 0U, &value))
+    {
+        return GST_INVALID_STATE;
+    }
+    *Counter = Root[0].Counter;
+    *Advancement = Root[0].Advancement;
+
+    for (Depth = 1U; Depth <= ALPHABETA_MAX_DEPTH && !AlphaBeta->TimedOut; Depth++)
+    {
+        alpha = -ALPHABETA_INFINITY;
+        best = 0U;
+        for (done = 0U; done < Count; done++)
+        {
+            value = AlphaBeta_Child(AlphaBeta, Root[done].Counter, Root[done].Advancement, Depth - 1U, 1U, alpha, ALPHABETA_INFINITY, Key);
+            if (AlphaBeta->TimedOut)
+            {
+                break;
+            }
+            // Moves after the best only have bounds, which are still good enough to order by
+            Root[done].Score = value;
+            if (value > alpha)
+            {
+                alpha = value;
+                best = done;
+            }
+        }
+        if (done == 0U)
+        {
+            break;
+        }
+
+        *Counter = Root[best].Counter;
+        *Advancement = Root[best].Advancement;
+        *Score = alpha;
+        if (done < Count)
+        {
+            break;
+        }
+        AlphaBeta->MoveStats.MaxDepth = Depth;
+
+        // Stable insertion sort, best first, so ties keep the order they were found in
+        for (i = 1U; i < Count; i++)
+        {
+            move = Root[i];
+            for (j = i; j > 0U && Root[j - 1U].Score < move.Score; j--)
+            {
+                Root[j] = Root[j - 1U];
+            }
+            Root[j] = move;
+        }
+
+        // Every line ended inside the search, so deeper ones find the same
+        if (alpha > ALPHABETA_KNOWN || alpha < -ALPHABETA_KNOWN)
+        {
+            break;
+        }
+    }
+
+    AlphaBeta->MoveStats.Nanoseconds = Clock_Nanoseconds() - start;
+    Dynamic_AddStats(&AlphaBeta->GameStats, &AlphaBeta->MoveStats);
+
+    return GST_SUCCESS;
+};
+
+/**
+ * @brief 
+ * Checks AlphaBeta_Search, with no deadline, against an exhaustive 
+ * search over every ordering of the scores. The sign of the score 
+ * has to say whether the state is won, and in won states the move 
+ * picked has to lead to a lost one. Checked for every ending, up to 
+ * ALPHABETA_VERIFY_COUNTERS counters, and games capped to keep the 
+ * search small.
+ * 
+ * @param maxTarget The largest target to check.
+ * @param maxAdvancement The largest range of moves to check.
+ * @param Mismatches Pointer to a uint. AlphaBeta_Verify stores the number of disagreements here.
+ * @return GStatus GST_SUCCESS if every position agrees and the storage was allocated, GST_FAILURE otherwise.
+ */
+GStatus AlphaBeta_Verify(uint64_t maxTarget, uint64_t maxAdvancement, uint64_t *Mismatches)
+{
+    struct AlphaBeta AlphaBeta;
+    struct Actor Actor;
+    struct rules rules;
+    struct game game;
+    uint64_t States[ALPHABETA_VERIFY_COUNTERS];
+    uint64_t Child[ALPHABETA_VERIFY_COUNTERS];
+    uint64_t Checked = 0U;
+    uint64_t Product;
+    uint64_t Index;
+    uint64_t place;
+    uint64_t rest;
+    uint64_t target;
+    uint64_t k;
+    uint64_t p;
+    int8_t *Won;
+    uint32_t counters;
+    uint32_t Counter;
+    uint32_t i;
+    uint64_t Advancement;
+    int32_t Score;
+    uint8_t ending;
+    uint8_t won;
+    GStatus Status = GST_SUCCESS;
+
+    maxTarget = (maxTarget < ALPHABETA_VERIFY_TARGET) ? maxTarget : ALPHABETA_VERIFY_TARGET;
+    maxAdvancement = (maxAdvancement < ALPHABETA_VERIFY_MOVES) ? maxAdvancement : ALPHABETA_VERIFY_MOVES;
+    *Mismatches = 0U;
+
+    if (AlphaBeta_Init(&Actor, &AlphaBeta, ALPHABETA_NO_DEADLINE) != GST_SUCCESS)
+    {
+        AlphaBeta_Free(&AlphaBeta);
+        return GST_FAILURE;
+    }
+
+    for (ending = GAME_END_NORMAL; ending <= GAME_END_FIRST && Status == GST_SUCCESS; ending++)
+    for (counters = 1U; counters <= ALPHABETA_VERIFY_COUNTERS && Status == GST_SUCCESS; counters++)
+    for (target = 1U; target <= maxTarget && Status == GST_SUCCESS; target++)
+    for (k = 1U; k <= maxAdvancement && Status == GST_SUCCESS; k++)
+    {
+        Game_InitRules(&rules, target, k);
+        rules.Ending = ending;
+        // Every game starts from an empty table, so no game is checked against the entries of another
+        TTable_Clear(&AlphaBeta.Table);
+
+        for (Product = 1U, i = 0U; i < counters; i++)
+        {
+            Product *= target + 1U;
+        }
+        Won = malloc(Product*sizeof(int8_t));
+        if (Won == NULL)
+        {
+            Status = GST_FAILURE;
+            break;
+        }
+        memset(Won, -1, Product*sizeof(int8_t));
+
+        memset(&game, 0, sizeof(game));
+        game.Rules = &rules;
+        game.States = States;
+        game.Counters = counters;
+        for (p = 0U; p < Product; p++)
+        {
+            for (rest = p, i = 0U; i < counters; i++)
+            {
+                States[i] = rest % (target + 1U);
+                rest /= target + 1U;
+            }
+            won = Game_Search(&rules, counters, States, Won, p);
+            if (AlphaBeta_Search(&AlphaBeta, &game, &Counter, &Advancement, &Score) != GST_SUCCESS)
+            {
+                // Finished games have no move to check
+                continue;
+            }
+            Checked++;
+
+            for (place = 1U, i = 0U; i < Counter; i++)
+            {
+                place *= target + 1U;
+            }
+            memcpy(Child, States, counters*sizeof(uint64_t));
+            Child[Counter] += Advancement;
+            Index = p + Advancement*place;
+            if ((Score > 0) != (won == 1U) || (won && Game_Search(&rules, counters, Child, Won, Index)))
+            {
+                (*Mismatches)++;
+            }
+        }
+        free(Won);
+    }
+
+    AlphaBeta_Free(&AlphaBeta);
+    printf("Verified %" PRIu64 " alphabeta positions, %" PRIu64 " mismatches\n", Checked, *Mismatches);
+
+    return (Status == GST_SUCCESS && *Mismatches == 0U) ? GST_SUCCESS : GST_FAILURE;
+};
+
+/**
+ * @brief 
+ * Scores the state in AlphaBeta->Scores for the player to move, 
+ * looking Depth plies ahead. Returns a score within Alpha and Beta 
+ * exactly, otherwise a bound on the side it fell outside of. Key is 
+ * the sum of the keys of the counters, so states that only differ in 
+ * the order of their counters share entries.
+ */
+static int32_t AlphaBeta_Negamax(alphabeta_t AlphaBeta, uint32_t Depth, uint32_t Ply, int32_t Alpha, int32_t Beta, uint64_t Key)
+{
+    rules_t rules = AlphaBeta->Rules;
+    struct dynamic_stats *Stats = &AlphaBeta->MoveStats;
+    struct ttdata data;
+    int32_t original = Alpha;
+    int32_t best = -ALPHABETA_INFINITY;
+    int32_t value;
+    uint64_t moveCount = RULES_MOVE_COUNT(rules);
+    uint64_t hashMove = 0U;
+    uint64_t bestMove = 0U;
+    uint64_t legal;
+    uint64_t i;
+    uint32_t c;
+    uint8_t found;
+
+    Stats->Nodes++;
+    if ((Stats->Nodes % ALPHABETA_CHECK_NODES) == 0U && Clock_Nanoseconds() >= AlphaBeta->Deadline)
+    {
+        AlphaBeta->TimedOut = 1U;
+    }
+    if (AlphaBeta->TimedOut)
+    {
+        return 0;
+    }
+
+    if (AlphaBeta_Terminal(AlphaBeta, Ply, &value))
+    {
+        Stats->Terminals++;
+        return value;
+    }
+    if (Depth == 0U)
+    {
+        return 0;
+    }
+
+    Key = (Key == 0U) ? 1U : Key;
+    Stats->Probes++;
+    found = (TTable_Probe(&AlphaBeta->Table, Key, &data) == GST_SUCCESS);
+    if (found)
+    {
+        Stats->Hits++;
+        hashMove = data.Move;
+        value = data.Value.Score;
+        // Known results are stored from the state they belong to, and scored from the root here
+        value = (value > ALPHABETA_KNOWN) ? value - (int32_t) Ply : (value < -ALPHABETA_KNOWN) ? value + (int32_t) Ply : value;
+        if (data.Depth >= Depth &&
+            (data.Flags == ALPHABETA_EXACT ||
+            (data.Flags == ALPHABETA_LOWER && value >= Beta) ||
+            (data.Flags == ALPHABETA_UPPER && value <= Alpha)))
+        {
+            return value;
+        }
+    }
+    else
+    {
+        Stats->Misses++;
+    }
+
+    // The best move of an earlier search goes first, it is stored as its index plus 1
+    if (hashMove != 0U)
+    {
+        c = (uint32_t) ((hashMove - 1U) / moveCount);
+        i = (hashMove - 1U) % moveCount;
+        if (c < AlphaBeta->Counters && i < Game_LegalMoves(rules, rules->Target - AlphaBeta->Scores[c]))
+        {
+            best = AlphaBeta_Child(AlphaBeta, c, RULES_MOVE(rules, i), Depth - 1U, Ply + 1U, Alpha, Beta, Key);
+            bestMove = hashMove;
+            Alpha = (best > Alpha) ? best : Alpha;
+        }
+        else
+        {
+            hashMove = 0U;
+        }
+    }
+
+    for (c = 0U; c < AlphaBeta->Counters && Alpha < Beta && !AlphaBeta->TimedOut; c++)
+    {
+        if (Game_IsRepeated(AlphaBeta->Scores, c))
+        {
+            continue;
+        }
+        legal = Game_LegalMoves(rules, rules->Target - AlphaBeta->Scores[c]);
+        for (i = 0U; i < legal && Alpha < Beta; i++)
+        {
+            if (c*moveCount + i + 1U == hashMove)
+            {
+                continue;
+            }
+            value = AlphaBeta_Child(AlphaBeta, c, RULES_MOVE(rules, i), Depth - 1U, Ply + 1U, Alpha, Beta, Key);
+            if (AlphaBeta->TimedOut)
+            {
+                return 0;
+            }
+            if (value > best)
+            {
+                best = value;
+                bestMove = c*moveCount + i + 1U;
+                Alpha = (best > Alpha) ? best : Alpha;
+            }
+        }
+    }
+    if (AlphaBeta->TimedOut)
+    {
+        return 0;
+    }
+
+    data.Value.Score = (best > ALPHABETA_KNOWN) ? best + (int32_t) Ply : (best < -ALPHABETA_KNOWN) ? best - (int32_t) Ply : best;
+    data.Move = (bestMove <= UINT16_MAX) ? (uint16_t) bestMove : 0U;
+    data.Depth = (uint8_t) Depth;
+    data.Flags = (best <= original) ? ALPHABETA_UPPER : (best >= Beta) ? ALPHABETA_LOWER : ALPHABETA_EXACT;
+    TTable_Store(&AlphaBeta->Table, Key, &data);
+    Stats->Stores++;
+
+    return best;
+}
+
+/**
+ * @brief 
+ * Scores a move from the state in AlphaBeta->Scores for the player 
+ * making it, within the window Alpha to Beta of that player. The 
+ * move is undone before returning.
+ */
+static int32_t AlphaBeta_Child(alphabeta_t AlphaBeta, uint32_t Counter, uint64_t Advancement, uint32_t Depth, uint32_t Ply, int32_t Alpha, int32_t Beta, uint64_t Key)
+{
+    rules_t rules = AlphaBeta->Rules;
+    uint64_t *Score = &AlphaBeta->Scores[Counter];
+    int32_t value;
+
+    Key -= AlphaBeta_CounterKey(rules, *Score);
+    *Score += Advancement;
+    Key += AlphaBeta_CounterKey(rules, *Score);
+    value = -AlphaBeta_Negamax(AlphaBeta, Depth, Ply, -Beta, -Alpha, Key);
+    *Score -= Advancement;
+
+    return value;
+}
+
+/**
+ * @brief 
+ * Checks if the game is over in the state in AlphaBeta->Scores, 
+ * Ply plies below the state searched, and scores it for the player 
+ * to move if it is.
+ */
+static uint8_t AlphaBeta_Terminal(alphabeta_t AlphaBeta, uint32_t Ply, int32_t *Score)
+{
+    uint8_t moverWins;
+
+    if (!Game_IsOver(AlphaBeta->Rules, AlphaBeta->Scores, AlphaBeta->Counters, &moverWins))
+    {
+        return 0U;
+    }
+
+    *Score = moverWins ? ALPHABETA_WIN - (int32_t) Ply : -(ALPHABETA_WIN - (int32_t) Ply);
+    return 1U;
+}
+
+/**
+ * @brief The key of one counter, the key of a state is the sum of the keys of its counters.
+ */
+static uint64_t AlphaBeta_CounterKey(rules_t rules, uint64_t Score)
+{
+    return TTable_Key(rules, Score, 0U, 0U);
+}
+
+/*** end of file ***/
@@ -0,0 +1,902 @@
+/** @file bitset.c
+ * 
+ * @brief 
+ * A win/loss solver that keeps one bit per position, for games with
+ * any set of allowed moves. Positions are counted by their distance
+ * from the target, and solved 64 at a time with word-wide and SIMD
+ * bit operations.
+ *
+ * @par       
+ * COPYRIGHT NOTICE: (c) 2021 Graham Power.  All rights reserved.
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */ 
+
+#include "bitset.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "dynamic.h"
+#include "closedform.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define BITSET_X86
+#endif
+
+/************************** Constant Definitions *****************************/
+
+// Moves below this are solved one position at a time, within the word
+#define BITSET_NEAR_MOVES       64U
+
+/**************************** Type Definitions *******************************/
+
+// ORs the positions lost after each far move into the BITSET_BLOCK_WORDS
+// words of a block. Far moves reach back past the start of the block, so
+// every word they read is already solved.
+typedef void (*bitset_kernel_t)(const uint64_t *Lost, uint64_t Word, const uint64_t *Far, uint32_t FarCount, uint64_t *Out);
+
+/************************** Function Prototypes ******************************/
+
+static int Bitset_Compare(const void *a, const void *b);
+static uint64_t Bitset_Extract(const uint64_t *Lost, int64_t Offset);
+static int Bitset_SameWindow(bitset_t Bitset, uint64_t a, uint64_t b);
+static void Bitset_KernelScalar(const uint64_t *Lost, uint64_t Word, const uint64_t *Far, uint32_t FarCount, uint64_t *Out);
+#ifdef BITSET_X86
+static void Bitset_KernelSSE2(const uint64_t *Lost, uint64_t Word, const uint64_t *Far, uint32_t FarCount, uint64_t *Out);
+static void Bitset_KernelAVX2(const uint64_t *Lost, uint64_t Word, const uint64_t *Far, uint32_t FarCount, uint64_t *Out);
+#endif
+
+/************************** Function Definitions *****************************/
+
+/**
+ * @brief 
+ * Solves every position from 0 to MaxDistance short of the target, 
+ * for a game where a player can add any of the passed in moves. The 
+ * player who says the target wins, so 0 short of it is lost for the 
+ * player to move, and any other position is lost if every move 
+ * leads to a position won for the opponent.
+ * 
+ * Moves are split by how far they reach back. Moves below 64 are 
+ * applied one position at a time with a register holding the last 
+ * 64 results, so they cost O(1) per position however many there 
+ * are. Longer moves only read words that are already solved, so 
+ * they are ORed in 64 positions at a time, a block of words at once 
+ * by the SIMD kernels.
+ * 
+ * @param Bitset The bitset to fill, released with Bitset_Free.
+ * @param Moves The allowed moves, in any order. 0 and repeats are ignored.
+ * @param MoveCount The number of moves.
+ * @param MaxDistance The furthest position from the target to solve.
+ * @param Kernel Any of the BITSET_KERNEL_ values, falls back to scalar if the CPU lacks it.
+ * @return GStatus GST_FAILURE if there is no move or the bits could not be allocated, GST_SUCCESS otherwise.
+ */
+GStatus Bitset_Solve(bitset_t Bitset, const uint64_t *Moves, uint32_t MoveCount, uint64_t MaxDistance, uint8_t Kernel)
+{
+    bitset_kernel_t kernel = Bitset_KernelScalar;
+    uint64_t nearMask = 0U;
+    uint64_t recent = 0U;
+    uint64_t far[BITSET_BLOCK_WORDS];
+    uint64_t *farMoves;
+    uint64_t *midMoves;
+    uint32_t farCount = 0U;
+    uint32_t midCount = 0U;
+    uint64_t padding;
+    uint64_t words;
+    uint64_t word;
+    uint64_t win;
+    uint64_t lost;
+    uint32_t i;
+    uint32_t j;
+    uint32_t b;
+
+    memset(Bitset, 0, sizeof(*Bitset));
+    if (MoveCount == 0U || MaxDistance >= UINT64_MAX - BITSET_BLOCK_BITS)
+    {
+        return GST_FAILURE;
+    }
+
+    // Sort and deduplicate the moves
+    Bitset->Moves = malloc(MoveCount*sizeof(uint64_t));
+    if (Bitset->Moves == NULL)
+    {
+        return GST_FAILURE;
+    }
+    memcpy(Bitset->Moves, Moves, MoveCount*sizeof(uint64_t));
+    qsort(Bitset->Moves, MoveCount, sizeof(uint64_t), Bitset_Compare);
+    for (i = 0U; i < MoveCount; i++)
+    {
+        if (Bitset->Moves[i] != 0U && (Bitset->MoveCount == 0U || Bitset->Moves[Bitset->MoveCount - 1U] != Bitset->Moves[i]))
+        {
+            Bitset->Moves[Bitset->MoveCount++] = Bitset->Moves[i];
+        }
+    }
+    if (Bitset->MoveCount == 0U || Bitset->Moves[Bitset->MoveCount - 1U] > (uint64_t) INT64_MAX - BITSET_BLOCK_BITS)
+    {
+        Bitset_Free(Bitset);
+        return GST_FAILURE;
+    }
+
+    // Moves past the start of the table land in the padding, which
+    // reads as not lost, so they are never picked
+    padding = Bitset->Moves[Bitset->MoveCount - 1U]/64U + BITSET_BLOCK_WORDS + 1U;
+    words = (MaxDistance/BITSET_BLOCK_BITS + 1U)*BITSET_BLOCK_WORDS;
+    if (padding > SIZE_MAX/sizeof(uint64_t) - words)
+    {
+        Bitset_Free(Bitset);
+        return GST_FAILURE;
+    }
+    Bitset->Words = calloc(padding + words, sizeof(uint64_t));
+    farMoves = malloc(2U*Bitset->MoveCount*sizeof(uint64_t));
+    if (Bitset->Words == NULL || farMoves == NULL)
+    {
+        free(farMoves);
+        Bitset_Free(Bitset);
+        return GST_FAILURE;
+    }
+    Bitset->Lost = Bitset->Words + padding;
+    Bitset->Positions = MaxDistance + 1U;
+    midMoves = farMoves + Bitset->MoveCount;
+
+    for (i = 0U; i < Bitset->MoveCount; i++)
+    {
+        if (Bitset->Moves[i] < BITSET_NEAR_MOVES)
+        {
+            nearMask |= UINT64_C(1) << (Bitset->Moves[i] - 1U);
+        }
+        else if (Bitset->Moves[i] < BITSET_BLOCK_BITS)
+        {
+            midMoves[midCount++] = Bitset->Moves[i];
+        }
+        else
+        {
+            farMoves[farCount++] = Bitset->Moves[i];
+        }
+    }
+
+    Bitset->Kernel = BITSET_KERNEL_SCALAR;
+    #ifdef BITSET_X86
+    if (Kernel == BITSET_KERNEL_AUTO)
+    {
+        Kernel = Bitset_BestKernel();
+    }
+    if (Kernel == BITSET_KERNEL_AVX2 && __builtin_cpu_supports("avx2"))
+    {
+        kernel = Bitset_KernelAVX2;
+        Bitset->Kernel = BITSET_KERNEL_AVX2;
+    }
+    else if (Kernel == BITSET_KERNEL_SSE2 && __builtin_cpu_supports("sse2"))
+    {
+        kernel = Bitset_KernelSSE2;
+        Bitset->Kernel = BITSET_KERNEL_SSE2;
+    }
+    #else
+    (void) Kernel;
+    #endif
+
+    for (word = 0U; word < words; word += BITSET_BLOCK_WORDS)
+    {
+        memset(far, 0, sizeof(far));
+        if (farCount > 0U)
+        {
+            kernel(Bitset->Lost, word, farMoves, farCount, far);
+        }
+
+        for (j = 0U; j < BITSET_BLOCK_WORDS; j++)
+        {
+            win = far[j];
+            for (i = 0U; i < midCount; i++)
+            {
+                win |= Bitset_Extract(Bitset->Lost, (int64_t) (64U*(word + j)) - (int64_t) midMoves[i]);
+            }
+
+            if (nearMask == 0U)
+            {
+                lost = ~win;
+            }
+            else
+            {
+                // Bit i of recent is whether the position i + 1 closer
+                // to the target is lost
+                lost = 0U;
+                for (b = 0U; b < 64U; b++)
+                {
+                    if ((((win >> b) & 1U) == 0U) && (recent & nearMask) == 0U)
+                    {
+                        lost |= UINT64_C(1) << b;
+                        recent = (recent << 1) | 1U;
+                    }
+                    else
+                    {
+                        recent <<= 1;
+                    }
+                }
+            }
+            Bitset->Lost[word + j] = lost;
+        }
+    }
+    free(farMoves);
+
+    return GST_SUCCESS;
+};
+
+/**
+ * @brief Releases the storage allocated by Bitset_Solve.
+ * 
+ * @param Bitset The bitset to release.
+ * @return GStatus The success of the release.
+ */
+GStatus Bitset_Free(bitset_t Bitset)
+{
+    free(Bitset->Words);
+    free(Bitset->Moves);
+    Bitset->Words = NULL;
+    Bitset->Lost = NULL;
+    Bitset->Moves = NULL;
+    Bitset->MoveCount = 0U;
+    Bitset->Positions = 0U;
+    Bitset->PrePeriod = 0U;
+    Bitset->Period = 0U;
+
+    return GST_SUCCESS;
+};
+
+/**
+ * @brief 
+ * Solves like Bitset_Solve, but stops as soon as the positions 
+ * become periodic. The solve starts short and doubles until 
+ * Bitset_FindPeriod finds the period in it, or MaxDistance is 
+ * reached. Any distance, even far past MaxDistance, can then be 
+ * answered by Bitset_IsLost and Bitset_Move in O(1).
+ * 
+ * Whether a position is lost only depends on the positions up to 
+ * the longest move closer to the target. There are finitely many 
+ * of those windows, so the positions always become periodic, 
+ * usually quickly.
+ * 
+ * @param Bitset The bitset to fill, released with Bitset_Free.
+ * @param Moves The allowed moves, in any order. 0 and repeats are ignored.
+ * @param MoveCount The number of moves.
+ * @param MaxDistance The furthest position a full solve goes to, when no period is found before it.
+ * @param Kernel Any of the BITSET_KERNEL_ values.
+ * @return GStatus The success of the solve, a period is found if Bitset->Period isn't 0.
+ */
+GStatus Bitset_SolvePeriodic(bitset_t Bitset, const uint64_t *Moves, uint32_t MoveCount, uint64_t MaxDistance, uint8_t Kernel)
+{
+    uint64_t Distance = BITSET_PERIOD_START;
+    uint64_t longest = 0U;
+    uint32_t i;
+
+    for (i = 0U; i < MoveCount; i++)
+    {
+        longest = (Moves[i] > longest) ? Moves[i] : longest;
+    }
+    // A period has to be seen over a few windows to be found cheaply
+    while (Distance/8U < longest && Distance < MaxDistance)
+    {
+        Distance *= 2U;
+    }
+
+    while (Distance < MaxDistance)
+    {
+        if (Bitset_Solve(Bitset, Moves, MoveCount, Distance, Kernel) != GST_SUCCESS)
+        {
+            return GST_FAILURE;
+        }
+        if (Bitset_FindPeriod(Bitset) == GST_SUCCESS)
+        {
+            return GST_SUCCESS;
+        }
+        Bitset_Free(Bitset);
+        Distance = (Distance > MaxDistance/2U) ? MaxDistance : 2U*Distance;
+    }
+
+    if (Bitset_Solve(Bitset, Moves, MoveCount, MaxDistance, Kernel) != GST_SUCCESS)
+    {
+        return GST_FAILURE;
+    }
+    Bitset_FindPeriod(Bitset);
+
+    return GST_SUCCESS;
+};
+
+/**
+ * @brief 
+ * Looks for the pre-period and period of the solved positions with 
+ * Brent's cycle detection, over the windows of positions that decide 
+ * the next one. Two equal windows mean every position after them is 
+ * equal as well. Each step compares one window, the length of the 
+ * longest move in bits.
+ * 
+ * @param Bitset The solved bitset. PrePeriod and Period are stored in it.
+ * @return GStatus GST_SUCCESS if a period shows up within the solved positions, GST_FAILURE otherwise.
+ */
+GStatus Bitset_FindPeriod(bitset_t Bitset)
+{
+    uint64_t power = 1U;
+    uint64_t period = 1U;
+    uint64_t tortoise = 0U;
+    uint64_t hare = 1U;
+
+    Bitset->PrePeriod = 0U;
+    Bitset->Period = 0U;
+
+    // The window at d is the positions d - longest to d - 1, so the
+    // last whole window starts at Positions
+    while (!Bitset_SameWindow(Bitset, tortoise, hare))
+    {
+        if (hare >= Bitset->Positions)
+        {
+            return GST_FAILURE;
+        }
+        if (power == period)
+        {
+            tortoise = hare;
+            power *= 2U;
+            period = 0U;
+        }
+        hare++;
+        period++;
+    }
+
+    // The first window that repeats, period positions later
+    tortoise = 0U;
+    hare = period;
+    while (!Bitset_SameWindow(Bitset, tortoise, hare))
+    {
+        tortoise++;
+        hare++;
+    }
+
+    Bitset->PrePeriod = tortoise;
+    Bitset->Period = period;
+
+    return GST_SUCCESS;
+};
+
+/**
+ * @brief 
+ * Checks if a position is lost for the player to move. Positions 
+ * past the solved ones are folded into the period.
+ * 
+ * @param Bitset The solved bitset.
+ * @param Distance How far the position is from the target.
+ * @return uint8_t 1 if the position is lost, 0 if it is won or wasn't solved.
+ */
+uint8_t Bitset_IsLost(bitset_t Bitset, uint64_t Distance)
+{
+    if (Distance >= Bitset->Positions)
+    {
+        if (Bitset->Period == 0U)
+        {
+            return 0U;
+        }
+        Distance = Bitset->PrePeriod + (Distance - Bitset->PrePeriod) % Bitset->Period;
+    }
+
+    return (uint8_t) BITSET_IS_LOST(Bitset, Distance);
+};
+
+/**
+ * @brief 
+ * Picks the move to take from a position. The smallest move that 
+ * leaves the opponent in a lost position, or the smallest legal 
+ * move if there is none.
+ * 
+ * @param Bitset The solved bitset.
+ * @param Distance How far the position is from the target.
+ * @param Advancement Pointer to a uint. Bitset_Move stores the move here.
+ * @return GStatus GST_INVALID_STATE if the position wasn't solved or covered by a period, GST_FAILURE if it is lost, GST_SUCCESS otherwise.
+ */
+GStatus Bitset_Move(bitset_t Bitset, uint64_t Distance, uint64_t *Advancement)
+{
+    uint32_t i;
+
+    *Advancement = Bitset->Moves[0];
+    if (Distance >= Bitset->Positions && Bitset->Period == 0U)
+    {
+        return GST_INVALID_STATE;
+    }
+
+    for (i = 0U; i < Bitset->MoveCount && Bitset->Moves[i] <= Distance; i++)
+    {
+        if (Bitset_IsLost(Bitset, Distance - Bitset->Moves[i]))
+        {
+            *Advancement = Bitset->Moves[i];
+            return GST_SUCCESS;
+        }
+    }
+
+    return GST_FAILURE;
+};
+
+/**
+ * @brief 
+ * Initializes a bitset controller Actor. Positions of games with 
+ * the passed in rules are solved here, until the target or until 
+ * they become periodic, so each move afterwards is a few bit lookups.
+ * 
+ * @param Actor The actor who will use Bitset_Act to advance a game state. 
+ * @param Bitset The pointer to the bitset struct, used as a class-like representation.
+ * @param rules The rules of the games this instance will play.
+ * @return GStatus The success of the solve.
+ */
+GStatus Bitset_Init(Actor_t Actor, bitset_t Bitset, rules_t rules)
+{
+    uint64_t *Moves;
+    uint64_t i;
+    GStatus Status;
+
+    Actor->Type = BITSET;
+    Actor->Action = Bitset_Act;
+    Actor->Choose = Bitset_Choose;
+    Actor->ActorBase = Bitset;
+
+    memset(Bitset, 0, sizeof(*Bitset));
+    // The solve scores a player who can't move as lost
+    if (RULES_MOVE_COUNT(rules) > UINT32_MAX || rules->Ending == GAME_END_MISERE)
+    {
+        return GST_FAILURE;
+    }
+    Moves = malloc(RULES_MOVE_COUNT(rules)*sizeof(uint64_t));
+    if (Moves == NULL)
+    {
+        return GST_FAILURE;
+    }
+    for (i = 0U; i < RULES_MOVE_COUNT(rules); i++)
+    {
+        Moves[i] = RULES_MOVE(rules, i);
+    }
+    Status = Bitset_SolvePeriodic(Bitset, Moves, (uint32_t) RULES_MOVE_COUNT(rules), rules->Target, BITSET_KERNEL_AUTO);
+    free(Moves);
+
+    LOG_PRINTF(LOG_DEBUG, "Bitset solved %" PRIu64 " positions, pre-period %" PRIu64 ", period %" PRIu64 "\n",
+        Bitset->Positions, Bitset->PrePeriod, Bitset->Period);
+
+    return Status;
+};
+
+/**
+ * @brief 
+ * Takes an action of behalf of the Actor that called it, playing 
+ * the move picked by Bitset_Move.
+ * 
+ * @param game The game to take the action in.
+ * @param ActorBase The Actors base structure, a Bitset structure.
+ * @return GStatus The success of the action.
+ */
+GStatus Bitset_Act(game_t game, void *ActorBase)
+{
+    uint64_t Advancement = 1U;
+    Bitset_Choose(game, ActorBase, &Advancement);
+
+    LOG_PRINTF(LOG_INFO, "Bitset AI Adds: %" PRIu64 "\n", Advancement);
+
+    return Game_AdvanceState(game, Advancement);
+};
+
+/**
+ * @brief 
+ * Calculates the move the Actor would take, without taking it.
+ * 
+ * @param game The game to calculate the move in.
+ * @param ActorBase The Actors base structure, a Bitset structure.
+ * @param Advancement Pointer to a uint. Bitset_Choose stores the action to take here.
+ * @return GStatus GST_INVALID_STATE if the game wasn't solved, GST_SUCCESS otherwise.
+ */
+GStatus Bitset_Choose(game_t game, void *ActorBase, uint64_t *Advancement)
+{
+    bitset_t Bitset = (bitset_t) ActorBase;
+    rules_t rules = game->Rules;
+
+    // The moves were solved for the moves of the rules
+    if (rules->Ending == GAME_END_MISERE || Bitset->MoveCount != RULES_MOVE_COUNT(rules) || Bitset->Moves[Bitset->MoveCount - 1U] != rules->MaxAdvancement ||
+        (rules->Moves != NULL && memcmp(Bitset->Moves, rules->Moves, Bitset->MoveCount*sizeof(uint64_t)) != 0))
+    {
+        *Advancement = 1U;
+        return GST_INVALID_STATE;
+    }
+
+    return (Bitset_Move(Bitset, game->Rules->Target - game->State, Advancement) == GST_INVALID_STATE) ? GST_INVALID_STATE : GST_SUCCESS;
+};
+
+/**
+ * @brief Gets the fastest kernel the CPU supports.
+ * 
+ * @return uint8_t Any of the BITSET_KERNEL_ values but auto.
+ */
+uint8_t Bitset_BestKernel(void)
+{
+    #ifdef BITSET_X86
+    if (__builtin_cpu_supports("avx2"))
+    {
+        return BITSET_KERNEL_AVX2;
+    }
+    if (__builtin_cpu_supports("sse2"))
+    {
+        return BITSET_KERNEL_SSE2;
+    }
+    #endif
+
+    return BITSET_KERNEL_SCALAR;
+};
+
+/**
+ * @brief Gets the name of a kernel.
+ * 
+ * @param Kernel Any of the BITSET_KERNEL_ values.
+ * @return const char* The name of the kernel.
+ */
+const char *Bitset_KernelName(uint8_t Kernel)
+{
+    static const char *const Names[BITSET_KERNELS] = { "auto", "scalar", "sse2", "avx2" };
+
+    return (Kernel < BITSET_KERNELS) ? Names[Kernel] : "unknown";
+};
+
+/**
+ * @brief 
+ * Checks the bitset solver with every kernel the CPU supports. For 
+ * every target up to maxTarget and max advancement up to 
+ * maxAdvancement, it has to agree with the table solver of the 
+ * Dynamic Programming player on whether the player to move wins, and 
+ * its move has to leave the opponent lost when they do. A few sparse 
+ * move sets, with moves in every class, are checked against a plain 
+ * position by position solve.
+ * 
+ * @param maxTarget The largest target in the sweep.
+ * @param maxAdvancement The largest max advancement in the sweep.
+ * @param Mismatches Pointer to a uint. Bitset_Verify stores the number of disagreements here.
+ * @return GStatus GST_SUCCESS if every position agrees, GST_FAILURE otherwise.
+ */
+GStatus Bitset_Verify(uint64_t maxTarget, uint64_t maxAdvancement, uint64_t *Mismatches)
+{
+    static const uint64_t Sparse[][6] = {
+        { 1U, 3U, 7U },
+        { 2U, 5U, 64U, 65U, 300U },
+        { 1U, 63U, 129U, 256U, 257U, 1000U },
+    };
+    static const uint32_t SparseCounts[] = { 3U, 5U, 6U };
+    struct rules rules;
+    struct rules Explicit;
+    struct Dynamic Dynamic;
+    struct Dynamic Generic;
+    struct Actor Actor;
+    struct Bitset Bitset;
+    struct Bitset Periodic;
+    const uint64_t *Set;
+    uint32_t SetCount;
+    uint64_t Moves[64];
+    uint64_t Target;
+    uint64_t MaxAdvancement;
+    uint64_t Score;
+    uint64_t Distance;
+    uint64_t Move;
+    uint64_t Expected;
+    uint64_t Checked = 0U;
+    uint8_t *Lost;
+    uint8_t Kernel;
+    uint32_t i;
+    uint32_t s;
+    GStatus Wins;
+
+    *Mismatches = 0U;
+    if (maxAdvancement > sizeof(Moves)/sizeof(Moves[0]))
+    {
+        maxAdvancement = sizeof(Moves)/sizeof(Moves[0]);
+    }
+
+    for (Kernel = BITSET_KERNEL_SCALAR; Kernel <= Bitset_BestKernel(); Kernel++)
+    {
+        for (Target = 1U; Target <= maxTarget; Target++)
+        {
+            for (MaxAdvancement = 1U; MaxAdvancement <= maxAdvancement; MaxAdvancement++)
+            {
+                Game_InitRules(&rules, Target, MaxAdvancement);
+                for (i = 0U; i < MaxAdvancement; i++)
+                {
+                    Moves[i] = i + 1U;
+                }
+                if (Dynamic_InitTable(&Actor, &Dynamic, &rules) != GST_SUCCESS ||
+                    Bitset_Solve(&Bitset, Moves, (uint32_t) MaxAdvancement, Target, Kernel) != GST_SUCCESS)
+                {
+                    Dynamic_Free(&Dynamic);
+                    return GST_FAILURE;
+                }
+
+                for (Score = 0U; Score < Target; Score++)
+                {
+                    Distance = Target - Score;
+                    Wins = Bitset_Move(&Bitset, Distance, &Move);
+                    Checked++;
+                    if ((Wins == GST_SUCCESS) != (Dynamic.Values[2U*Score + 1U] > 0) ||
+                        (Wins == GST_SUCCESS && !BITSET_IS_LOST(&Bitset, Distance - Move)))
+                    {
+                        (*Mismatches)++;
+                        printf("Mismatch: Kernel(%s), Target(%" PRIu64 "), MaxAdvancement(%" PRIu64 "), Score(%" PRIu64 "), Bitset Adds %" PRIu64 ", Dynamic Adds %u\n",
+                            Bitset_KernelName(Kernel), Target, MaxAdvancement, Score, Move, Dynamic.Moves[Score]);
+                    }
+                }
+
+                // The same range as an explicit set of moves takes the
+                // general solve, which has to agree with the range one
+                Explicit = rules;
+                Explicit.Moves = Moves;
+                Explicit.MoveCount = MaxAdvancement;
+                if (Kernel == BITSET_KERNEL_SCALAR)
+                {
+                    if (Dynamic_InitTable(&Actor, &Generic, &Explicit) != GST_SUCCESS)
+                    {
+                        Dynamic_Free(&Generic);
+                        Dynamic_Free(&Dynamic);
+                        Bitset_Free(&Bitset);
+                        return GST_FAILURE;
+                    }
+                    Checked++;
+                    if (memcmp(Generic.Values, Dynamic.Values, 2U*(Target + 1U)*sizeof(int64_t)) != 0 ||
+                        memcmp(Generic.Moves, Dynamic.Moves, (Target + 1U)*sizeof(uint32_t)) != 0)
+                    {
+                        (*Mismatches)++;
+                        printf("Mismatch: Range solve, Target(%" PRIu64 "), MaxAdvancement(%" PRIu64 ")\n", Target, MaxAdvancement);
+                    }
+                    Dynamic_Free(&Generic);
+                }
+
+                Bitset_Free(&Bitset);
+                Dynamic_Free(&Dynamic);
+            }
+        }
+
+        for (s = 0U; s < sizeof(SparseCounts)/sizeof(SparseCounts[0]); s++)
+        {
+            // Long enough for the longest move to matter many times over
+            Target = 64U*maxTarget + 4096U;
+            Lost = malloc(Target + 1U);
+            if (Lost == NULL || Bitset_Solve(&Bitset, Sparse[s], SparseCounts[s], Target, Kernel) != GST_SUCCESS)
+            {
+                free(Lost);
+                return GST_FAILURE;
+            }
+            for (Distance = 0U; Distance <= Target; Distance++)
+            {
+                Lost[Distance] = 1U;
+                for (i = 0U; i < SparseCounts[s] && Lost[Distance]; i++)
+                {
+                    if (Sparse[s][i] <= Distance && Lost[Distance - Sparse[s][i]])
+                    {
+                        Lost[Distance] = 0U;
+                    }
+                }
+                Checked++;
+                if (Lost[Distance] != BITSET_IS_LOST(&Bitset, Distance))
+                {
+                    (*Mismatches)++;
+                    printf("Mismatch: Kernel(%s), Sparse set %u, Distance(%" PRIu64 ")\n", Bitset_KernelName(Kernel), s, Distance);
+                }
+            }
+
+            // The Dynamic table on the same set of moves
+            if (Kernel == BITSET_KERNEL_SCALAR)
+            {
+                if (Game_InitMoveSet(&rules, Target, Sparse[s], SparseCounts[s]) != GST_SUCCESS ||
+                    Dynamic_InitTable(&Actor, &Dynamic, &rules) != GST_SUCCESS)
+                {
+                    Dynamic_Free(&Dynamic);
+                    Bitset_Free(&Bitset);
+                    free(Lost);
+                    return GST_FAILURE;
+                }
+                for (Score = 0U; Score <= Target; Score++)
+                {
+                    Checked++;
+                    if ((Dynamic.Values[2U*Score + 1U] < 0) != Lost[Target - Score] ||
+                        (Score < Target && !Lost[Target - Score] && !Lost[Target - Score - Dynamic.Moves[Score]]))
+                    {
+                        (*Mismatches)++;
+                        printf("Mismatch: Dynamic, Sparse set %u, Target(%" PRIu64 "), Score(%" PRIu64 "), Dynamic Adds %u\n", s, Target, Score, Dynamic.Moves[Score]);
+                    }
+                }
+                Dynamic_Free(&Dynamic);
+            }
+            free(Lost);
+            Bitset_Free(&Bitset);
+        }
+    }
+
+    // Periodic solves against full ones, far past where the period was found
+    Kernel = Bitset_BestKernel();
+    for (s = 0U; s < maxAdvancement + sizeof(SparseCounts)/sizeof(SparseCounts[0]); s++)
+    {
+        for (i = 0U; i < s + 1U && s < maxAdvancement; i++)
+        {
+            Moves[i] = i + 1U;
+        }
+        Set = (s < maxAdvancement) ? Moves : Sparse[s - maxAdvancement];
+        SetCount = (s < maxAdvancement) ? s + 1U : SparseCounts[s - maxAdvancement];
+        Target = 4U*BITSET_PERIOD_START + 64U*maxTarget;
+        if (Bitset_Solve(&Bitset, Set, SetCount, Target, Kernel) != GST_SUCCESS ||
+            Bitset_SolvePeriodic(&Periodic, Set, SetCount, UINT64_MAX/2U, Kernel) != GST_SUCCESS)
+        {
+            Bitset_Free(&Bitset);
+            return GST_FAILURE;
+        }
+        for (Distance = 0U; Distance <= Target; Distance++)
+        {
+            Checked++;
+            if (Bitset_IsLost(&Periodic, Distance) != BITSET_IS_LOST(&Bitset, Distance))
+            {
+                (*Mismatches)++;
+                printf("Mismatch: Periodic set %u, PrePeriod(%" PRIu64 "), Period(%" PRIu64 "), Distance(%" PRIu64 ")\n", s, Periodic.PrePeriod, Periodic.Period, Distance);
+                break;
+            }
+        }
+
+        // Targets no full solve could reach, against the closed form
+        for (Distance = UINT64_C(1) << 63; s < maxAdvancement && Distance > (UINT64_C(1) << 63) - 64U; Distance--)
+        {
+            Game_InitRules(&rules, Distance, s + 1U);
+            Wins = Bitset_Move(&Periodic, Distance, &Move);
+            Checked++;
+            if ((Wins == GST_SUCCESS) != (ClosedForm_Move(&rules, 0U, &Expected) == GST_SUCCESS) || (Wins == GST_SUCCESS && Move != Expected))
+            {
+                (*Mismatches)++;
+                printf("Mismatch: Periodic MaxAdvancement(%u), Target(%" PRIu64 "), Bitset Adds %" PRIu64 ", ClosedForm Adds %" PRIu64 "\n", s + 1U, Distance, Move, Expected);
+            }
+        }
+
+        Bitset_Free(&Periodic);
+        Bitset_Free(&Bitset);
+    }
+
+    printf("Verified %" PRIu64 " bitset positions, %" PRIu64 " mismatches\n", Checked, *Mismatches);
+
+    return (*Mismatches == 0U) ? GST_SUCCESS : GST_FAILURE;
+};
+
+/**
+ * @brief Orders moves for qsort.
+ */
+static int Bitset_Compare(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *) a;
+    uint64_t y = *(const uint64_t *) b;
+
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief Reads the 64 bits starting at a bit offset, which may be inside the padding.
+ */
+static uint64_t Bitset_Extract(const uint64_t *Lost, int64_t Offset)
+{
+    int64_t r = Offset & 63;
+    int64_t q = (Offset - r)/64;
+
+    if (r == 0)
+    {
+        return Lost[q];
+    }
+    return (Lost[q] >> r) | (Lost[q + 1] << (64 - r));
+}
+
+/**
+ * @brief Compares the windows of longest move positions before two positions.
+ */
+static int Bitset_SameWindow(bitset_t Bitset, uint64_t a, uint64_t b)
+{
+    uint64_t longest = Bitset->Moves[Bitset->MoveCount - 1U];
+    int64_t from = (int64_t) a - (int64_t) longest;
+    int64_t to = (int64_t) b - (int64_t) longest;
+    uint64_t i;
+    uint64_t mask;
+
+    for (i = 0U; i < longest; i += 64U)
+    {
+        mask = (longest - i >= 64U) ? UINT64_MAX : (UINT64_C(1) << (longest - i)) - 1U;
+        if (((Bitset_Extract(Bitset->Lost, from + (int64_t) i) ^ Bitset_Extract(Bitset->Lost, to + (int64_t) i)) & mask) != 0U)
+        {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+/**
+ * @brief The portable kernel, one word at a time.
+ */
+static void Bitset_KernelScalar(const uint64_t *Lost, uint64_t Word, const uint64_t *Far, uint32_t FarCount, uint64_t *Out)
+{
+    uint32_t i;
+    uint32_t j;
+    int64_t offset;
+
+    for (i = 0U; i < FarCount; i++)
+    {
+        offset = (int64_t) (64U*Word) - (int64_t) Far[i];
+        for (j = 0U; j < BITSET_BLOCK_WORDS; j++)
+        {
+            Out[j] |= Bitset_Extract(Lost, offset + 64*(int64_t) j);
+        }
+    }
+}
+
+#ifdef BITSET_X86
+/**
+ * @brief 
+ * Two words per instruction. Shifting a 64-bit lane by 64 clears it, 
+ * so aligned offsets need no special case.
+ */
+__attribute__((target("sse2")))
+static void Bitset_KernelSSE2(const uint64_t *Lost, uint64_t Word, const uint64_t *Far, uint32_t FarCount, uint64_t *Out)
+{
+    __m128i acc0 = _mm_loadu_si128((const __m128i *) &Out[0]);
+    __m128i acc1 = _mm_loadu_si128((const __m128i *) &Out[2]);
+    __m128i right;
+    __m128i left;
+    const uint64_t *src;
+    int64_t offset;
+    int64_t r;
+    uint32_t i;
+
+    for (i = 0U; i < FarCount; i++)
+    {
+        offset = (int64_t) (64U*Word) - (int64_t) Far[i];
+        r = offset & 63;
+        src = Lost + (offset - r)/64;
+        right = _mm_cvtsi32_si128((int) r);
+        left = _mm_cvtsi32_si128((int) (64 - r));
+        acc0 = _mm_or_si128(acc0, _mm_or_si128(
+            _mm_srl_epi64(_mm_loadu_si128((const __m128i *) &src[0]), right),
+            _mm_sll_epi64(_mm_loadu_si128((const __m128i *) &src[1]), left)));
+        acc1 = _mm_or_si128(acc1, _mm_or_si128(
+            _mm_srl_epi64(_mm_loadu_si128((const __m128i *) &src[2]), right),
+            _mm_sll_epi64(_mm_loadu_si128((const __m128i *) &src[3]), left)));
+    }
+
+    _mm_storeu_si128((__m128i *) &Out[0], acc0);
+    _mm_storeu_si128((__m128i *) &Out[2], acc1);
+}
+
+/**
+ * @brief Four words, a whole block, per instruction.
+ */
+__attribute__((target("avx2")))
+static void Bitset_KernelAVX2(const uint64_t *Lost, uint64_t Word, const uint64_t *Far, uint32_t FarCount, uint64_t *Out)
+{
+    __m256i acc = _mm256_loadu_si256((const __m256i *) Out);
+    __m128i right;
+    __m128i left;
+    const uint64_t *src;
+    int64_t offset;
+    int64_t r;
+    uint32_t i;
+
+    for (i = 0U; i < FarCount; i++)
+    {
+        offset = (int64_t) (64U*Word) - (int64_t) Far[i];
+        r = offset & 63;
+        src = Lost + (offset - r)/64;
+        right = _mm_cvtsi32_si128((int) r);
+        left = _mm_cvtsi32_si128((int) (64 - r));
+        acc = _mm256_or_si256(acc, _mm256_or_si256(
+            _mm256_srl_epi64(_mm256_loadu_si256((const __m256i *) &src[0]), right),
+            _mm256_sll_epi64(_mm256_loadu_si256((const __m256i *) &src[1]), left)));
+    }
+
+    _mm256_storeu_si256((__m256i *) Out, acc);
+}
+#endif
+
+/*** end of file ***/
@@ -0,0 +1,206 @@
+/** @file closedform.c
+ * 
+ * @brief 
+ * A constant time player for the game "Who Says 20 First". Moving to
+ * the nearest score congruent to the target modulo (max advancement + 1)
+ * is the known optimal strategy, so no search or table is needed.
+ *
+ * @par       
+ * COPYRIGHT NOTICE: (c) 2021 Graham Power.  All rights reserved.
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */ 
+
+#include "closedform.h"
+#include "dynamic.h"
+
+/************************** Constant Definitions *****************************/
+
+/**************************** Type Definitions *******************************/
+
+/************************** Function Prototypes ******************************/
+
+/************************** Function Definitions *****************************/
+
+/**
+ * @brief 
+ * Initializes a closed form controller Actor. The strategy only 
+ * depends on the rules of the game being played, so no base 
+ * structure is needed.
+ * 
+ * @param Actor The actor who will use ClosedForm_Act to advance a game state. 
+ * @return GStatus The success of the initialization.
+ */
+GStatus ClosedForm_Init(Actor_t Actor)
+{
+    Actor->Type = CLOSED_FORM;
+    Actor->Action = ClosedForm_Act;
+    Actor->Choose = ClosedForm_Choose;
+    Actor->ActorBase = NULL;
+
+    return GST_SUCCESS;
+};
+
+/**
+ * @brief 
+ * Takes an action of behalf of the Actor that called it, using 
+ * ClosedForm_Move to pick the advancement.
+ * 
+ * @param game The game to take the action in.
+ * @param ActorBase Unused, the closed form player keeps no state.
+ * @return GStatus The success of the action.
+ */
+GStatus ClosedForm_Act(game_t game, void *ActorBase)
+{
+    (void) ActorBase;
+
+    uint64_t Advancement = 1U;
+    ClosedForm_Move(game->Rules, game->State, &Advancement);
+
+    LOG_PRINTF(LOG_INFO, "ClosedForm AI Adds: %" PRIu64 "\n", Advancement);
+
+    return Game_AdvanceState(game, Advancement);
+};
+
+/**
+ * @brief 
+ * Calculates the move the Actor would take, without taking it.
+ * 
+ * @param game The game to calculate the move in.
+ * @param ActorBase Unused, the closed form player keeps no state.
+ * @param Advancement Pointer to a uint. ClosedForm_Choose stores the action to take here.
+ * @return GStatus The success of the calculation.
+ */
+GStatus ClosedForm_Choose(game_t game, void *ActorBase, uint64_t *Advancement)
+{
+    (void) ActorBase;
+
+    return (ClosedForm_Move(game->Rules, game->State, Advancement) == GST_INVALID_STATE) ? GST_INVALID_STATE : GST_SUCCESS;
+};
+
+/**
+ * @brief Checks if the closed form holds for the passed in rules.
+ * 
+ * @param rules The rules to check.
+ * @return GStatus GST_SUCCESS if the moves are the range 1 to MaxAdvancement and the game isn't misere, GST_FAILURE otherwise.
+ */
+GStatus ClosedForm_Supports(rules_t rules)
+{
+    return (rules->Moves == NULL && rules->Ending != GAME_END_MISERE) ? GST_SUCCESS : GST_FAILURE;
+};
+
+/**
+ * @brief 
+ * Calculates the optimal move in constant time. The scores congruent 
+ * to the target modulo (max advancement + 1) are the losing scores 
+ * for the player about to move, so the best move is the one that 
+ * lands on the nearest of them. If the current score is already one 
+ * of them every move loses, and 1 is played to make the game last.
+ * 
+ * @param rules The rules of the game being played.
+ * @param Score The score of the current game.
+ * @param Advancement Pointer to a uint. ClosedForm_Move stores the action to take here.
+ * @return GStatus GST_SUCCESS if the move wins, GST_FAILURE if every move loses, GST_INVALID_STATE for move sets.
+ */
+GStatus ClosedForm_Move(rules_t rules, uint64_t Score, uint64_t *Advancement)
+{
+    uint64_t remainder;
+
+    if (ClosedForm_Supports(rules) != GST_SUCCESS)
+    {
+        *Advancement = RULES_MOVE(rules, 0U);
+        return GST_INVALID_STATE;
+    }
+
+    // Computed on the distance left, so MaxAdvancement + 1 can only overflow
+    // when every score is within reach anyway
+    if (rules->Target - Score <= rules->MaxAdvancement)
+    {
+        *Advancement = rules->Target - Score;
+        return GST_SUCCESS;
+    }
+
+    remainder = (rules->Target - Score) % (rules->MaxAdvancement + 1U);
+    if (remainder == 0U)
+    {
+        *Advancement = 1U;
+        return GST_FAILURE;
+    }
+
+    *Advancement = remainder;
+
+    return GST_SUCCESS;
+};
+
+/**
+ * @brief 
+ * Checks ClosedForm_Move against the table solver of the Dynamic 
+ * Programming player for every target from 1 to maxTarget and every 
+ * max advancement from 1 to maxAdvancement. For each score the two 
+ * have to agree on whether the player to move wins, and on the move 
+ * to take when they do.
+ * 
+ * @param maxTarget The largest target in the sweep.
+ * @param maxAdvancement The largest max advancement in the sweep.
+ * @param Mismatches Pointer to a uint. ClosedForm_Verify stores the number of disagreements here.
+ * @return GStatus GST_SUCCESS if every state agrees, GST_FAILURE otherwise.
+ */
+GStatus ClosedForm_Verify(uint64_t maxTarget, uint64_t maxAdvancement, uint64_t *Mismatches)
+{
+    struct rules rules;
+    struct Dynamic Dynamic;
+    struct Actor Actor;
+    uint64_t Target;
+    uint64_t MaxAdvancement;
+    uint64_t Score;
+    uint64_t Move;
+    uint64_t Checked = 0U;
+    int64_t Value;
+    GStatus Wins;
+
+    *Mismatches = 0U;
+
+    for (Target = 1U; Target <= maxTarget; Target++)
+    {
+        for (MaxAdvancement = 1U; MaxAdvancement <= maxAdvancement; MaxAdvancement++)
+        {
+            Game_InitRules(&rules, Target, MaxAdvancement);
+            if (Dynamic_InitTable(&Actor, &Dynamic, &rules) != GST_SUCCESS)
+            {
+                Dynamic_Free(&Dynamic);
+                return GST_FAILURE;
+            }
+
+            for (Score = 0U; Score < Target; Score++)
+            {
+                Value = Dynamic.Values[2U*Score + 1U];
+                Wins = ClosedForm_Move(&rules, Score, &Move);
+                Checked++;
+                if ((Wins == GST_SUCCESS) != (Value > 0) || (Wins == GST_SUCCESS && Move != Dynamic.Moves[Score]))
+                {
+                    (*Mismatches)++;
+                    printf("Mismatch: Target(%" PRIu64 "), MaxAdvancement(%" PRIu64 "), Score(%" PRIu64 "), ClosedForm Adds %" PRIu64 ", Dynamic Adds %u\n",
+                        Target, MaxAdvancement, Score, Move, Dynamic.Moves[Score]);
+                }
+            }
+
+            Dynamic_Free(&Dynamic);
+        }
+    }
+
+    printf("Verified %" PRIu64 " states, %" PRIu64 " mismatches\n", Checked, *Mismatches);
+
+    return (*Mismatches == 0U) ? GST_SUCCESS : GST_FAILURE;
+};
+
+/*** end of file ***/
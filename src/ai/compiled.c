@@ -0,0 +1,114 @@
+/** @file compiled.c
+ * 
+ * @brief 
+ * A player for the game "Who Says 20 First" that plays from a policy 
+ * table generated at build time for the rules in parameters.h. It 
+ * needs no solving, no heap and no files at runtime.
+ *
+ * @par       
+ * COPYRIGHT NOTICE: (c) 2021 Graham Power.  All rights reserved.
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */ 
+
+#include "compiled.h"
+
+#include "generated/policy.h"
+
+/************************** Constant Definitions *****************************/
+
+// The policy is generated from parameters.h by the Makefile, this
+// catches a header left over from other parameters.
+#if (POLICY_TARGET != MAX_STATE) || (POLICY_MAX_ADVANCEMENT != MAX_STATE_ADVANCEMENT)
+#error "include/generated/policy.h is stale against include/parameters.h, rebuild it with make"
+#endif
+
+/**************************** Type Definitions *******************************/
+
+/************************** Function Prototypes ******************************/
+
+/************************** Function Definitions *****************************/
+
+/**
+ * @brief 
+ * Initializes a compiled policy controller Actor. The policy is 
+ * part of the binary, so no base structure is needed.
+ * 
+ * @param Actor The actor who will use Compiled_Act to advance a game state. 
+ * @return GStatus The success of the initialization.
+ */
+GStatus Compiled_Init(Actor_t Actor)
+{
+    Actor->Type = COMPILED;
+    Actor->Action = Compiled_Act;
+    Actor->Choose = Compiled_Choose;
+    Actor->ActorBase = NULL;
+
+    return GST_SUCCESS;
+};
+
+/**
+ * @brief 
+ * Takes an action of behalf of the Actor that called it, playing 
+ * the move stored in the policy.
+ * 
+ * @param game The game to take the action in.
+ * @param ActorBase Unused, the compiled player keeps no state.
+ * @return GStatus The success of the action.
+ */
+GStatus Compiled_Act(game_t game, void *ActorBase)
+{
+    uint64_t Advancement = 1U;
+    Compiled_Choose(game, ActorBase, &Advancement);
+
+    LOG_PRINTF(LOG_INFO, "Compiled AI Adds: %" PRIu64 "\n", Advancement);
+
+    return Game_AdvanceState(game, Advancement);
+};
+
+/**
+ * @brief 
+ * Calculates the move the Actor would take, without taking it.
+ * 
+ * @param game The game to calculate the move in.
+ * @param ActorBase Unused, the compiled player keeps no state.
+ * @param Advancement Pointer to a uint. Compiled_Choose stores the action to take here.
+ * @return GStatus GST_INVALID_STATE if the policy wasn't generated for the game, GST_SUCCESS otherwise.
+ */
+GStatus Compiled_Choose(game_t game, void *ActorBase, uint64_t *Advancement)
+{
+    (void) ActorBase;
+
+    *Advancement = 1U;
+    if (Compiled_Supports(game->Rules) != GST_SUCCESS || game->State >= POLICY_TARGET)
+    {
+        return GST_INVALID_STATE;
+    }
+    *Advancement = PolicyMoves[game->State];
+
+    return GST_SUCCESS;
+};
+
+/**
+ * @brief Checks if the policy was generated for the passed in rules.
+ * 
+ * @param rules The rules to check.
+ * @return GStatus GST_SUCCESS if the compiled player can play games with the rules, GST_FAILURE otherwise.
+ */
+GStatus Compiled_Supports(rules_t rules)
+{
+    return (rules->Target == POLICY_TARGET && rules->MaxAdvancement == POLICY_MAX_ADVANCEMENT &&
+        rules->Moves == NULL && rules->Ending != GAME_END_MISERE) ? GST_SUCCESS : GST_FAILURE;
+};
+
+/*** end of file ***/
@@ -23,13 +23,38 @@
 
 #include "dynamic.h"
 
+#include <string.h>
+
+#include "clock.h"
+
 /************************** Constant Definitions *****************************/
 
+// Frames Dynamic_Reward keeps on the call stack, deeper searches move to the heap
+#define DYNAMIC_FRAMES_LOCAL    64U
+
 /**************************** Type Definitions *******************************/
 
+// A state Dynamic_Reward is part way through searching.
+struct dynamic_frame
+{
+    uint64_t Score;
+    uint64_t Key;
+    uint64_t Legal;         // Legal moves from the state
+    uint64_t Next;          // Index of the next move to search
+    uint64_t Best;          // The move with the best reward so far
+    int64_t Max;            // The best reward so far, the smallest on the opponents turn
+    uint8_t MyTurn;
+};
+
 /************************** Function Prototypes ******************************/
 
-GStatus Dynamic_AI(hashtable_t table, uint8_t Score, uint8_t *Advancement);
+static int64_t Dynamic_TowardsZero(int64_t Value);
+static GStatus Dynamic_Enter(ttable_t table, rules_t rules, uint64_t Score, uint64_t Depth, uint8_t MyTurn, struct dynamic_frame *Frame, int64_t *Reward, struct dynamic_stats *Stats);
+static int64_t Dynamic_Leave(ttable_t table, rules_t rules, struct dynamic_frame *Frame, uint64_t Depth, struct dynamic_stats *Stats);
+static void Dynamic_Keep(struct dynamic_frame *Frame, uint64_t Advancement, int64_t Reward);
+GStatus Dynamic_Solve(dynamic_t Dynamic);
+GStatus Dynamic_SolveRange(dynamic_t Dynamic);
+GStatus Dynamic_Lookup(dynamic_t Dynamic, uint64_t Score, uint64_t *Advancement);
 
 /************************** Function Definitions *****************************/
 
@@ -39,33 +64,106 @@ GStatus Dynamic_AI(hashtable_t table, uint8_t Score, uint8_t *Advancement);
  * name used for anything capable of making advancements in the game 
  * state (i.e. adding 1 or 2). This takes in the Actor who will use 
  * its Dynamic_Act function, the Dynamic type used to store a class-like 
- * object, and the hashtable to be used.
+ * object, and the transposition table to be used. The table must 
+ * already be initialized with TTable_Init, or be the table from 
+ * TTable_Shared, which other players may be using at the same time.
  * 
  * @param Actor The actor who will use Dynamic_Act to advance a game state. 
  * @param Dynamic The pointer to the dynamic struct, used as a class-like representation.
- * @param table The hashtable used by this dynamic programming instance.
+ * @param table The transposition table used by this dynamic programming instance.
  * @return GStatus The success of the initialization.
  */
-GStatus Dynamic_Init(Actor_t Actor, dynamic_t Dynamic, hashtable_t table)
+GStatus Dynamic_Init(Actor_t Actor, dynamic_t Dynamic, ttable_t table)
 {
     // Set the action the passed in actor uses to Dynamic_Act
+    Actor->Type = DYNAMIC;
     Actor->Action = Dynamic_Act;
+    Actor->Choose = Dynamic_Choose;
+    Dynamic->Mode = DYNAMIC_MODE_RECURSIVE;
 
-    // Initialize and store the hashtable to use
-    Hashtable_Init(table);
+    // Store the transposition table to use
     Dynamic->table = table;
+    Dynamic->Values = NULL;
+    Dynamic->Moves = NULL;
+    memset(&Dynamic->MoveStats, 0, sizeof(Dynamic->MoveStats));
+    Dynamic_ResetGameStats(Dynamic);
+
+    // Set the actors base structure to a Dynamic strucure
+    Actor->ActorBase = Dynamic;
+
+    return GST_SUCCESS;
+};
+
+/**
+ * @brief 
+ * Initializes a table driven Dynamic Programming controller Actor. 
+ * Every (score, turn) state of the game is solved once here, from 
+ * the last state back to the first, so each call to Dynamic_Act 
+ * afterwards is a single table lookup. The table is sized for the 
+ * passed in rules, and must be released with Dynamic_Free.
+ * 
+ * @param Actor The actor who will use Dynamic_Act to advance a game state. 
+ * @param Dynamic The pointer to the dynamic struct, used as a class-like representation.
+ * @param rules The rules of the games this instance will play.
+ * @return GStatus The success of the initialization.
+ */
+GStatus Dynamic_InitTable(Actor_t Actor, dynamic_t Dynamic, rules_t rules)
+{
+    // Set the action the passed in actor uses to Dynamic_Act
+    Actor->Type = DYNAMIC_TABLE;
+    Actor->Action = Dynamic_Act;
+    Actor->Choose = Dynamic_Choose;
+    Dynamic->Mode = DYNAMIC_MODE_TABLE;
+
+    // The table mode keeps its own storage, no transposition table is needed
+    Dynamic->table = NULL;
+    Dynamic->Rules = *rules;
+    Dynamic->Values = NULL;
+    Dynamic->Moves = NULL;
+    memset(&Dynamic->MoveStats, 0, sizeof(Dynamic->MoveStats));
+    Dynamic_ResetGameStats(Dynamic);
 
     // Set the actors base structure to a Dynamic strucure
     Actor->ActorBase = Dynamic;
 
+    // Every move has to fit in the move table, and every state in memory
+    if (rules->MaxAdvancement > UINT32_MAX || rules->Target >= SIZE_MAX / (2U*sizeof(int64_t)))
+    {
+        return GST_FAILURE;
+    }
+
+    Dynamic->Values = malloc(2U*(rules->Target + 1U)*sizeof(int64_t));
+    Dynamic->Moves = malloc((rules->Target + 1U)*sizeof(uint32_t));
+    if (Dynamic->Values == NULL || Dynamic->Moves == NULL)
+    {
+        Dynamic_Free(Dynamic);
+        return GST_FAILURE;
+    }
+
+    return Dynamic_Solve(Dynamic);
+};
+
+/**
+ * @brief Releases the storage allocated by Dynamic_InitTable.
+ * 
+ * @param Dynamic The pointer to the dynamic struct to release.
+ * @return GStatus The success of the release.
+ */
+GStatus Dynamic_Free(dynamic_t Dynamic)
+{
+    free(Dynamic->Values);
+    free(Dynamic->Moves);
+    Dynamic->Values = NULL;
+    Dynamic->Moves = NULL;
+
     return GST_SUCCESS;
 };
 
 /**
  * @brief 
  * Takes an action of behalf of the Actor that called it. 
- * This action will calculate the best next move, either 
- * adding 1 or 2, and take it.
+ * This action will calculate the best next move, adding 
+ * anything from 1 to the rules maximum, and take it.
  * 
  * @param game The game to take the action in.
  * @param ActorBase 
@@ -75,29 +173,72 @@ GStatus Dynamic_Init(Actor_t Actor, dynamic_t Dynamic, hashtable_t table)
  */
 GStatus Dynamic_Act(game_t game, void *ActorBase)
 {
-    // Recover the Dynamic structure from the Actors base structure
-    dynamic_t Dynamic = (dynamic_t) ActorBase;
-
     // Variable to store the result of this action
     GStatus ActionState;
 
     // Set the default action to add 1, in case there is an error
     // and then calculate the actual action to take using the 
-    // Dynamic_AI function (bottom of file)
-    uint8_t Advancement = 1U;
-    Dynamic_AI(Dynamic->table, game->State, &Advancement);
+    // Dynamic_Choose function
+    uint64_t Advancement = 1U;
+    Dynamic_Choose(game, ActorBase, &Advancement);
 
-    #ifdef VERBOSE_OUTPUT
-    printf("DynamicP AI Adds: %u\n", Advancement);
-    #endif
+    LOG_PRINTF(LOG_INFO, "DynamicP AI Adds: %" PRIu64 "\n", Advancement);
+    if (LOG_ENABLED(LOG_DEBUG))
+    {
+        Dynamic_PrintStats("Move", &((dynamic_t) ActorBase)->MoveStats);
+    }
     ActionState = Game_AdvanceState(game, Advancement);
 
     return ActionState;
 };
 
+/**
+ * @brief 
+ * Calculates the move the Actor would take, without taking it. 
+ * Used by Dynamic_Act, and by anything that plays games without 
+ * printing them.
+ * 
+ * @param game The game to calculate the move in.
+ * @param ActorBase The Actors base structure, a Dynamic structure.
+ * @param Advancement Pointer to a uint. Dynamic_Choose stores the action to take here.
+ * @return GStatus The success of the calculation.
+ */
+GStatus Dynamic_Choose(game_t game, void *ActorBase, uint64_t *Advancement)
+{
+    // Recover the Dynamic structure from the Actors base structure
+    dynamic_t Dynamic = (dynamic_t) ActorBase;
+    GStatus Status;
+    uint64_t start;
+
+    // Scores only grow during a game, so a score that didn't is a new game
+    if (game->State <= Dynamic->LastScore)
+    {
+        Dynamic_ResetGameStats(Dynamic);
+    }
+    Dynamic->LastScore = game->State;
+
+    if (Dynamic->Mode == DYNAMIC_MODE_TABLE)
+    {
+        memset(&Dynamic->MoveStats, 0, sizeof(Dynamic->MoveStats));
+        start = Clock_Nanoseconds();
+        Status = Dynamic_Lookup(Dynamic, game->State, Advancement);
+        Dynamic->MoveStats.Calls = 1U;
+        Dynamic->MoveStats.Nanoseconds = Clock_Nanoseconds() - start;
+    }
+    else
+    {
+        // Dynamic_AI function (bottom of file)
+        Status = Dynamic_AI(Dynamic->table, game->Rules, game->State, Advancement, &Dynamic->MoveStats);
+    }
+    Dynamic_AddStats(&Dynamic->GameStats, &Dynamic->MoveStats);
+
+    return Status;
+};
+
 /**
  * @brief Calculates the Reward for being in a state.
  * 
+ * @param rules The rules of the game being evaluated.
  * @param Score The current game score.
  * @param MyTurn 
  * Whether or not it is the Dynamic Programming instances turn. 
@@ -105,27 +246,29 @@ GStatus Dynamic_Act(game_t game, void *ActorBase)
  * @param Eval Pointer to an int. Dynamic_Evaluate stores its result here.
  * @return GStatus The success of the evaluation.
  */
-GStatus Dynamic_Evaluate(uint8_t Score, uint8_t MyTurn, int *Eval)
+GStatus Dynamic_Evaluate(rules_t rules, uint64_t Score, uint8_t MyTurn, int *Eval)
 {
     // Status returns GST_SUCCESS if we have just evaluated the last
     // possible state in the game, GST_FAILURE otherwise
     GStatus FoundEndGame;
-    if (Score > MAX_STATE) // Make sure no one tries to make illegal moves (i.e. add beyond 20)
+    // Under misere rules the player who can't move is the winner
+    uint8_t Loser = (rules->Ending == GAME_END_MISERE) ? 0U : 1U;
+    if (Score > rules->Target) // Make sure no one tries to make illegal moves (i.e. add beyond the target)
     {
         *Eval = -100;
         FoundEndGame = GST_SUCCESS;
     }
-    else if (Score == MAX_STATE && MyTurn == 1) // Score is already 20 on my turn, other player won
+    else if (rules->Target - Score < RULES_MOVE(rules, 0U) && MyTurn == Loser) // No move is left on my turn, other player won
     {
         *Eval = -10;
         FoundEndGame = GST_SUCCESS;
     }
-    else if (Score == MAX_STATE && MyTurn == 0) // Score is already 20 on other players turn, I won
+    else if (rules->Target - Score < RULES_MOVE(rules, 0U)) // No move is left on other players turn, I won
     {
         *Eval = 10;
         FoundEndGame = GST_SUCCESS;
     }
-    else // Score is not 20, nobody won
+    else // Score is not the target, nobody won
     {
         *Eval = 0;
         FoundEndGame = GST_FAILURE;
@@ -136,91 +279,104 @@ GStatus Dynamic_Evaluate(uint8_t Score, uint8_t MyTurn, int *Eval)
 
 /**
  * @brief 
- * Recursively calculates the expected reward for being in this state. 
- * Given as a sum of discounted rewards of this state and all future 
- * possible states.
+ * Calculates the reward for being in this state, on the same 
+ * integer scale as the table of Dynamic_Solve. A state won in 
+ * N plies is worth DYNAMIC_WIN_VALUE - N, and one lost in N plies 
+ * the negation of that. So wins are taken as fast as possible and 
+ * losses put off as long as possible, however long the game is.
  * 
- * @param table The hashtable used to store previously calculated rewards.
+ * The reward only depends on the state, not on how far it is from 
+ * the state moved from, so one transposition table entry serves 
+ * every path to it. Entries hold the plies to the end of the game, 
+ * with Flags set when the state is won.
+ * 
+ * The search is depth first, the same as a recursion over the 
+ * children of each state, but it keeps its own stack of frames. 
+ * A game can be millions of plies long, far deeper than the call 
+ * stack goes.
+ * 
+ * @param table The transposition table used to store previously calculated rewards.
+ * @param rules The rules of the game being played.
  * @param Score The score of the current game.
- * @param Depth How many actions ahead we are currently looking.
+ * @param Depth How many actions ahead we are currently looking, only used for the stats.
  * @param MyTurn 
  * Whether or not it is the Dynamic Programming instances turn. 
  * 1 = Yes, 0 = No.
- * @param Reward Pointer to a float. Dynamic_Reward stores its result here.
- * @return GStatus Status of the reward calculation.
+ * @param Reward Pointer to an int. Dynamic_Reward stores its result here.
+ * @param Stats The counters of the search this state is part of.
+ * @return GStatus GST_FAILURE if the frames could not be allocated, GST_SUCCESS otherwise.
  */
-GStatus Dynamic_Reward(hashtable_t table, uint8_t Score, uint8_t Depth, uint8_t MyTurn, float *Reward)
+GStatus Dynamic_Reward(ttable_t table, rules_t rules, uint64_t Score, uint64_t Depth, uint8_t MyTurn, int64_t *Reward, struct dynamic_stats *Stats)
 {
-    // Evaluates the score in the current state
-    int score = 0;
-    GStatus EvalResult = Dynamic_Evaluate(Score, MyTurn, &score);
-
-    // If the current state is the last state in the game, return the result directly
-    if (EvalResult == GST_SUCCESS)
+    struct dynamic_frame Local[DYNAMIC_FRAMES_LOCAL];
+    struct dynamic_frame *Frames = Local;
+    struct dynamic_frame *Grown;
+    struct dynamic_frame *Frame;
+    uint64_t Capacity = DYNAMIC_FRAMES_LOCAL;
+    uint64_t Top = 1U;
+    uint64_t a;
+    int64_t tmp = 0;
+
+    // Terminal states and states in the transposition table need no search
+    if (Dynamic_Enter(table, rules, Score, Depth, MyTurn, &Frames[0], Reward, Stats) == GST_SUCCESS)
     {
-        *Reward = score;
         return GST_SUCCESS;
     }
 
-    // Variables to store intermediate calculations, the max found reward, and the gamma value.
-    float tmp;
-    float max;
-    float gamma = pow(0.5, Depth);
-
-    // Use the Hashtable stored value, if it exists
-    GStatus Hashtable_Valid = Hashtable_Get(table, Score, MyTurn, Reward);
-    if (Hashtable_Valid == GST_SUCCESS)
+    while (Top > 0U)
     {
-        #ifdef TRACE_CALCS
-        printf("Reward Score (%.5e) -- Using Hashtable Stored Value!\n", *Reward);
-        #endif
-        return GST_SUCCESS;
-    }
-
-    if (MyTurn) // Calculate the Reward obtained by us, the Dynamic AI Player
-    {
-        max = -100000;
-        // Calculate for a move of add 1
-        Dynamic_Reward(table, Score+1, Depth+1, 0, &tmp);
-        if (tmp > max)
+        Frame = &Frames[Top - 1U];
+        if (Frame->Next == Frame->Legal)
         {
-            max = tmp;
+            // Every child is searched, hand the reward to the parent
+            tmp = Dynamic_Leave(table, rules, Frame, Depth + Top - 1U, Stats);
+            Top--;
+            if (Top > 0U)
+            {
+                Dynamic_Keep(&Frames[Top - 1U], Frame->Score - Frames[Top - 1U].Score, tmp);
+            }
+            continue;
         }
-        // Calculate for a move of add 2
-        Dynamic_Reward(table, Score+2, Depth+1, 0, &tmp);
-        if (tmp > max)
+
+        // Calculate for every legal move, from the smallest to the largest
+        a = RULES_MOVE(rules, Frame->Next);
+        Frame->Next++;
+        if (Top == Capacity)
         {
-            max = tmp;
+            Grown = (Frames == Local) ? malloc(2U*Capacity*sizeof(*Frames)) : realloc(Frames, 2U*Capacity*sizeof(*Frames));
+            if (Grown == NULL)
+            {
+                if (Frames != Local)
+                {
+                    free(Frames);
+                }
+                *Reward = 0;
+                return GST_FAILURE;
+            }
+            if (Frames == Local)
+            {
+                memcpy(Grown, Local, sizeof(Local));
+            }
+            Frames = Grown;
+            Capacity *= 2U;
+            Frame = &Frames[Top - 1U];
         }
-    }
-    else // Calculate the Reward obtained by our Opponent
-    {
-        max = 100000;
-        // Calculate for a move of add 1
-        Dynamic_Reward(table, Score+1, Depth+1, 1, &tmp);
-        if (tmp < max) // Here we want the smallest reward, since a good reward for our opponent is bad for us
+
+        if (Dynamic_Enter(table, rules, Frame->Score + a, Depth + Top, !Frame->MyTurn, &Frames[Top], &tmp, Stats) == GST_SUCCESS)
         {
-            max = tmp;
+            Dynamic_Keep(Frame, a, tmp);
         }
-        // Calculate for a move of add 2
-        Dynamic_Reward(table, Score+2, Depth+1, 1, &tmp);
-        if (tmp < max) // Here we want the smallest reward, since a good reward for our opponent is bad for us
+        else
         {
-            max = tmp;
+            Top++;
         }
     }
+    *Reward = tmp;
 
-    // Calculate the reward contribution in this state
-    *Reward = (gamma*max);
-
-    // Store the reward in the Hashtable
-    Hashtable_Put(table, Score, MyTurn, *Reward);
-
-    #ifdef TRACE_CALCS
-    int i;
-    for (i = 0; i < Depth; i++){printf("\t");}
-    printf("Reward Score(%u), Depth(%u), MyTurn(%u), Gamma(%.5e), Max(%.5e), Reward(%.5e)\n", Score, Depth, MyTurn, gamma, max, *Reward);
-    #endif
+    if (Frames != Local)
+    {
+        free(Frames);
+    }
 
     return GST_SUCCESS;
 }
@@ -231,61 +387,503 @@ GStatus Dynamic_Reward(hashtable_t table, uint8_t Score, uint8_t Depth, uint8_t
  * score of the game. Done assuming the other player will also 
  * play optimally.
  * 
- * @param table The hashtable used to store previously calculated rewards.
+ * @param table The transposition table used to store previously calculated rewards.
+ * @param rules The rules of the game being played.
  * @param Score The score of the current game.
  * @param Advancement Pointer to a uint. Dynamic_AI stores the action to take here.
+ * @param Stats 
+ * Pointer to the counters of this call, they are reset first. 
+ * NULL if they aren't wanted.
  * @return GStatus The Status of the action calculation.
  */
-GStatus Dynamic_AI(hashtable_t table, uint8_t Score, uint8_t *Advancement)
+GStatus Dynamic_AI(ttable_t table, rules_t rules, uint64_t Score, uint64_t *Advancement, struct dynamic_stats *Stats)
 {
     // Set the default advancement to 1, just in case an error occurs
     *Advancement = 1U;
-    float bestMove = -10000;
-    float tmp;
+    int64_t bestMove = INT64_MIN;
+    int64_t tmp;
+    uint64_t a;
+    uint64_t i;
+    struct dynamic_stats unused;
+
+    if (Stats == NULL)
+    {
+        Stats = &unused;
+    }
+    memset(Stats, 0, sizeof(*Stats));
+    Stats->Calls = 1U;
+    Stats->Nanoseconds = Clock_Nanoseconds();
+
+    // Moves past the target are never taken, and would score as a loss for whoever took them
+    for (i = 0U; i < Game_LegalMoves(rules, rules->Target - Score); i++)
+    {
+        // Check if advancing by a is the best move
+        a = RULES_MOVE(rules, i);
+        TRACE_EVENT(.Event = TRACE_CANDIDATE, .Score = Score, .Arg = a);
+
+        // Calculate the reward that would be obtained if we added a
+        if (Dynamic_Reward(table, rules, Score+a, 0, 0, &tmp, Stats) != GST_SUCCESS)
+        {
+            Stats->Nanoseconds = Clock_Nanoseconds() - Stats->Nanoseconds;
+            return GST_FAILURE;
+        }
+
+        TRACE_EVENT(.Event = TRACE_CANDIDATE_END, .Score = Score, .Arg = a, .Value.Integer = tmp);
+
+        // If adding a gives us the highest rewards, choose to add a
+        if (tmp > bestMove)
+        {
+            bestMove = tmp;
+            *Advancement = a;
+        }
+    }
 
-    // Check if advancing by 1 is the best move
-    #ifdef TRACE_CALCS
-    printf("Calculate Add One Reward...\n");
-    #endif
+    TRACE_EVENT(.Event = TRACE_BEST, .Score = Score, .Arg = *Advancement);
 
-    // Calculate the reward that would be obtained if we added 1
-    Dynamic_Reward(table, Score+1, 0, 0, &tmp);
+    Stats->Nanoseconds = Clock_Nanoseconds() - Stats->Nanoseconds;
 
-    #ifdef TRACE_CALCS
-    printf("Add One Reward: %.5e\n", tmp);
-    #endif
+    return GST_SUCCESS;
+};
 
-    // If adding one gives us the highest rewards, choose to add 1
-    if (tmp > bestMove)
+/**
+ * @brief 
+ * Fills the value table for every (score, turn) state, starting 
+ * from the target and working back to 0. Every state only depends 
+ * on states with a higher score, so each one is calculated exactly 
+ * once. The value of a state is the best (or, on the opponents 
+ * turn, the worst) value of its children, one ply further from 
+ * the end of the game.
+ * 
+ * Values are the rewards of Dynamic_Reward, a state won or lost 
+ * in Plies is stored as +-(DYNAMIC_WIN_VALUE - Plies).
+ * 
+ * This costs one pass over the moves per state. Ranges of moves 
+ * are handed to Dynamic_SolveRange, which doesn't, unless the game 
+ * is misere.
+ * 
+ * @param Dynamic The pointer to the dynamic struct whose table is filled.
+ * @return GStatus The success of the solve.
+ */
+GStatus Dynamic_Solve(dynamic_t Dynamic)
+{
+    rules_t rules = &Dynamic->Rules;
+    int64_t *Values = Dynamic->Values;
+    uint64_t Score;
+    uint64_t legal;
+    uint64_t a;
+    uint64_t i;
+    uint8_t MyTurn;
+    int eval;
+    int64_t max;
+    int64_t tmp;
+
+    if (rules->Moves == NULL && rules->Ending != GAME_END_MISERE)
     {
-        bestMove = tmp;
-        *Advancement = 1U;
+        return Dynamic_SolveRange(Dynamic);
     }
 
-    // Check if advancing by 2 is the best move
-    #ifdef TRACE_CALCS
-    printf("Calculate Add Two Score...\n");
-    #endif
+    // The states no move can be made from are scored directly
+    for (Score = rules->Target; Score + RULES_MOVE(rules, 0U) > rules->Target; Score--)
+    {
+        for (MyTurn = 0U; MyTurn < 2U; MyTurn++)
+        {
+            Dynamic_Evaluate(rules, Score, MyTurn, &eval);
+            Values[2U*Score + MyTurn] = (eval > 0) ? DYNAMIC_WIN_VALUE : -DYNAMIC_WIN_VALUE;
+        }
+        Dynamic->Moves[Score] = (uint32_t) RULES_MOVE(rules, 0U);
+        if (Score == 0U)
+        {
+            return GST_SUCCESS;
+        }
+    }
 
-    // Calculate the reward that would be obtained if we added 2
-    Dynamic_Reward(table, Score+2, 0, 0, &tmp);
+    for (Score++; Score-- > 0U; )
+    {
+        legal = Game_LegalMoves(rules, rules->Target - Score);
+        for (MyTurn = 0U; MyTurn < 2U; MyTurn++)
+        {
+            max = MyTurn ? INT64_MIN : INT64_MAX;
+            for (i = 0U; i < legal; i++)
+            {
+                a = RULES_MOVE(rules, i);
+                tmp = Values[2U*(Score + a) + !MyTurn];
+                if (MyTurn && tmp > max)
+                {
+                    max = tmp;
+                    Dynamic->Moves[Score] = (uint32_t) a;
+                }
+                else if (!MyTurn && tmp < max) // Our opponent takes the smallest value
+                {
+                    max = tmp;
+                }
+            }
+            // One ply further from the end moves the value towards 0
+            Values[2U*Score + MyTurn] = Dynamic_TowardsZero(max);
+
+            TRACE_EVENT(.Event = TRACE_SOLVE, .Turn = MyTurn, .Score = Score, .Value.Integer = Values[2U*Score + MyTurn]);
+        }
+    }
 
-    #ifdef TRACE_CALCS
-    printf("Add Two Reward: %.5e\n", tmp);
-    #endif
+    return GST_SUCCESS;
+};
 
-    // If adding two gives us the highest rewards, choose to add 2
-    if (tmp > bestMove)
+/**
+ * @brief 
+ * Fills the same table as Dynamic_Solve when the moves are the range 
+ * 1 to K, in constant time per state however large K is.
+ * 
+ * The value of a state for the player to move is the negation of 
+ * its value for the other player, so only one is worked out. Two 
+ * lost states are always more than K apart, since the higher one 
+ * would be a winning move from the lower one. So the window of 
+ * states reachable from a score holds at most one lost state, and 
+ * a running count of them is all that is needed:
+ *  - One lost state in reach wins, by moving to it.
+ *  - None loses. The next lost state is then exactly K + 1 away, 
+ *    every state in reach moves to it, so they all have the same 
+ *    value and adding 1 is as good as any move.
+ * 
+ * @param Dynamic The pointer to the dynamic struct whose table is filled.
+ * @return GStatus The success of the solve.
+ */
+GStatus Dynamic_SolveRange(dynamic_t Dynamic)
+{
+    rules_t rules = &Dynamic->Rules;
+    int64_t *Values = Dynamic->Values;
+    uint64_t Score;
+    uint64_t lost = 0U;         // Lost states in reach of Score
+    uint64_t nearest = 0U;      // The lowest lost state above Score
+    int64_t value;
+
+    // The target is lost for whoever has to move from it
+    Values[2U*rules->Target + 1U] = -DYNAMIC_WIN_VALUE;
+    Values[2U*rules->Target] = DYNAMIC_WIN_VALUE;
+    Dynamic->Moves[rules->Target] = 1U;
+
+    for (Score = rules->Target; Score-- > 0U; )
     {
-        bestMove = tmp;
-        *Advancement = 2U;
+        // Slide the window down, Score + 1 comes into reach and
+        // Score + K + 1 goes out of it
+        if (Values[2U*(Score + 1U) + 1U] < 0)
+        {
+            lost++;
+            nearest = Score + 1U;
+        }
+        if (rules->Target - Score > rules->MaxAdvancement && Values[2U*(Score + 1U + rules->MaxAdvancement) + 1U] < 0)
+        {
+            lost--;
+        }
+
+        if (lost > 0U)
+        {
+            value = Dynamic_TowardsZero(-Values[2U*nearest + 1U]);
+            Dynamic->Moves[Score] = (uint32_t) (nearest - Score);
+        }
+        else
+        {
+            value = Dynamic_TowardsZero(-Values[2U*(Score + 1U) + 1U]);
+            Dynamic->Moves[Score] = 1U;
+        }
+        Values[2U*Score + 1U] = value;
+        Values[2U*Score] = -value;
+
+        TRACE_EVENT(.Event = TRACE_SOLVE, .Turn = 0U, .Score = Score, .Value.Integer = -value);
+        TRACE_EVENT(.Event = TRACE_SOLVE, .Turn = 1U, .Score = Score, .Value.Integer = value);
+    }
+
+    return GST_SUCCESS;
+};
+
+/**
+ * @brief 
+ * Looks up the best possible move to make from the table filled 
+ * by Dynamic_Solve.
+ * 
+ * @param Dynamic The pointer to the solved dynamic struct.
+ * @param Score The score of the current game.
+ * @param Advancement Pointer to a uint. Dynamic_Lookup stores the action to take here.
+ * @return GStatus GST_INVALID_STATE if the score is outside the table, GST_SUCCESS otherwise.
+ */
+GStatus Dynamic_Lookup(dynamic_t Dynamic, uint64_t Score, uint64_t *Advancement)
+{
+    if (Score >= Dynamic->Rules.Target)
+    {
+        *Advancement = 1U;
+        return GST_INVALID_STATE;
     }
 
-    #ifdef TRACE_CALCS
-    printf("Best Move Is Add %u\n", *Advancement);
-    #endif
+    *Advancement = Dynamic->Moves[Score];
+
+    TRACE_EVENT(.Event = TRACE_LOOKUP, .Score = Score, .Arg = *Advancement);
+
+    return GST_SUCCESS;
+};
+
+/**
+ * @brief Copies out the counters of the last move calculated.
+ * 
+ * @param Dynamic The pointer to the dynamic struct.
+ * @param Stats Pointer to the stats. Dynamic_GetMoveStats stores the counters here.
+ * @return GStatus The success of the read.
+ */
+GStatus Dynamic_GetMoveStats(dynamic_t Dynamic, struct dynamic_stats *Stats)
+{
+    *Stats = Dynamic->MoveStats;
+
+    return GST_SUCCESS;
+};
+
+/**
+ * @brief Copies out the counters summed over every move of the current game.
+ * 
+ * @param Dynamic The pointer to the dynamic struct.
+ * @param Stats Pointer to the stats. Dynamic_GetGameStats stores the counters here.
+ * @return GStatus The success of the read.
+ */
+GStatus Dynamic_GetGameStats(dynamic_t Dynamic, struct dynamic_stats *Stats)
+{
+    *Stats = Dynamic->GameStats;
+
+    return GST_SUCCESS;
+};
+
+/**
+ * @brief 
+ * Starts a new sum of game counters. Dynamic_Choose does this on its 
+ * own when it sees a new game start.
+ * 
+ * @param Dynamic The pointer to the dynamic struct.
+ * @return GStatus The success of the reset.
+ */
+GStatus Dynamic_ResetGameStats(dynamic_t Dynamic)
+{
+    memset(&Dynamic->GameStats, 0, sizeof(Dynamic->GameStats));
+    Dynamic->LastScore = UINT64_MAX;
+
+    return GST_SUCCESS;
+};
+
+/**
+ * @brief Prints a set of counters on one line.
+ * 
+ * @param Label What the counters are for, printed first.
+ * @param Stats The counters to print.
+ * @return GStatus The success of the print.
+ */
+GStatus Dynamic_PrintStats(const char *Label, const struct dynamic_stats *Stats)
+{
+    printf("%s: %" PRIu64 " moves, %" PRIu64 " nodes, %" PRIu64 " terminals, %" PRIu64 " probes (%" PRIu64 " hits, %" PRIu64 " misses), %" PRIu64 " stores, depth %" PRIu64 ", %.3f ms\n",
+        Label, Stats->Calls, Stats->Nodes, Stats->Terminals, Stats->Probes, Stats->Hits, Stats->Misses,
+        Stats->Stores, Stats->MaxDepth, (double) Stats->Nanoseconds / 1e6);
 
     return GST_SUCCESS;
 };
 
+/**
+ * @brief Adds one set of counters to a running total, keeping the deepest depth.
+ * 
+ * @param Total The counters to add to.
+ * @param Stats The counters to add.
+ * @return GStatus The success of the addition.
+ */
+GStatus Dynamic_AddStats(struct dynamic_stats *Total, const struct dynamic_stats *Stats)
+{
+    Total->Calls += Stats->Calls;
+    Total->Nodes += Stats->Nodes;
+    Total->Terminals += Stats->Terminals;
+    Total->Probes += Stats->Probes;
+    Total->Hits += Stats->Hits;
+    Total->Misses += Stats->Misses;
+    Total->Stores += Stats->Stores;
+    Total->MaxDepth = (Stats->MaxDepth > Total->MaxDepth) ? Stats->MaxDepth : Total->MaxDepth;
+    Total->Nanoseconds += Stats->Nanoseconds;
+
+    return GST_SUCCESS;
+};
+
+/**
+ * @brief 
+ * Checks the recursive player against the table solver for every 
+ * target from 1 to maxTarget, every max advancement from 1 to 
+ * maxAdvancement, under normal and misere endings. Both use the same 
+ * integer rewards, so they have to agree on the exact reward of every 
+ * state, and Dynamic_AI has to pick a move worth as much as the one 
+ * in the table.
+ * 
+ * @param maxTarget The largest target in the sweep.
+ * @param maxAdvancement The largest max advancement in the sweep.
+ * @param Mismatches Pointer to a uint. Dynamic_Verify stores the number of disagreements here.
+ * @return GStatus GST_SUCCESS if every state agrees, GST_FAILURE otherwise.
+ */
+GStatus Dynamic_Verify(uint64_t maxTarget, uint64_t maxAdvancement, uint64_t *Mismatches)
+{
+    struct rules rules;
+    struct Dynamic Dynamic;
+    struct Actor Actor;
+    struct ttable table;
+    struct dynamic_stats stats;
+    uint64_t Target;
+    uint64_t MaxAdvancement;
+    uint64_t Score;
+    uint64_t Move;
+    uint64_t Checked = 0U;
+    int64_t Reward;
+    uint8_t Ending;
+    uint8_t MyTurn;
+
+    *Mismatches = 0U;
+    if (TTable_Init(&table, TTABLE_CAPACITY) != GST_SUCCESS)
+    {
+        return GST_FAILURE;
+    }
+
+    for (Ending = GAME_END_NORMAL; Ending <= GAME_END_MISERE; Ending++)
+    {
+        for (Target = 1U; Target <= maxTarget; Target++)
+        {
+            for (MaxAdvancement = 1U; MaxAdvancement <= maxAdvancement; MaxAdvancement++)
+            {
+                Game_InitRules(&rules, Target, MaxAdvancement);
+                rules.Ending = Ending;
+                if (Dynamic_InitTable(&Actor, &Dynamic, &rules) != GST_SUCCESS)
+                {
+                    Dynamic_Free(&Dynamic);
+                    TTable_Free(&table);
+                    return GST_FAILURE;
+                }
+
+                for (Score = 0U; Score < Target; Score++)
+                {
+                    for (MyTurn = 0U; MyTurn < 2U; MyTurn++)
+                    {
+                        Dynamic_Reward(&table, &rules, Score, 0U, MyTurn, &Reward, &stats);
+                        Checked++;
+                        if (Reward != Dynamic.Values[2U*Score + MyTurn])
+                        {
+                            (*Mismatches)++;
+                            printf("Mismatch: Target(%" PRIu64 "), MaxAdvancement(%" PRIu64 "), Ending(%u), Score(%" PRIu64 "), MyTurn(%u), Recursive(%" PRId64 "), Table(%" PRId64 ")\n",
+                                Target, MaxAdvancement, Ending, Score, MyTurn, Reward, Dynamic.Values[2U*Score + MyTurn]);
+                        }
+                    }
+
+                    Dynamic_AI(&table, &rules, Score, &Move, NULL);
+                    if (Dynamic.Values[2U*(Score + Move)] != Dynamic.Values[2U*(Score + Dynamic.Moves[Score])])
+                    {
+                        (*Mismatches)++;
+                        printf("Mismatch: Target(%" PRIu64 "), MaxAdvancement(%" PRIu64 "), Ending(%u), Score(%" PRIu64 "), Recursive Adds %" PRIu64 ", Table Adds %u\n",
+                            Target, MaxAdvancement, Ending, Score, Move, Dynamic.Moves[Score]);
+                    }
+                }
+
+                Dynamic_Free(&Dynamic);
+            }
+        }
+    }
+    TTable_Free(&table);
+
+    printf("Verified %" PRIu64 " recursive rewards, %" PRIu64 " mismatches\n", Checked, *Mismatches);
+
+    return (*Mismatches == 0U) ? GST_SUCCESS : GST_FAILURE;
+};
+
+/**
+ * @brief Moves a table value one ply further from the end of the game.
+ */
+static int64_t Dynamic_TowardsZero(int64_t Value)
+{
+    return (Value > 0) ? Value - 1 : Value + 1;
+}
+
+/**
+ * @brief 
+ * Starts the search of a state for Dynamic_Reward. Returns GST_SUCCESS 
+ * with the Reward when the state is the end of the game or in the 
+ * transposition table, otherwise GST_FAILURE with the Frame set up to 
+ * search its children.
+ */
+static GStatus Dynamic_Enter(ttable_t table, rules_t rules, uint64_t Score, uint64_t Depth, uint8_t MyTurn, struct dynamic_frame *Frame, int64_t *Reward, struct dynamic_stats *Stats)
+{
+    struct ttdata data;
+    int64_t plies;
+    int score = 0;
+
+    // The root of the search is the state moved from, its children are at Depth 0
+    Stats->Nodes++;
+    if (Depth + 1U > Stats->MaxDepth)
+    {
+        Stats->MaxDepth = Depth + 1U;
+    }
+
+    // If the current state is the last state in the game, return the result directly
+    if (Dynamic_Evaluate(rules, Score, MyTurn, &score) == GST_SUCCESS)
+    {
+        Stats->Terminals++;
+        *Reward = (score > 0) ? DYNAMIC_WIN_VALUE : -DYNAMIC_WIN_VALUE;
+        return GST_SUCCESS;
+    }
+
+    // Use the transposition table stored value, if it exists
+    Frame->Key = TTable_Key(rules, Score, MyTurn, 0U);
+    Stats->Probes++;
+    if (TTable_Probe(table, Frame->Key, &data) == GST_SUCCESS)
+    {
+        Stats->Hits++;
+        plies = data.Value.Score;
+        *Reward = data.Flags ? DYNAMIC_WIN_VALUE - plies : plies - DYNAMIC_WIN_VALUE;
+        TRACE_EVENT(.Event = TRACE_REWARD_HIT, .Score = Score, .Arg = Depth, .Value.Integer = *Reward);
+        return GST_SUCCESS;
+    }
+    Stats->Misses++;
+
+    Frame->Score = Score;
+    Frame->Legal = Game_LegalMoves(rules, rules->Target - Score);
+    Frame->Next = 0U;
+    Frame->Best = 1U;
+    // We take the largest reward, our opponent the smallest
+    Frame->Max = MyTurn ? INT64_MIN : INT64_MAX;
+    Frame->MyTurn = MyTurn;
+
+    return GST_FAILURE;
+}
+
+/**
+ * @brief 
+ * Finishes the search of a state once all its children are searched, 
+ * stores it in the transposition table and returns its reward.
+ */
+static int64_t Dynamic_Leave(ttable_t table, rules_t rules, struct dynamic_frame *Frame, uint64_t Depth, struct dynamic_stats *Stats)
+{
+    struct ttdata data;
+    int64_t plies;
+    // One ply further from the end moves the reward towards 0
+    int64_t Reward = Dynamic_TowardsZero(Frame->Max);
+
+    // Store the reward in the transposition table. States further from the
+    // target have larger subtrees, so they are kept over closer ones.
+    plies = (Reward > 0) ? DYNAMIC_WIN_VALUE - Reward : DYNAMIC_WIN_VALUE + Reward;
+    data.Value.Score = (plies <= INT32_MAX) ? (int32_t) plies : INT32_MAX;
+    data.Move = (Frame->Best <= UINT16_MAX) ? (uint16_t) Frame->Best : 0U;
+    data.Depth = (rules->Target - Frame->Score <= UINT8_MAX) ? (uint8_t) (rules->Target - Frame->Score) : UINT8_MAX;
+    data.Flags = (Reward > 0) ? 1U : 0U;
+    TTable_Store(table, Frame->Key, &data);
+    Stats->Stores++;
+
+    TRACE_EVENT(.Event = TRACE_REWARD, .Turn = Frame->MyTurn, .Score = Frame->Score, .Arg = Depth, .Value.Integer = Reward);
+
+    return Reward;
+}
+
+/**
+ * @brief Keeps the reward of a child if it is the best one of the Frame so far.
+ */
+static void Dynamic_Keep(struct dynamic_frame *Frame, uint64_t Advancement, int64_t Reward)
+{
+    // Here we want the smallest reward on the opponents turn, since a good reward for our opponent is bad for us
+    if (Frame->MyTurn ? (Reward > Frame->Max) : (Reward < Frame->Max))
+    {
+        Frame->Max = Reward;
+        Frame->Best = Advancement;
+    }
+}
+
 /*** end of file ***/
\ No newline at end of file
@@ -0,0 +1,440 @@
+/** @file grundy.c
+ * 
+ * @brief 
+ * A Sprague-Grundy player for games played on many counters at once.
+ * Every counter is an independent game, so the Grundy value of each
+ * score is worked out once, and a move is picked from the nim-sum of
+ * the values of the counters, in time linear in the number of counters
+ * instead of a search over every combination of their scores.
+ *
+ * @par       
+ * COPYRIGHT NOTICE: (c) 2021 Graham Power.  All rights reserved.
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */ 
+
+#include "grundy.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/************************** Constant Definitions *****************************/
+
+// The largest games Grundy_Verify searches exhaustively.
+#define GRUNDY_VERIFY_COUNTERS  3U
+#define GRUNDY_VERIFY_TARGET    10U
+#define GRUNDY_VERIFY_MOVES     4U
+
+/**************************** Type Definitions *******************************/
+
+/************************** Function Prototypes ******************************/
+
+static uint64_t Grundy_Index(rules_t rules, uint32_t counters, const uint64_t *States);
+static GStatus Grundy_VerifyRules(rules_t rules, uint64_t *Checked, uint64_t *Mismatches);
+
+/************************** Function Definitions *****************************/
+
+/**
+ * @brief 
+ * Initializes a Grundy controller Actor. The Grundy value of a score 
+ * is the smallest value none of its moves lead to, so they are worked 
+ * out here from the target back, once for every counter of every game 
+ * played with the rules. Ranges of moves have a closed form and need 
+ * no table.
+ * 
+ * @param Actor The actor who will use Grundy_Act to advance a game state. 
+ * @param Grundy The pointer to the grundy struct, used as a class-like representation.
+ * @param rules The rules of every counter of the games this instance will play.
+ * @return GStatus GST_FAILURE if the game doesn't end normally or the values could not be allocated, GST_SUCCESS otherwise.
+ */
+GStatus Grundy_Init(Actor_t Actor, grundy_t Grundy, rules_t rules)
+{
+    uint64_t *Seen;
+    uint64_t Distance;
+    uint64_t i;
+    uint32_t value;
+
+    Actor->Type = GRUNDY;
+    Actor->Action = Grundy_Act;
+    Actor->Choose = Grundy_Choose;
+    Actor->ActorBase = Grundy;
+
+    Grundy->Rules = *rules;
+    Grundy->Values = NULL;
+    if (rules->Ending != GAME_END_NORMAL)
+    {
+        return GST_FAILURE;
+    }
+    if (rules->Moves == NULL)
+    {
+        return GST_SUCCESS;
+    }
+
+    // Values never exceed the number of moves, so they fit in 32 bits
+    if (rules->MoveCount >= UINT32_MAX || rules->Target >= SIZE_MAX / sizeof(uint32_t))
+    {
+        return GST_FAILURE;
+    }
+    Grundy->Values = malloc((rules->Target + 1U)*sizeof(uint32_t));
+    Seen = calloc(rules->MoveCount + 1U, sizeof(uint64_t));
+    if (Grundy->Values == NULL || Seen == NULL)
+    {
+        free(Seen);
+        Grundy_Free(Grundy);
+        return GST_FAILURE;
+    }
+
+    // Seen[v] is Distance + 1 when a move from Distance reaches value v
+    for (Distance = 0U; Distance <= rules->Target; Distance++)
+    {
+        for (i = 0U; i < rules->MoveCount && rules->Moves[i] <= Distance; i++)
+        {
+            Seen[Grundy->Values[Distance - rules->Moves[i]]] = Distance + 1U;
+        }
+        for (value = 0U; Seen[value] == Distance + 1U; value++)
+        {
+        }
+        Grundy->Values[Distance] = value;
+    }
+    free(Seen);
+
+    return GST_SUCCESS;
+};
+
+/**
+ * @brief Releases the values allocated by Grundy_Init.
+ * 
+ * @param Grundy The pointer to the grundy struct to release.
+ * @return GStatus The success of the release.
+ */
+GStatus Grundy_Free(grundy_t Grundy)
+{
+    free(Grundy->Values);
+    Grundy->Values = NULL;
+
+    return GST_SUCCESS;
+};
+
+/**
+ * @brief 
+ * Takes an action of behalf of the Actor that called it, playing 
+ * the move picked by Grundy_Move.
+ * 
+ * @param game The game to take the action in.
+ * @param ActorBase The Actors base structure, a Grundy structure.
+ * @return GStatus The success of the action.
+ */
+GStatus Grundy_Act(game_t game, void *ActorBase)
+{
+    uint32_t Counter = 0U;
+    uint64_t Advancement = 1U;
+    Grundy_Move((grundy_t) ActorBase, game, &Counter, &Advancement);
+
+    if (game->Counters > 1U)
+    {
+        LOG_PRINTF(LOG_INFO, "Grundy AI Adds: %" PRIu64 " To Counter %" PRIu32 "\n", Advancement, Counter + 1U);
+    }
+    else
+    {
+        LOG_PRINTF(LOG_INFO, "Grundy AI Adds: %" PRIu64 "\n", Advancement);
+    }
+
+    return Game_AdvanceCounter(game, Counter, Advancement);
+};
+
+/**
+ * @brief 
+ * Calculates the move the Actor would take, without taking it. 
+ * Only games on one counter can be answered, since the advancement 
+ * alone doesn't say which counter it is for.
+ * 
+ * @param game The game to calculate the move in.
+ * @param ActorBase The Actors base structure, a Grundy structure.
+ * @param Advancement Pointer to a uint. Grundy_Choose stores the action to take here.
+ * @return GStatus GST_INVALID_STATE for games on many counters, GST_SUCCESS otherwise.
+ */
+GStatus Grundy_Choose(game_t game, void *ActorBase, uint64_t *Advancement)
+{
+    uint32_t Counter;
+
+    if (game->Counters != 1U)
+    {
+        *Advancement = 1U;
+        return GST_INVALID_STATE;
+    }
+
+    return (Grundy_Move((grundy_t) ActorBase, game, &Counter, Advancement) == GST_INVALID_STATE) ? GST_INVALID_STATE : GST_SUCCESS;
+};
+
+/**
+ * @brief Gets the Grundy value of a counter.
+ * 
+ * @param Grundy The pointer to the initialized grundy struct.
+ * @param Distance How far the counter is from the target, at most the target.
+ * @return uint64_t The Grundy value, 0 when the player to move on only this counter loses.
+ */
+uint64_t Grundy_Value(grundy_t Grundy, uint64_t Distance)
+{
+    if (Grundy->Values != NULL)
+    {
+        return Grundy->Values[Distance];
+    }
+
+    // Written so MaxAdvancement + 1 can only overflow when it isn't needed
+    return (Distance <= Grundy->Rules.MaxAdvancement) ? Distance : Distance % (Grundy->Rules.MaxAdvancement + 1U);
+};
+
+/**
+ * @brief 
+ * Picks the move to take in a game. The game is lost for the player 
+ * to move exactly when the nim-sum, the exclusive or of the Grundy 
+ * values of every counter, is 0. Otherwise some counter has a value 
+ * above its value xor the nim-sum, and moving it to a score with that 
+ * value leaves a nim-sum of 0 for the opponent. Such a move always 
+ * exists, since a score reaches every value below its own.
+ * 
+ * Costs one lookup per counter, and one pass over the moves of the 
+ * counter moved on. Lost games play the smallest move on the first 
+ * counter that has one.
+ * 
+ * @param Grundy The pointer to the initialized grundy struct.
+ * @param game The game to pick the move in.
+ * @param Counter Pointer to a uint. Grundy_Move stores the counter to advance here.
+ * @param Advancement Pointer to a uint. Grundy_Move stores the advancement here.
+ * @return GStatus GST_INVALID_STATE if the game has other rules or no move, GST_FAILURE if it is lost, GST_SUCCESS otherwise.
+ */
+GStatus Grundy_Move(grundy_t Grundy, game_t game, uint32_t *Counter, uint64_t *Advancement)
+{
+    rules_t rules = game->Rules;
+    uint64_t sum = 0U;
+    uint64_t value;
+    uint64_t want;
+    uint64_t Distance;
+    uint64_t i;
+    uint32_t c;
+
+    *Counter = 0U;
+    *Advancement = RULES_MOVE(rules, 0U);
+    if (rules->Target != Grundy->Rules.Target || rules->MaxAdvancement != Grundy->Rules.MaxAdvancement ||
+        rules->MoveHash != Grundy->Rules.MoveHash || rules->Ending != Grundy->Rules.Ending)
+    {
+        return GST_INVALID_STATE;
+    }
+
+    for (c = 0U; c < game->Counters; c++)
+    {
+        sum ^= Grundy_Value(Grundy, rules->Target - GAME_COUNTER(game, c));
+    }
+
+    for (c = 0U; c < game->Counters && sum != 0U; c++)
+    {
+        Distance = rules->Target - GAME_COUNTER(game, c);
+        value = Grundy_Value(Grundy, Distance);
+        want = value ^ sum;
+        if (want >= value)
+        {
+            continue;
+        }
+
+        *Counter = c;
+        if (Grundy->Values == NULL)
+        {
+            *Advancement = value - want;
+            return GST_SUCCESS;
+        }
+        for (i = 0U; i < rules->MoveCount && rules->Moves[i] <= Distance; i++)
+        {
+            if (Grundy->Values[Distance - rules->Moves[i]] == want)
+            {
+                *Advancement = rules->Moves[i];
+                return GST_SUCCESS;
+            }
+        }
+    }
+
+    for (c = 0U; c < game->Counters; c++)
+    {
+        if (rules->Target - GAME_COUNTER(game, c) >= RULES_MOVE(rules, 0U))
+        {
+            *Counter = c;
+            return GST_FAILURE;
+        }
+    }
+
+    return GST_INVALID_STATE;
+};
+
+/**
+ * @brief 
+ * Checks Grundy_Move against an exhaustive search over every 
+ * combination of scores, on up to GRUNDY_VERIFY_COUNTERS counters. 
+ * The nim-sum has to be non-zero exactly in the won combinations, 
+ * and the move picked from them has to lead to a lost one. Checked 
+ * for every target up to maxTarget and range of moves up to 
+ * maxAdvancement, capped so the search stays small, and a few 
+ * sparse sets of moves.
+ * 
+ * @param maxTarget The largest target to check.
+ * @param maxAdvancement The largest range of moves to check.
+ * @param Mismatches Pointer to a uint. Grundy_Verify stores the number of disagreements here.
+ * @return GStatus GST_SUCCESS if every combination agrees, GST_FAILURE otherwise.
+ */
+GStatus Grundy_Verify(uint64_t maxTarget, uint64_t maxAdvancement, uint64_t *Mismatches)
+{
+    static const uint64_t Sparse[][3] = {
+        { 1U, 3U, 7U },
+        { 2U, 5U },
+        { 1U, 4U },
+    };
+    static const uint64_t SparseCounts[] = { 3U, 2U, 2U };
+    struct rules rules;
+    uint64_t Checked = 0U;
+    uint64_t Target;
+    uint64_t MaxAdvancement;
+    uint32_t s;
+
+    *Mismatches = 0U;
+    maxTarget = (maxTarget < GRUNDY_VERIFY_TARGET) ? maxTarget : GRUNDY_VERIFY_TARGET;
+    maxAdvancement = (maxAdvancement < GRUNDY_VERIFY_MOVES) ? maxAdvancement : GRUNDY_VERIFY_MOVES;
+
+    for (Target = 1U; Target <= maxTarget; Target++)
+    {
+        for (MaxAdvancement = 1U; MaxAdvancement <= maxAdvancement; MaxAdvancement++)
+        {
+            Game_InitRules(&rules, Target, MaxAdvancement);
+            if (Grundy_VerifyRules(&rules, &Checked, Mismatches) != GST_SUCCESS)
+            {
+                return GST_FAILURE;
+            }
+        }
+        for (s = 0U; s < sizeof(SparseCounts)/sizeof(SparseCounts[0]); s++)
+        {
+            if (Game_InitMoveSet(&rules, Target, Sparse[s], SparseCounts[s]) == GST_SUCCESS &&
+                Grundy_VerifyRules(&rules, &Checked, Mismatches) != GST_SUCCESS)
+            {
+                return GST_FAILURE;
+            }
+        }
+    }
+
+    printf("Verified %" PRIu64 " grundy positions, %" PRIu64 " mismatches\n", Checked, *Mismatches);
+
+    return (*Mismatches == 0U) ? GST_SUCCESS : GST_FAILURE;
+};
+
+/**
+ * @brief 
+ * Checks every combination of scores of 1 to GRUNDY_VERIFY_COUNTERS 
+ * counters with one set of rules, see Grundy_Verify.
+ */
+static GStatus Grundy_VerifyRules(rules_t rules, uint64_t *Checked, uint64_t *Mismatches)
+{
+    struct Grundy Grundy;
+    struct Actor Actor;
+    struct game game;
+    uint64_t States[GRUNDY_VERIFY_COUNTERS];
+    uint64_t Combinations;
+    uint64_t Index;
+    uint64_t rest;
+    uint64_t Advancement;
+    uint32_t counters;
+    uint32_t Counter;
+    uint32_t c;
+    int8_t *Won;
+    GStatus Wins;
+
+    if (Grundy_Init(&Actor, &Grundy, rules) != GST_SUCCESS)
+    {
+        return GST_FAILURE;
+    }
+
+    for (counters = 1U; counters <= GRUNDY_VERIFY_COUNTERS; counters++)
+    {
+        for (Combinations = 1U, c = 0U; c < counters; c++)
+        {
+            Combinations *= rules->Target + 1U;
+        }
+        Won = malloc(Combinations);
+        if (Won == NULL)
+        {
+            Grundy_Free(&Grundy);
+            return GST_FAILURE;
+        }
+        memset(Won, -1, Combinations);
+
+        memset(&game, 0, sizeof(game));
+        game.States = States;
+        game.Counters = counters;
+        game.Rules = rules;
+        for (Index = 0U; Index < Combinations; Index++)
+        {
+            for (rest = Index, c = 0U; c < counters; c++)
+            {
+                States[c] = rest % (rules->Target + 1U);
+                rest /= rules->Target + 1U;
+            }
+
+            Wins = Grundy_Move(&Grundy, &game, &Counter, &Advancement);
+            (*Checked)++;
+            if ((Wins == GST_SUCCESS) != Game_Search(rules, counters, States, Won, Index))
+            {
+                (*Mismatches)++;
+                printf("Mismatch: Counters(%" PRIu32 "), Target(%" PRIu64 "), MaxAdvancement(%" PRIu64 "), Position(%" PRIu64 ")\n",
+                    counters, rules->Target, rules->MaxAdvancement, Index);
+                continue;
+            }
+            if (Wins != GST_SUCCESS)
+            {
+                continue;
+            }
+
+            // The winning move has to be legal and leave a lost position
+            if (!Game_IsLegalMove(rules, Advancement) || Advancement > rules->Target - States[Counter])
+            {
+                (*Mismatches)++;
+                printf("Mismatch: Counters(%" PRIu32 "), Target(%" PRIu64 "), Position(%" PRIu64 "), Illegal Move %" PRIu64 "\n",
+                    counters, rules->Target, Index, Advancement);
+                continue;
+            }
+            States[Counter] += Advancement;
+            if (Game_Search(rules, counters, States, Won, Grundy_Index(rules, counters, States)))
+            {
+                (*Mismatches)++;
+                printf("Mismatch: Counters(%" PRIu32 "), Target(%" PRIu64 "), Position(%" PRIu64 "), Grundy Adds %" PRIu64 " To Counter %" PRIu32 "\n",
+                    counters, rules->Target, Index, Advancement, Counter);
+            }
+        }
+        free(Won);
+    }
+    Grundy_Free(&Grundy);
+
+    return GST_SUCCESS;
+}
+
+/**
+ * @brief Gets the index of a combination of scores, the scores as digits in base Target + 1.
+ */
+static uint64_t Grundy_Index(rules_t rules, uint32_t counters, const uint64_t *States)
+{
+    uint64_t Index = 0U;
+    uint32_t c;
+
+    for (c = counters; c-- > 0U; )
+    {
+        Index = Index*(rules->Target + 1U) + States[c];
+    }
+
+    return Index;
+}
+
+/*** end of file ***/
@@ -0,0 +1,508 @@
+/** @file mcts.c
+ * 
+ * @brief 
+ * A Monte Carlo tree search player. States are scored by the results of
+ * random games played out from them, and the tree grows towards the
+ * moves that win most often by UCT selection. Playouts run in parallel
+ * on a thread pool, sharing one tree held in a preallocated arena.
+ *
+ * @par       
+ * COPYRIGHT NOTICE: (c) 2021 Graham Power.  All rights reserved.
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */ 
+
+#include "mcts.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "clock.h"
+
+/************************** Constant Definitions *****************************/
+
+/**************************** Type Definitions *******************************/
+
+
+/************************** Function Prototypes ******************************/
+
+static void Mcts_Playouts(threadpool_t pool, uint32_t Worker, void *Arg);
+static void Mcts_Playout(mcts_t Mcts, struct mcts_worker *worker);
+static uint32_t Mcts_Expand(mcts_t Mcts, struct mcts_node *node, const uint64_t *Scores);
+static uint32_t Mcts_Select(mcts_t Mcts, struct mcts_node *node);
+static uint8_t Mcts_Rollout(mcts_t Mcts, struct mcts_worker *worker);
+
+/************************** Function Definitions *****************************/
+
+/**
+ * @brief 
+ * Initializes a Monte Carlo tree search controller Actor. The arena 
+ * and the thread pool are allocated here, once, and every search 
+ * reuses them. A search stops after Iterations playouts or Budget 
+ * microseconds, whichever comes first, or after MCTS_ITERATIONS 
+ * playouts when neither is set.
+ * 
+ * @param Actor The actor who will use Mcts_Act to advance a game state. 
+ * @param Mcts The pointer to the mcts struct, used as a class-like representation.
+ * @param Iterations The playouts every move may take, 0 for no limit.
+ * @param Budget The microseconds every move may take, 0 for no limit.
+ * @param Threads The threads playouts run on, 0 for one per core.
+ * @param Seed The seed of the random number generator of the first thread, the others use the next seeds.
+ * @return GStatus GST_FAILURE if the arena or threads could not be allocated, GST_SUCCESS otherwise.
+ */
+GStatus Mcts_Init(Actor_t Actor, mcts_t Mcts, uint64_t Iterations, uint64_t Budget, uint32_t Threads, uint64_t Seed)
+{
+    uint32_t i;
+
+    Actor->Type = MCTS;
+    Actor->Action = Mcts_Act;
+    Actor->Choose = Mcts_Choose;
+    Actor->ActorBase = Mcts;
+
+    memset(Mcts, 0, sizeof(*Mcts));
+    Mcts->Iterations = (Iterations == 0U && Budget == 0U) ? MCTS_ITERATIONS : Iterations;
+    Mcts->Budget = Budget;
+    Mcts->Capacity = MCTS_ARENA_NODES;
+
+    if (ThreadPool_Init(&Mcts->Pool, Threads, 1U) != GST_SUCCESS)
+    {
+        return GST_FAILURE;
+    }
+    Mcts->Nodes = malloc(Mcts->Capacity*sizeof(struct mcts_node));
+    Mcts->Workers = calloc(Mcts->Pool.Threads, sizeof(struct mcts_worker));
+    if (Mcts->Nodes == NULL || Mcts->Workers == NULL)
+    {
+        return GST_FAILURE;
+    }
+
+    // A path never holds more nodes than the arena
+    for (i = 0U; i < Mcts->Pool.Threads; i++)
+    {
+        Mcts->Workers[i].Path = malloc(Mcts->Capacity*sizeof(uint32_t));
+        if (Mcts->Workers[i].Path == NULL)
+        {
+            return GST_FAILURE;
+        }
+    }
+
+    return Mcts_Reseed(Mcts, Seed);
+};
+
+/**
+ * @brief Releases everything Mcts_Init and Mcts_Search allocated.
+ * 
+ * @param Mcts The pointer to the mcts struct to release.
+ * @return GStatus The success of the release.
+ */
+GStatus Mcts_Free(mcts_t Mcts)
+{
+    uint32_t i;
+
+    for (i = 0U; Mcts->Workers != NULL && i < Mcts->Pool.Threads; i++)
+    {
+        free(Mcts->Workers[i].Path);
+        free(Mcts->Workers[i].Scores);
+    }
+    free(Mcts->Workers);
+    free(Mcts->Nodes);
+    free(Mcts->Root);
+    ThreadPool_Free(&Mcts->Pool);
+    Mcts->Workers = NULL;
+    Mcts->Nodes = NULL;
+    Mcts->Root = NULL;
+    Mcts->Counters = 0U;
+
+    return GST_SUCCESS;
+};
+
+/**
+ * @brief Restarts the random number generators of every thread.
+ * 
+ * @param Mcts The pointer to the initialized mcts struct.
+ * @param Seed The seed of the first thread, the others use the next seeds.
+ * @return GStatus The success of the reseed.
+ */
+GStatus Mcts_Reseed(mcts_t Mcts, uint64_t Seed)
+{
+    uint32_t i;
+
+    for (i = 0U; i < Mcts->Pool.Threads; i++)
+    {
+        // xorshift gets stuck on a state of 0
+        Mcts->Workers[i].Random.State = (Seed + i == 0U) ? 0x9E3779B97F4A7C15ULL : Seed + i;
+    }
+
+    return GST_SUCCESS;
+};
+
+/**
+ * @brief 
+ * Takes an action of behalf of the Actor that called it, playing 
+ * the move the most playouts went through.
+ * 
+ * @param game The game to take the action in.
+ * @param ActorBase The Actors base structure, an Mcts structure.
+ * @return GStatus The success of the action.
+ */
+GStatus Mcts_Act(game_t game, void *ActorBase)
+{
+    mcts_t Mcts = (mcts_t) ActorBase;
+    uint32_t Counter = 0U;
+    uint64_t Advancement = 1U;
+    double WinRate = 0.0;
+    Mcts_Search(Mcts, game, &Counter, &Advancement, &WinRate);
+
+    if (game->Counters > 1U)
+    {
+        LOG_PRINTF(LOG_INFO, "MCTS AI Adds: %" PRIu64 " To Counter %" PRIu32 "\n", Advancement, Counter + 1U);
+    }
+    else
+    {
+        LOG_PRINTF(LOG_INFO, "MCTS AI Adds: %" PRIu64 "\n", Advancement);
+    }
+    LOG_PRINTF(LOG_DEBUG, "Move: %" PRIu32 " playouts, %" PRIu64 " nodes, %.3f win rate\n",
+        atomic_load(&Mcts->Nodes[0].Visits), atomic_load(&Mcts->Used), WinRate);
+
+    return Game_AdvanceCounter(game, Counter, Advancement);
+};
+
+/**
+ * @brief 
+ * Calculates the move the Actor would take, without taking it. 
+ * Only games on one counter can be answered, since the advancement 
+ * alone doesn't say which counter it is for.
+ * 
+ * @param game The game to calculate the move in.
+ * @param ActorBase The Actors base structure, an Mcts structure.
+ * @param Advancement Pointer to a uint. Mcts_Choose stores the action to take here.
+ * @return GStatus GST_INVALID_STATE for games on many counters, the success of the search otherwise.
+ */
+GStatus Mcts_Choose(game_t game, void *ActorBase, uint64_t *Advancement)
+{
+    uint32_t Counter;
+    double WinRate;
+
+    if (game->Counters != 1U)
+    {
+        *Advancement = 1U;
+        return GST_INVALID_STATE;
+    }
+
+    return Mcts_Search((mcts_t) ActorBase, game, &Counter, Advancement, &WinRate);
+};
+
+/**
+ * @brief 
+ * Grows a new tree from the state of a game and picks the move the 
+ * most playouts went through. Every thread of the pool selects a path 
+ * down the shared tree by UCT, adds the children of the node it ends 
+ * on, plays a random game out from there and counts the result on the 
+ * way back up. Counts are atomic, so threads never wait on each other, 
+ * and a thread's virtual loss on its path steers the others elsewhere 
+ * until its result is in. Once the arena is full the tree stops 
+ * growing, and the remaining playouts start from its leaves.
+ * 
+ * @param Mcts The pointer to the initialized mcts struct.
+ * @param game The game to pick the move in.
+ * @param Counter Pointer to a uint. Mcts_Search stores the counter to advance here.
+ * @param Advancement Pointer to a uint. Mcts_Search stores the advancement here.
+ * @param WinRate Pointer to a double. Mcts_Search stores the share of the playouts through the move won by the player to move here.
+ * @return GStatus GST_INVALID_STATE if there is no move, GST_FAILURE if the storage could not be allocated, GST_SUCCESS otherwise.
+ */
+GStatus Mcts_Search(mcts_t Mcts, game_t game, uint32_t *Counter, uint64_t *Advancement, double *WinRate)
+{
+    rules_t rules = game->Rules;
+    struct mcts_node *root = &Mcts->Nodes[0];
+    struct mcts_node *child;
+    uint32_t children;
+    uint32_t best = 0U;
+    uint32_t visits;
+    uint32_t i;
+    uint8_t moverWins;
+    uint64_t start;
+    GStatus Status = GST_SUCCESS;
+
+    *Counter = 0U;
+    *Advancement = RULES_MOVE(rules, 0U);
+    *WinRate = 0.0;
+
+    if (Mcts->Counters != game->Counters)
+    {
+        for (i = 0U; i < Mcts->Pool.Threads; i++)
+        {
+            free(Mcts->Workers[i].Scores);
+            Mcts->Workers[i].Scores = malloc(game->Counters*sizeof(uint64_t));
+            Status = (Mcts->Workers[i].Scores == NULL) ? GST_FAILURE : Status;
+        }
+        free(Mcts->Root);
+        Mcts->Root = malloc(game->Counters*sizeof(uint64_t));
+        Mcts->Counters = (Mcts->Root == NULL || Status != GST_SUCCESS) ? 0U : game->Counters;
+        if (Mcts->Counters == 0U)
+        {
+            return GST_FAILURE;
+        }
+    }
+    Mcts->Rules = rules;
+    for (i = 0U; i < game->Counters; i++)
+    {
+        Mcts->Root[i] = GAME_COUNTER(game, i);
+    }
+    if (Game_IsOver(rules, Mcts->Root, Mcts->Counters, &moverWins))
+    {
+        return GST_INVALID_STATE;
+    }
+
+    memset(root, 0, sizeof(*root));
+    atomic_init(&Mcts->Used, 1U);
+    atomic_init(&Mcts->Started, 0U);
+    start = Clock_Nanoseconds();
+    Mcts->Deadline = (Mcts->Budget == 0U || Mcts->Budget >= (UINT64_MAX - start) / 1000U) ? UINT64_MAX : start + Mcts->Budget*1000U;
+
+    for (i = 0U; i < Mcts->Pool.Threads; i++)
+    {
+        Mcts->Workers[i].Task.Run = Mcts_Playouts;
+        Mcts->Workers[i].Task.Arg = Mcts;
+        ThreadPool_Submit(&Mcts->Pool, &Mcts->Workers[i].Task);
+    }
+    Status = ThreadPool_Run(&Mcts->Pool);
+
+    // The most visited move is the one the search trusts most, its win rate may be noisier
+    children = atomic_load_explicit(&root->Children, memory_order_acquire);
+    if (children == 0U || children == MCTS_EXPANDING)
+    {
+        Mcts_Expand(Mcts, root, Mcts->Root);
+        children = atomic_load_explicit(&root->Children, memory_order_acquire);
+        if (children == MCTS_EXPANDING)
+        {
+            return GST_FAILURE;
+        }
+    }
+    for (i = 1U; i < root->ChildCount; i++)
+    {
+        if (atomic_load(&Mcts->Nodes[children + i].Visits) > atomic_load(&Mcts->Nodes[children + best].Visits))
+        {
+            best = i;
+        }
+    }
+    child = &Mcts->Nodes[children + best];
+    visits = atomic_load(&child->Visits);
+    *Counter = child->Counter;
+    *Advancement = child->Advancement;
+    *WinRate = (visits > 0U) ? (double) atomic_load(&child->Wins) / visits : 0.0;
+
+    return Status;
+};
+
+/**
+ * @brief The task of one worker, plays out games until the search runs out of playouts or time.
+ */
+static void Mcts_Playouts(threadpool_t pool, uint32_t Worker, void *Arg)
+{
+    mcts_t Mcts = (mcts_t) Arg;
+    (void) pool;
+
+    while ((Mcts->Iterations == 0U || atomic_fetch_add_explicit(&Mcts->Started, 1U, memory_order_relaxed) < Mcts->Iterations) &&
+        (Mcts->Deadline == UINT64_MAX || Clock_Nanoseconds() < Mcts->Deadline))
+    {
+        Mcts_Playout(Mcts, &Mcts->Workers[Worker]);
+    }
+}
+
+/**
+ * @brief Selects a path from the root, expands its last node, plays a game out from it and counts the result.
+ */
+static void Mcts_Playout(mcts_t Mcts, struct mcts_worker *worker)
+{
+    struct mcts_node *Nodes = Mcts->Nodes;
+    struct mcts_node *node = &Nodes[0];
+    uint32_t depth = 0U;
+    uint32_t index;
+    uint32_t children;
+    uint8_t moverWins;
+    uint8_t won;
+
+    memcpy(worker->Scores, Mcts->Root, Mcts->Counters*sizeof(uint64_t));
+    worker->Path[0] = 0U;
+    atomic_fetch_add_explicit(&node->Virtual, 1U, memory_order_relaxed);
+
+    while (!Game_IsOver(Mcts->Rules, worker->Scores, Mcts->Counters, &moverWins) && depth + 1U < Mcts->Capacity)
+    {
+        children = atomic_load_explicit(&node->Children, memory_order_acquire);
+        if (children == 0U)
+        {
+            children = Mcts_Expand(Mcts, node, worker->Scores);
+        }
+        if (children == MCTS_EXPANDING)
+        {
+            break;
+        }
+
+        index = children + Mcts_Select(Mcts, node);
+        node = &Nodes[index];
+        worker->Scores[node->Counter] += node->Advancement;
+        worker->Path[++depth] = index;
+        atomic_fetch_add_explicit(&node->Virtual, 1U, memory_order_relaxed);
+    }
+
+    // Whether the player to move at the end of the path wins, then the results of the moves along it
+    won = !Mcts_Rollout(Mcts, worker);
+    for (;;)
+    {
+        node = &Nodes[worker->Path[depth]];
+        atomic_fetch_add_explicit(&node->Visits, 1U, memory_order_relaxed);
+        atomic_fetch_add_explicit(&node->Wins, won, memory_order_relaxed);
+        atomic_fetch_sub_explicit(&node->Virtual, 1U, memory_order_relaxed);
+        if (depth-- == 0U)
+        {
+            break;
+        }
+        won = !won;
+    }
+}
+
+/**
+ * @brief 
+ * Adds the children of a node, one for every move from Scores. Only 
+ * the thread that marks the node MCTS_EXPANDING first allocates them, 
+ * the others play out from the node. Nodes the arena has no room for 
+ * stay marked, and are leaves for the rest of the search.
+ * 
+ * @return uint32_t The arena index of the first child, or MCTS_EXPANDING if there are none (yet).
+ */
+static uint32_t Mcts_Expand(mcts_t Mcts, struct mcts_node *node, const uint64_t *Scores)
+{
+    rules_t rules = Mcts->Rules;
+    struct mcts_node *child;
+    uint32_t expected = 0U;
+    uint64_t count = 0U;
+    uint64_t legal;
+    uint64_t first;
+    uint64_t i;
+    uint32_t c;
+
+    if (!atomic_compare_exchange_strong_explicit(&node->Children, &expected, MCTS_EXPANDING, memory_order_acq_rel, memory_order_acquire))
+    {
+        return expected;
+    }
+
+    for (c = 0U; c < Mcts->Counters; c++)
+    {
+        count += Game_IsRepeated(Scores, c) ? 0U : Game_LegalMoves(rules, rules->Target - Scores[c]);
+    }
+    // Used only grows, so once it passes the capacity no thread allocates again
+    if (count == 0U || atomic_load_explicit(&Mcts->Used, memory_order_relaxed) + count > Mcts->Capacity)
+    {
+        return MCTS_EXPANDING;
+    }
+    first = atomic_fetch_add_explicit(&Mcts->Used, count, memory_order_relaxed);
+    if (first + count > Mcts->Capacity)
+    {
+        return MCTS_EXPANDING;
+    }
+
+    child = &Mcts->Nodes[first];
+    for (c = 0U; c < Mcts->Counters; c++)
+    {
+        legal = Game_IsRepeated(Scores, c) ? 0U : Game_LegalMoves(rules, rules->Target - Scores[c]);
+        for (i = 0U; i < legal; i++, child++)
+        {
+            atomic_init(&child->Visits, 0U);
+            atomic_init(&child->Wins, 0U);
+            atomic_init(&child->Virtual, 0U);
+            atomic_init(&child->Children, 0U);
+            child->ChildCount = 0U;
+            child->Counter = c;
+            child->Advancement = RULES_MOVE(rules, i);
+        }
+    }
+    node->ChildCount = (uint32_t) count;
+    atomic_store_explicit(&node->Children, (uint32_t) first, memory_order_release);
+
+    return (uint32_t) first;
+}
+
+/**
+ * @brief 
+ * Picks the child of an expanded node with the highest upper 
+ * confidence bound, its win rate plus MCTS_EXPLORATION times 
+ * sqrt(ln(parent visits) / visits). Unvisited children come first. 
+ * Virtual losses count as visits that weren't won.
+ */
+static uint32_t Mcts_Select(mcts_t Mcts, struct mcts_node *node)
+{
+    struct mcts_node *children = &Mcts->Nodes[atomic_load_explicit(&node->Children, memory_order_acquire)];
+    double logParent = log((double) (atomic_load_explicit(&node->Visits, memory_order_relaxed) +
+        atomic_load_explicit(&node->Virtual, memory_order_relaxed)) + 1.0);
+    double bound;
+    double best = -1.0;
+    uint32_t pick = 0U;
+    uint32_t visits;
+    uint32_t i;
+
+    for (i = 0U; i < node->ChildCount; i++)
+    {
+        visits = atomic_load_explicit(&children[i].Visits, memory_order_relaxed) +
+            atomic_load_explicit(&children[i].Virtual, memory_order_relaxed);
+        if (visits == 0U)
+        {
+            return i;
+        }
+        bound = (double) atomic_load_explicit(&children[i].Wins, memory_order_relaxed) / visits +
+            MCTS_EXPLORATION*sqrt(logParent / visits);
+        if (bound > best)
+        {
+            best = bound;
+            pick = i;
+        }
+    }
+
+    return pick;
+}
+
+/**
+ * @brief 
+ * Plays random moves from the worker's Scores until the game is over. 
+ * Returns whether the player to move at the start wins.
+ */
+static uint8_t Mcts_Rollout(mcts_t Mcts, struct mcts_worker *worker)
+{
+    rules_t rules = Mcts->Rules;
+    uint64_t *Scores = worker->Scores;
+    uint32_t counters = Mcts->Counters;
+    uint64_t legal = 0U;
+    uint32_t c;
+    uint32_t i;
+    uint8_t moverWins;
+    uint8_t flipped = 0U;
+
+    while (!Game_IsOver(rules, Scores, counters, &moverWins))
+    {
+        // Start from a random counter and take the first with a move left
+        c = (uint32_t) (Random_Next(&worker->Random) % counters);
+        for (i = 0U; i < counters; i++, c = (c + 1U == counters) ? 0U : c + 1U)
+        {
+            legal = Game_LegalMoves(rules, rules->Target - Scores[c]);
+            if (legal > 0U)
+            {
+                break;
+            }
+        }
+        Scores[c] += RULES_MOVE(rules, Random_Next(&worker->Random) % legal);
+        flipped ^= 1U;
+    }
+
+    return moverWins ^ flipped;
+}
+
+/*** end of file ***/
@@ -0,0 +1,519 @@
+/** @file query.c
+ * 
+ * @brief 
+ * Answers batches of best move queries, each a score under its own rules.
+ * Queries are grouped by their rules so every solved Dynamic table is
+ * looked up for all of its queries in one pass, and tables are kept
+ * between batches.
+ *
+ * @par       
+ * COPYRIGHT NOTICE: (c) 2021 Graham Power.  All rights reserved.
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */ 
+
+#include "query.h"
+#include "ttable.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/************************** Constant Definitions *****************************/
+
+#if defined(__GNUC__)
+#define QUERY_PREFETCH(Address)     __builtin_prefetch(Address)
+#else
+#define QUERY_PREFETCH(Address)     ((void) (Address))
+#endif
+
+/**************************** Type Definitions *******************************/
+
+/************************** Function Prototypes ******************************/
+
+static GStatus Query_Grow(query_t Query, uint64_t Count);
+static GStatus Query_AddGroup(query_t Query, uint32_t Groups);
+static GStatus Query_Table(query_t Query, rules_t rules, uint64_t Key, struct query_table **Table);
+static uint8_t Query_SameRules(rules_t a, rules_t b);
+
+/************************** Function Definitions *****************************/
+
+/**
+ * @brief 
+ * Initializes an empty batch query. Tables are solved the first time 
+ * a batch asks about their rules, and kept for the batches after it.
+ * 
+ * @param Query The pointer to the query struct, used as a class-like representation.
+ * @param Tables The most solved tables kept, 0 for QUERY_CACHE_TABLES.
+ * @return GStatus GST_FAILURE if the table slots could not be allocated, GST_SUCCESS otherwise.
+ */
+GStatus Query_Init(query_t Query, uint32_t Tables)
+{
+    memset(Query, 0, sizeof(*Query));
+    Query->TableCapacity = (Tables == 0U) ? QUERY_CACHE_TABLES : Tables;
+    Query->Tables = calloc(Query->TableCapacity, sizeof(struct query_table));
+
+    return (Query->Tables == NULL) ? GST_FAILURE : GST_SUCCESS;
+};
+
+/**
+ * @brief Releases every table and buffer of the query.
+ * 
+ * @param Query The pointer to the query struct to release.
+ * @return GStatus The success of the release.
+ */
+GStatus Query_Free(query_t Query)
+{
+    uint32_t i;
+
+    for (i = 0U; Query->Tables != NULL && i < Query->TableCount; i++)
+    {
+        Dynamic_Free(&Query->Tables[i].Dynamic);
+        free(Query->Tables[i].Moves);
+    }
+    free(Query->Tables);
+    free(Query->Groups);
+    free(Query->Group);
+    free(Query->Order);
+    Query->Tables = NULL;
+    Query->Groups = NULL;
+    Query->Group = NULL;
+    Query->Order = NULL;
+    Query->TableCount = 0U;
+    Query->GroupCapacity = 0U;
+    Query->OrderCapacity = 0U;
+
+    return GST_SUCCESS;
+};
+
+/**
+ * @brief 
+ * Finds the best move and its value for every query of a batch. 
+ * 
+ * The queries are grouped by their rules with a counting sort, so 
+ * each group is answered from one solved table in one pass, with 
+ * the table entries of the query QUERY_PREFETCH_DISTANCE ahead 
+ * prefetched. Once its table is solved a query costs two loads and 
+ * no branches, however many other rules the batch mixes in.
+ * 
+ * Values are those of the Dynamic table for the player to move, a 
+ * state won or lost in Plies is +-(DYNAMIC_WIN_VALUE - Plies). Scores 
+ * at or past the target have no move, and are answered with a move 
+ * and value of 0.
+ * 
+ * A query can only be used by one thread at a time.
+ * 
+ * @param Query The pointer to the query struct.
+ * @param Queries The positions to answer.
+ * @param Count The number of queries.
+ * @param Moves Array of Count uints. Query_Batch stores the move of each query here.
+ * @param Values Array of Count ints. Query_Batch stores the value of each query here.
+ * @return GStatus 
+ * GST_FAILURE if a table or the scratch arrays could not be allocated, 
+ * GST_INVALID_STATE if a score has no move, GST_SUCCESS otherwise.
+ */
+GStatus Query_Batch(query_t Query, const struct query *Queries, uint64_t Count, uint64_t *Moves, int64_t *Values)
+{
+    struct query_group *group = NULL;
+    struct query_table *table;
+    const int64_t *values;
+    const uint32_t *moves;
+    const uint64_t *order;
+    uint64_t key;
+    uint64_t target;
+    uint64_t score;
+    uint64_t valid;
+    uint64_t invalid = 0U;
+    uint64_t start;
+    uint64_t i;
+    uint64_t j;
+    uint32_t groups = 0U;
+    uint32_t g;
+    GStatus Status = GST_SUCCESS;
+
+    if (Query_Grow(Query, Count) != GST_SUCCESS)
+    {
+        return GST_FAILURE;
+    }
+    Query->Batches++;
+
+    // A batch has few enough rules to search them in order. Queries
+    // usually pass the same rules as an earlier one, so they are
+    // matched by address before they are hashed and compared.
+    for (i = 0U; i < Count; i++)
+    {
+        if (group == NULL || Queries[i].Rules != group->Rules)
+        {
+            g = 0U;
+            while (g < groups && Query->Groups[g].Rules != Queries[i].Rules)
+            {
+                g++;
+            }
+            if (g == groups)
+            {
+                key = TTable_Key(Queries[i].Rules, 0U, 0U, 0U);
+                for (g = 0U; g < groups; g++)
+                {
+                    if (Query->Groups[g].Key == key && Query_SameRules(Query->Groups[g].Rules, Queries[i].Rules))
+                    {
+                        break;
+                    }
+                }
+            }
+            if (g == groups)
+            {
+                if (Query_AddGroup(Query, groups) != GST_SUCCESS)
+                {
+                    return GST_FAILURE;
+                }
+                Query->Groups[g].Key = key;
+                Query->Groups[g].Rules = Queries[i].Rules;
+                Query->Groups[g].Count = 0U;
+                groups++;
+            }
+            group = &Query->Groups[g];
+        }
+        Query->Group[i] = (uint32_t) (group - Query->Groups);
+        group->Count++;
+    }
+
+    // Counting sort of the queries by group
+    for (g = 0U, start = 0U; g < groups; g++)
+    {
+        Query->Groups[g].Start = start;
+        start += Query->Groups[g].Count;
+        Query->Groups[g].Count = 0U;
+    }
+    for (i = 0U; i < Count; i++)
+    {
+        group = &Query->Groups[Query->Group[i]];
+        Query->Order[group->Start + group->Count++] = i;
+    }
+
+    for (g = 0U; g < groups; g++)
+    {
+        group = &Query->Groups[g];
+        order = &Query->Order[group->Start];
+        if (Query_Table(Query, group->Rules, group->Key, &table) != GST_SUCCESS)
+        {
+            for (j = 0U; j < group->Count; j++)
+            {
+                Moves[order[j]] = 0U;
+                Values[order[j]] = 0;
+            }
+            Status = GST_FAILURE;
+            continue;
+        }
+
+        // Scores without a move read entry 0 and are masked to 0
+        values = table->Dynamic.Values;
+        moves = table->Dynamic.Moves;
+        target = table->Rules.Target;
+        for (j = 0U; j < group->Count; j++)
+        {
+            if (j + QUERY_PREFETCH_DISTANCE < group->Count)
+            {
+                score = Queries[order[j + QUERY_PREFETCH_DISTANCE]].Score;
+                score = (score < target) ? score : 0U;
+                QUERY_PREFETCH(&values[2U*score + 1U]);
+                QUERY_PREFETCH(&moves[score]);
+            }
+            i = order[j];
+            score = Queries[i].Score;
+            valid = (score < target) ? 1U : 0U;
+            score = valid ? score : 0U;
+            Moves[i] = moves[score] & (0U - valid);
+            Values[i] = values[2U*score + 1U] & (int64_t) (0U - valid);
+            invalid += valid ^ 1U;
+        }
+    }
+
+    return (Status == GST_SUCCESS && invalid > 0U) ? GST_INVALID_STATE : Status;
+};
+
+/**
+ * @brief 
+ * Checks Query_Batch against the table solver of the Dynamic player 
+ * for every target from 1 to maxTarget, every max advancement from 1 
+ * to maxAdvancement, under normal and misere endings. Every score of 
+ * every one of these rules is asked about in one shuffled batch, with 
+ * fewer kept tables than rules, and the batch is asked twice so the 
+ * second is answered from kept tables.
+ * 
+ * @param maxTarget The largest target in the sweep.
+ * @param maxAdvancement The largest max advancement in the sweep.
+ * @param Mismatches Pointer to a uint. Query_Verify stores the number of disagreements here.
+ * @return GStatus GST_SUCCESS if every query agrees, GST_FAILURE otherwise.
+ */
+GStatus Query_Verify(uint64_t maxTarget, uint64_t maxAdvancement, uint64_t *Mismatches)
+{
+    struct Query Query;
+    struct Dynamic Dynamic;
+    struct Actor Actor;
+    struct rules *configs;
+    struct query *queries;
+    uint64_t *perm;
+    uint64_t *where;
+    uint64_t *moves;
+    int64_t *values;
+    uint64_t configCount = 2U*maxTarget*maxAdvancement;
+    uint64_t queryCount = maxAdvancement*maxTarget*(maxTarget + 3U);
+    uint64_t state = 0x9E3779B97F4A7C15ULL;
+    uint64_t Checked = 0U;
+    uint64_t first;
+    uint64_t c;
+    uint64_t q;
+    uint64_t j;
+    uint64_t tmp;
+    uint64_t Score;
+    uint64_t Move;
+    int64_t Value;
+    uint32_t pass;
+    GStatus Status = GST_SUCCESS;
+
+    *Mismatches = 0U;
+    if (Query_Init(&Query, QUERY_CACHE_TABLES) != GST_SUCCESS)
+    {
+        Query_Free(&Query);
+        return GST_FAILURE;
+    }
+
+    configs = malloc(configCount*sizeof(struct rules));
+    queries = malloc(queryCount*sizeof(struct query));
+    perm = malloc(queryCount*sizeof(uint64_t));
+    where = malloc(queryCount*sizeof(uint64_t));
+    moves = malloc(queryCount*sizeof(uint64_t));
+    values = malloc(queryCount*sizeof(int64_t));
+    if (configs == NULL || queries == NULL || perm == NULL || where == NULL || moves == NULL || values == NULL)
+    {
+        Status = GST_FAILURE;
+        configCount = 0U;
+        queryCount = 0U;
+    }
+
+    // Even configs end normally and odd ones misere, the rules of a pair are the same otherwise
+    for (c = 0U; c < configCount; c++)
+    {
+        Game_InitRules(&configs[c], 1U + (c/2U) / maxAdvancement, 1U + (c/2U) % maxAdvancement);
+        configs[c].Ending = (c % 2U == 0U) ? GAME_END_NORMAL : GAME_END_MISERE;
+    }
+
+    // Query q is the q'th score counting through the configs in order,
+    // shuffled to place where[q] of the batch by a Fisher-Yates shuffle
+    for (q = 0U; q < queryCount; q++)
+    {
+        perm[q] = q;
+    }
+    for (j = queryCount; j > 1U; j--)
+    {
+        state = state*6364136223846793005ULL + 1442695040888963407ULL;
+        q = (state >> 33) % j;
+        tmp = perm[j - 1U];
+        perm[j - 1U] = perm[q];
+        perm[q] = tmp;
+    }
+    for (c = 0U, q = 0U; c < configCount; c++)
+    {
+        for (Score = 0U; Score <= configs[c].Target; Score++, q++)
+        {
+            where[q] = perm[q];
+            queries[perm[q]].Rules = &configs[c];
+            queries[perm[q]].Score = Score;
+        }
+    }
+
+    for (pass = 0U; pass < 2U && Status == GST_SUCCESS; pass++)
+    {
+        if (Query_Batch(&Query, queries, queryCount, moves, values) == GST_FAILURE)
+        {
+            Status = GST_FAILURE;
+            break;
+        }
+
+        for (c = 0U, first = 0U; c < configCount && Status == GST_SUCCESS; first += configs[c].Target + 1U, c++)
+        {
+            if (Dynamic_InitTable(&Actor, &Dynamic, &configs[c]) != GST_SUCCESS)
+            {
+                Status = GST_FAILURE;
+            }
+
+            for (Score = 0U; Status == GST_SUCCESS && Score <= configs[c].Target; Score++)
+            {
+                Move = (Score < configs[c].Target) ? Dynamic.Moves[Score] : 0U;
+                Value = (Score < configs[c].Target) ? Dynamic.Values[2U*Score + 1U] : 0;
+                j = where[first + Score];
+                Checked++;
+                if (moves[j] != Move || values[j] != Value)
+                {
+                    (*Mismatches)++;
+                    printf("Mismatch: Target(%" PRIu64 "), MaxAdvancement(%" PRIu64 "), Ending(%u), Score(%" PRIu64 "), Batch Adds %" PRIu64 " (%" PRId64 "), Table Adds %" PRIu64 " (%" PRId64 ")\n",
+                        configs[c].Target, configs[c].MaxAdvancement, configs[c].Ending, Score, moves[j], values[j], Move, Value);
+                }
+            }
+            Dynamic_Free(&Dynamic);
+        }
+    }
+
+    printf("Verified %" PRIu64 " batch queries, %" PRIu64 " mismatches\n", Checked, *Mismatches);
+
+    Query_Free(&Query);
+    free(configs);
+    free(queries);
+    free(perm);
+    free(where);
+    free(moves);
+    free(values);
+
+    return (Status == GST_SUCCESS && *Mismatches == 0U) ? GST_SUCCESS : GST_FAILURE;
+};
+
+/**
+ * @brief Grows the per query scratch arrays to hold Count queries.
+ */
+static GStatus Query_Grow(query_t Query, uint64_t Count)
+{
+    uint32_t *group;
+    uint64_t *order;
+
+    if (Count <= Query->OrderCapacity)
+    {
+        return GST_SUCCESS;
+    }
+    if (Count > SIZE_MAX / sizeof(uint64_t))
+    {
+        return GST_FAILURE;
+    }
+
+    group = realloc(Query->Group, Count*sizeof(uint32_t));
+    if (group == NULL)
+    {
+        return GST_FAILURE;
+    }
+    Query->Group = group;
+    order = realloc(Query->Order, Count*sizeof(uint64_t));
+    if (order == NULL)
+    {
+        return GST_FAILURE;
+    }
+    Query->Order = order;
+    Query->OrderCapacity = Count;
+
+    return GST_SUCCESS;
+}
+
+/**
+ * @brief Makes room for group number Groups, doubling the groups when they are full.
+ */
+static GStatus Query_AddGroup(query_t Query, uint32_t Groups)
+{
+    struct query_group *grown;
+    uint32_t capacity;
+
+    if (Groups < Query->GroupCapacity)
+    {
+        return GST_SUCCESS;
+    }
+    if (Query->GroupCapacity >= UINT32_MAX / 2U)
+    {
+        return GST_FAILURE;
+    }
+
+    capacity = (Query->GroupCapacity == 0U) ? Query->TableCapacity : 2U*Query->GroupCapacity;
+    grown = realloc(Query->Groups, capacity*sizeof(struct query_group));
+    if (grown == NULL)
+    {
+        return GST_FAILURE;
+    }
+    Query->Groups = grown;
+    Query->GroupCapacity = capacity;
+
+    return GST_SUCCESS;
+}
+
+/**
+ * @brief 
+ * Finds the solved table of a set of rules, solving it into the 
+ * least recently used slot when it isn't kept.
+ */
+static GStatus Query_Table(query_t Query, rules_t rules, uint64_t Key, struct query_table **Table)
+{
+    struct query_table *table = NULL;
+    struct Actor Actor;
+    uint32_t i;
+
+    for (i = 0U; i < Query->TableCount; i++)
+    {
+        if (Query->Tables[i].Key == Key && Query_SameRules(&Query->Tables[i].Rules, rules))
+        {
+            Query->Tables[i].LastUsed = Query->Batches;
+            *Table = &Query->Tables[i];
+            return GST_SUCCESS;
+        }
+    }
+
+    if (Query->TableCount < Query->TableCapacity)
+    {
+        table = &Query->Tables[Query->TableCount++];
+    }
+    else
+    {
+        table = &Query->Tables[0];
+        for (i = 1U; i < Query->TableCount; i++)
+        {
+            table = (Query->Tables[i].LastUsed < table->LastUsed) ? &Query->Tables[i] : table;
+        }
+        Dynamic_Free(&table->Dynamic);
+        free(table->Moves);
+    }
+
+    // The rules of the table outlive the queries, so their moves are copied.
+    // Until it is solved the slot has key 0, which no rules have.
+    memset(table, 0, sizeof(*table));
+    table->Rules = *rules;
+    if (rules->Moves != NULL)
+    {
+        table->Moves = malloc(rules->MoveCount*sizeof(uint64_t));
+        if (table->Moves == NULL)
+        {
+            return GST_FAILURE;
+        }
+        memcpy(table->Moves, rules->Moves, rules->MoveCount*sizeof(uint64_t));
+        table->Rules.Moves = table->Moves;
+    }
+    table->LastUsed = Query->Batches;
+
+    if (Dynamic_InitTable(&Actor, &table->Dynamic, &table->Rules) != GST_SUCCESS)
+    {
+        Dynamic_Free(&table->Dynamic);
+        return GST_FAILURE;
+    }
+    table->Key = Key;
+    *Table = table;
+
+    return GST_SUCCESS;
+}
+
+/**
+ * @brief Whether two rules are the same game.
+ */
+static uint8_t Query_SameRules(rules_t a, rules_t b)
+{
+    if (a->Target != b->Target || a->MaxAdvancement != b->MaxAdvancement || a->Ending != b->Ending ||
+        a->MoveCount != b->MoveCount || a->MoveHash != b->MoveHash || (a->Moves == NULL) != (b->Moves == NULL))
+    {
+        return 0U;
+    }
+
+    return (a->Moves == NULL || memcmp(a->Moves, b->Moves, a->MoveCount*sizeof(uint64_t)) == 0) ? 1U : 0U;
+}
+
+/*** end of file ***/
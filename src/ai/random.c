@@ -0,0 +1,135 @@
+/** @file random.c
+ * 
+ * @brief 
+ * A player for the game "Who Says 20 First" that picks a legal
+ * move uniformly at random. Used as an opponent in self-play.
+ *
+ * @par       
+ * COPYRIGHT NOTICE: (c) 2021 Graham Power.  All rights reserved.
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */ 
+
+#include "random.h"
+
+/************************** Constant Definitions *****************************/
+
+/**************************** Type Definitions *******************************/
+
+/************************** Function Prototypes ******************************/
+
+/************************** Function Definitions *****************************/
+
+/**
+ * @brief 
+ * Initializes a random controller Actor. Two players given the 
+ * same seed play the same moves.
+ * 
+ * @param Actor The actor who will use Random_Act to advance a game state. 
+ * @param Random The pointer to the random struct, used as a class-like representation.
+ * @param Seed The seed of the random number generator.
+ * @return GStatus The success of the initialization.
+ */
+GStatus Random_Init(Actor_t Actor, random_t Random, uint64_t Seed)
+{
+    Actor->Type = RANDOM;
+    Actor->Action = Random_Act;
+    Actor->Choose = Random_Choose;
+
+    // xorshift gets stuck on a state of 0
+    Random->State = (Seed == 0U) ? 0x9E3779B97F4A7C15ULL : Seed;
+
+    Actor->ActorBase = Random;
+
+    return GST_SUCCESS;
+};
+
+/**
+ * @brief 
+ * Takes an action of behalf of the Actor that called it, adding 
+ * a random legal amount.
+ * 
+ * @param game The game to take the action in.
+ * @param ActorBase The Actors base structure, a Random structure.
+ * @return GStatus The success of the action.
+ */
+GStatus Random_Act(game_t game, void *ActorBase)
+{
+    uint64_t Advancement = 1U;
+    Random_Choose(game, ActorBase, &Advancement);
+
+    LOG_PRINTF(LOG_INFO, "Random AI Adds: %" PRIu64 "\n", Advancement);
+
+    return Game_AdvanceState(game, Advancement);
+};
+
+/**
+ * @brief 
+ * Calculates the move the Actor would take, without taking it. 
+ * Every move of the rules that doesn't pass the target is equally 
+ * likely.
+ * 
+ * @param game The game to calculate the move in.
+ * @param ActorBase The Actors base structure, a Random structure.
+ * @param Advancement Pointer to a uint. Random_Choose stores the action to take here.
+ * @return GStatus The success of the calculation.
+ */
+GStatus Random_Choose(game_t game, void *ActorBase, uint64_t *Advancement)
+{
+    random_t Random = (random_t) ActorBase;
+    uint64_t legal = Game_LegalMoves(game->Rules, game->Rules->Target - game->State);
+
+    if (legal == 0U)
+    {
+        *Advancement = RULES_MOVE(game->Rules, 0U);
+        return GST_INVALID_STATE;
+    }
+
+    *Advancement = RULES_MOVE(game->Rules, Random_Next(Random) % legal);
+
+    return GST_SUCCESS;
+};
+
+/**
+ * @brief Advances the xorshift64* generator of the Actor.
+ * 
+ * @param Random The pointer to the random struct.
+ * @return uint64_t The next random number.
+ */
+uint64_t Random_Next(random_t Random)
+{
+    return RANDOM_NEXT(Random->State);
+};
+
+/**
+ * @brief 
+ * Derives the seed of one of many generators started from the same 
+ * seed, with the splitmix64 mixer. The mixer is a bijection, so 
+ * different streams of a seed never get the same state, and 
+ * neighbouring seeds give unrelated ones.
+ * 
+ * @param Seed The seed every stream is derived from.
+ * @param Stream The number of the stream.
+ * @return uint64_t The seed of the stream.
+ */
+uint64_t Random_Seed(uint64_t Seed, uint64_t Stream)
+{
+    uint64_t x = (Seed ^ Stream) + 0x9E3779B97F4A7C15ULL;
+
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+
+    return x ^ (x >> 31);
+};
+
+/*** end of file ***/
@@ -0,0 +1,928 @@
+/** @file tablebase.c
+ * 
+ * @brief 
+ * Solved strategy tables stored in versioned binary files. A table 
+ * is written once with Tablebase_Write, and players then map the 
+ * file read-only, so startup doesn't depend on the target and every 
+ * process on the host shares the same copy through the page cache.
+ * Games on many counters are solved with Tablebase_WriteCounters, 
+ * one byte for every combination of scores.
+ *
+ * @par       
+ * COPYRIGHT NOTICE: (c) 2021 Graham Power.  All rights reserved.
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */ 
+
+#include "tablebase.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "dynamic.h"
+#include "threadpool.h"
+
+/************************** Constant Definitions *****************************/
+
+// Entries start on a page boundary, so they can be mapped on their own
+#define TABLEBASE_DATA_OFFSET   4096U
+
+// The largest games Tablebase_Verify searches exhaustively.
+#define TABLEBASE_VERIFY_COUNTERS   3U
+#define TABLEBASE_VERIFY_TARGET     8U
+#define TABLEBASE_VERIFY_MOVES      3U
+#define TABLEBASE_VERIFY_THREADS    4U
+
+/**************************** Type Definitions *******************************/
+
+// The shared state of a Tablebase_SolveCounters run.
+struct counters_solve
+{
+    rules_t Rules;
+    uint32_t Counters;
+    const uint64_t *Binomial;
+    uint8_t *Entries;
+    uint64_t *Scratch;      // Counters scores per worker
+    uint64_t Layer;         // The sum of the scores being solved
+};
+
+// One task of a layer, every combination whose highest score is Top.
+struct counters_task
+{
+    struct task Task;
+    struct counters_solve *Solve;
+    uint64_t Top;
+};
+
+/************************** Function Prototypes ******************************/
+
+static uint64_t *Tablebase_Binomials(uint64_t target, uint32_t counters);
+static uint64_t Tablebase_Index(const uint64_t *Binomial, uint32_t counters, const uint64_t *Scores);
+static void Tablebase_SolveTop(threadpool_t pool, uint32_t Worker, void *Arg);
+static void Tablebase_Enumerate(struct counters_solve *Solve, uint64_t *Scores, uint32_t Slots, uint64_t Remaining, uint64_t Ceiling);
+static void Tablebase_SolvePosition(struct counters_solve *Solve, const uint64_t *Scores);
+static char *Tablebase_TempPath(const char *Path);
+
+/************************** Function Definitions *****************************/
+
+/**
+ * @brief 
+ * Solves the game for the passed in rules with the Dynamic table 
+ * solver and writes the best move for every score to a file. The 
+ * file is written next to its final path and renamed into place, 
+ * so readers never see a partial table.
+ * 
+ * @param Path The path of the file to write.
+ * @param rules The rules to solve.
+ * @return GStatus GST_FAILURE if the game can't be solved or the file can't be written, GST_SUCCESS otherwise.
+ */
+GStatus Tablebase_Write(const char *Path, rules_t rules)
+{
+    struct tablebase_header header;
+    struct Dynamic Dynamic;
+    struct Actor Actor;
+    char *tmpPath;
+    FILE *file;
+    uint64_t Score;
+    uint16_t move16;
+    int ok;
+
+    // The header only describes ranges of moves
+    if (rules->Moves != NULL)
+    {
+        return GST_FAILURE;
+    }
+    if (Dynamic_InitTable(&Actor, &Dynamic, rules) != GST_SUCCESS)
+    {
+        Dynamic_Free(&Dynamic);
+        return GST_FAILURE;
+    }
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.Magic, TABLEBASE_MAGIC, sizeof(TABLEBASE_MAGIC));
+    header.Version = TABLEBASE_VERSION;
+    header.ByteOrder = TABLEBASE_BYTE_ORDER;
+    header.Kind = TABLEBASE_KIND_MOVES;
+    header.EntrySize = (rules->MaxAdvancement <= UINT16_MAX) ? sizeof(uint16_t) : sizeof(uint32_t);
+    header.Target = rules->Target;
+    header.MaxAdvancement = rules->MaxAdvancement;
+    header.Entries = rules->Target;
+    header.DataOffset = TABLEBASE_DATA_OFFSET;
+    header.Counters = 1U;
+    header.Ending = rules->Ending;
+
+    tmpPath = Tablebase_TempPath(Path);
+    if (tmpPath == NULL)
+    {
+        Dynamic_Free(&Dynamic);
+        return GST_FAILURE;
+    }
+
+    file = fopen(tmpPath, "wb");
+    ok = (file != NULL);
+    if (ok)
+    {
+        ok = fwrite(&header, sizeof(header), 1, file) == 1 && fseek(file, header.DataOffset, SEEK_SET) == 0;
+        if (ok && header.EntrySize == sizeof(uint32_t))
+        {
+            ok = fwrite(Dynamic.Moves, sizeof(uint32_t), header.Entries, file) == header.Entries;
+        }
+        for (Score = 0U; ok && header.EntrySize == sizeof(uint16_t) && Score < header.Entries; Score++)
+        {
+            move16 = (uint16_t) Dynamic.Moves[Score];
+            ok = fwrite(&move16, sizeof(move16), 1, file) == 1;
+        }
+        ok = (fclose(file) == 0) && ok;
+    }
+    ok = ok && rename(tmpPath, Path) == 0;
+    if (!ok)
+    {
+        remove(tmpPath);
+    }
+
+    free(tmpPath);
+    Dynamic_Free(&Dynamic);
+
+    return ok ? GST_SUCCESS : GST_FAILURE;
+};
+
+/**
+ * @brief 
+ * Solves a game played on many counters with the passed in rules by 
+ * retrograde analysis, and writes whether the player to move wins 
+ * every combination of scores to a file. See Tablebase_SolveCounters. 
+ * The entries are solved straight into the mapped file, so only the 
+ * table itself has to fit in memory.
+ * 
+ * @param Path The path of the file to write.
+ * @param rules The rules of every counter, a range of moves.
+ * @param counters The number of counters, at least 2.
+ * @param threads The number of threads to solve on, 0 for one per core.
+ * @return GStatus GST_FAILURE if the game can't be solved or the file can't be written, GST_SUCCESS otherwise.
+ */
+GStatus Tablebase_WriteCounters(const char *Path, rules_t rules, uint32_t counters, uint32_t threads)
+{
+    struct tablebase_header header;
+    uint64_t Positions;
+    uint8_t *map = MAP_FAILED;
+    char *tmpPath;
+    int fd;
+    int ok;
+
+    // The header only describes ranges of moves
+    if (rules->Moves != NULL || counters < 2U || Tablebase_CountPositions(rules, counters, &Positions) != GST_SUCCESS ||
+        Positions > (uint64_t) SIZE_MAX - TABLEBASE_DATA_OFFSET)
+    {
+        return GST_FAILURE;
+    }
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.Magic, TABLEBASE_MAGIC, sizeof(TABLEBASE_MAGIC));
+    header.Version = TABLEBASE_VERSION;
+    header.ByteOrder = TABLEBASE_BYTE_ORDER;
+    header.Kind = TABLEBASE_KIND_COUNTERS;
+    header.EntrySize = sizeof(uint8_t);
+    header.Target = rules->Target;
+    header.MaxAdvancement = rules->MaxAdvancement;
+    header.Entries = Positions;
+    header.DataOffset = TABLEBASE_DATA_OFFSET;
+    header.Counters = counters;
+    header.Ending = rules->Ending;
+
+    tmpPath = Tablebase_TempPath(Path);
+    if (tmpPath == NULL)
+    {
+        return GST_FAILURE;
+    }
+
+    fd = open(tmpPath, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    ok = (fd >= 0) && ftruncate(fd, (off_t) (header.DataOffset + Positions)) == 0;
+    if (ok)
+    {
+        map = mmap(NULL, header.DataOffset + Positions, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        ok = (map != MAP_FAILED);
+    }
+    if (ok)
+    {
+        memcpy(map, &header, sizeof(header));
+        ok = Tablebase_SolveCounters(rules, counters, threads, map + header.DataOffset) == GST_SUCCESS;
+        ok = (munmap(map, header.DataOffset + Positions) == 0) && ok;
+    }
+    if (fd >= 0)
+    {
+        ok = (close(fd) == 0) && ok;
+    }
+    ok = ok && rename(tmpPath, Path) == 0;
+    if (!ok)
+    {
+        remove(tmpPath);
+    }
+    free(tmpPath);
+
+    return ok ? GST_SUCCESS : GST_FAILURE;
+};
+
+/**
+ * @brief 
+ * Solves every combination of scores of a game on many counters, 
+ * for any of the endings. Counters share their rules, so the order 
+ * of the scores doesn't matter, and each combination is stored once 
+ * by its sorted scores, at the index Tablebase_Index gives it. That 
+ * is (Target + counters) choose counters entries, against 
+ * (Target + 1)^counters for every ordering.
+ * 
+ * Every move adds to the sum of the scores, so combinations are 
+ * solved a layer of equal sums at a time, from the highest sum down 
+ * to 0. A layer only depends on the layers above it, which are done, 
+ * so its combinations are split over the threads by their highest 
+ * score and solved in parallel.
+ * 
+ * @param rules The rules of every counter.
+ * @param counters The number of counters, at least 1.
+ * @param threads The number of threads to solve on, 0 for one per core.
+ * @param Entries 
+ * The table to fill, Tablebase_CountPositions long. Each entry ends up 
+ * TABLEBASE_WON or TABLEBASE_LOST for the player to move.
+ * @return GStatus GST_FAILURE if the game is too large or the threads can't run, GST_SUCCESS otherwise.
+ */
+GStatus Tablebase_SolveCounters(rules_t rules, uint32_t counters, uint32_t threads, uint8_t *Entries)
+{
+    struct counters_solve Solve;
+    struct counters_task *tasks;
+    struct threadpool pool;
+    uint64_t *Binomial;
+    uint64_t Positions;
+    uint64_t Layer;
+    uint64_t Top;
+    GStatus Status = GST_SUCCESS;
+
+    if (counters == 0U || Tablebase_CountPositions(rules, counters, &Positions) != GST_SUCCESS ||
+        rules->Target > UINT64_MAX / counters)
+    {
+        return GST_FAILURE;
+    }
+
+    Binomial = Tablebase_Binomials(rules->Target, counters);
+    tasks = malloc((rules->Target + 1U)*sizeof(struct counters_task));
+    if (Binomial == NULL || tasks == NULL || ThreadPool_Init(&pool, threads, rules->Target + 1U) != GST_SUCCESS)
+    {
+        free(Binomial);
+        free(tasks);
+        return GST_FAILURE;
+    }
+
+    Solve.Rules = rules;
+    Solve.Counters = counters;
+    Solve.Binomial = Binomial;
+    Solve.Entries = Entries;
+    Solve.Scratch = malloc(pool.Threads*counters*sizeof(uint64_t));
+    if (Solve.Scratch == NULL)
+    {
+        Status = GST_FAILURE;
+    }
+
+    for (Layer = counters*rules->Target + 1U; Status == GST_SUCCESS && Layer-- > 0U; )
+    {
+        Solve.Layer = Layer;
+
+        // The highest score of a combination is at least an even share of the sum
+        for (Top = (Layer + counters - 1U) / counters; Status == GST_SUCCESS && Top <= rules->Target && Top <= Layer; Top++)
+        {
+            tasks[Top].Task.Run = Tablebase_SolveTop;
+            tasks[Top].Task.Arg = &tasks[Top];
+            tasks[Top].Solve = &Solve;
+            tasks[Top].Top = Top;
+            Status = ThreadPool_Submit(&pool, &tasks[Top].Task);
+        }
+        if (ThreadPool_Run(&pool) != GST_SUCCESS)
+        {
+            Status = GST_FAILURE;
+        }
+    }
+
+    ThreadPool_Free(&pool);
+    free(Solve.Scratch);
+    free(Binomial);
+    free(tasks);
+
+    return Status;
+};
+
+/**
+ * @brief Counts the combinations of scores of a game on many counters.
+ * 
+ * @param rules The rules of every counter.
+ * @param counters The number of counters.
+ * @param Positions Pointer to a uint. Tablebase_CountPositions stores (Target + counters) choose counters here.
+ * @return GStatus GST_FAILURE if the count doesn't fit in memory, GST_SUCCESS otherwise.
+ */
+GStatus Tablebase_CountPositions(rules_t rules, uint32_t counters, uint64_t *Positions)
+{
+    uint64_t count = 1U;
+    uint64_t k;
+
+    // Every partial product is itself a binomial, so the division is exact
+    for (k = 1U; k <= counters; k++)
+    {
+        if (rules->Target > UINT64_MAX - k || count > UINT64_MAX / (rules->Target + k))
+        {
+            return GST_FAILURE;
+        }
+        count = count*(rules->Target + k)/k;
+    }
+    *Positions = count;
+
+    return (count <= SIZE_MAX) ? GST_SUCCESS : GST_FAILURE;
+};
+
+/**
+ * @brief 
+ * Maps a tablebase file read-only and checks its header. Only the 
+ * header is read here, entries are paged in as they are used.
+ * 
+ * @param Tablebase The tablebase to open.
+ * @param Path The path of the file to map.
+ * @return GStatus GST_FAILURE if the file can't be mapped or isn't a tablebase of this version, GST_SUCCESS otherwise.
+ */
+GStatus Tablebase_Open(tablebase_t Tablebase, const char *Path)
+{
+    const struct tablebase_header *header;
+    struct rules rules;
+    struct stat st;
+    uint64_t Positions;
+    int fd;
+
+    Tablebase->Map = NULL;
+    Tablebase->Header = NULL;
+    Tablebase->Entries = NULL;
+    Tablebase->Length = 0U;
+    Tablebase->Binomial = NULL;
+    Tablebase->Scores = NULL;
+
+    fd = open(Path, O_RDONLY);
+    if (fd < 0)
+    {
+        return GST_FAILURE;
+    }
+    if (fstat(fd, &st) != 0 || (size_t) st.st_size < sizeof(struct tablebase_header))
+    {
+        close(fd);
+        return GST_FAILURE;
+    }
+
+    Tablebase->Length = (size_t) st.st_size;
+    Tablebase->Map = mmap(NULL, Tablebase->Length, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (Tablebase->Map == MAP_FAILED)
+    {
+        Tablebase->Map = NULL;
+        return GST_FAILURE;
+    }
+
+    header = (const struct tablebase_header *) Tablebase->Map;
+    if (memcmp(header->Magic, TABLEBASE_MAGIC, sizeof(TABLEBASE_MAGIC)) != 0 ||
+        header->Version == 0U || header->Version > TABLEBASE_VERSION ||
+        header->ByteOrder != TABLEBASE_BYTE_ORDER ||
+        (header->Kind == TABLEBASE_KIND_MOVES && header->EntrySize != sizeof(uint16_t) && header->EntrySize != sizeof(uint32_t)) ||
+        (header->Kind == TABLEBASE_KIND_COUNTERS && (header->EntrySize != sizeof(uint8_t) || header->Counters < 2U)) ||
+        (header->Kind != TABLEBASE_KIND_MOVES && header->Kind != TABLEBASE_KIND_COUNTERS) ||
+        header->DataOffset > Tablebase->Length ||
+        header->Entries > (Tablebase->Length - header->DataOffset) / header->EntrySize)
+    {
+        Tablebase_Close(Tablebase);
+        return GST_FAILURE;
+    }
+
+    Tablebase->Header = header;
+    Tablebase->Entries = (const uint8_t *) Tablebase->Map + header->DataOffset;
+
+    if (header->Kind == TABLEBASE_KIND_COUNTERS)
+    {
+        // Combinations are looked up without bounds checks, so the file has to hold every one
+        memset(&rules, 0, sizeof(rules));
+        rules.Target = header->Target;
+        if (Tablebase_CountPositions(&rules, header->Counters, &Positions) != GST_SUCCESS || header->Entries != Positions)
+        {
+            Tablebase_Close(Tablebase);
+            return GST_FAILURE;
+        }
+
+        Tablebase->Binomial = Tablebase_Binomials(header->Target, header->Counters);
+        Tablebase->Scores = malloc(2U*header->Counters*sizeof(uint64_t));
+        if (Tablebase->Binomial == NULL || Tablebase->Scores == NULL)
+        {
+            Tablebase_Close(Tablebase);
+            return GST_FAILURE;
+        }
+    }
+
+    return GST_SUCCESS;
+};
+
+/**
+ * @brief Unmaps a tablebase opened by Tablebase_Open.
+ * 
+ * @param Tablebase The tablebase to close.
+ * @return GStatus The success of the close.
+ */
+GStatus Tablebase_Close(tablebase_t Tablebase)
+{
+    if (Tablebase->Map != NULL)
+    {
+        munmap(Tablebase->Map, Tablebase->Length);
+    }
+    free(Tablebase->Binomial);
+    free(Tablebase->Scores);
+    Tablebase->Binomial = NULL;
+    Tablebase->Scores = NULL;
+    Tablebase->Map = NULL;
+    Tablebase->Header = NULL;
+    Tablebase->Entries = NULL;
+
+    return GST_SUCCESS;
+};
+
+/**
+ * @brief Checks if a table was solved for the passed in rules.
+ * 
+ * @param Tablebase The open tablebase.
+ * @param rules The rules to check.
+ * @return GStatus GST_SUCCESS if the target, moves and ending are the ones of the table, GST_FAILURE otherwise.
+ */
+GStatus Tablebase_Matches(tablebase_t Tablebase, rules_t rules)
+{
+    const struct tablebase_header *header = Tablebase->Header;
+
+    return (header->Target == rules->Target && header->MaxAdvancement == rules->MaxAdvancement &&
+        rules->Moves == NULL && header->Ending == rules->Ending) ? GST_SUCCESS : GST_FAILURE;
+};
+
+/**
+ * @brief Looks up the best move for a score.
+ * 
+ * @param Tablebase The open tablebase.
+ * @param rules The rules of the game being played, must match the ones the table was written for.
+ * @param Score The score of the current game.
+ * @param Advancement Pointer to a uint. Tablebase_Lookup stores the action to take here.
+ * @return GStatus GST_INVALID_STATE if the table doesn't cover the game or score, GST_SUCCESS otherwise.
+ */
+GStatus Tablebase_Lookup(tablebase_t Tablebase, rules_t rules, uint64_t Score, uint64_t *Advancement)
+{
+    const struct tablebase_header *header = Tablebase->Header;
+
+    *Advancement = 1U;
+    if (header->Kind != TABLEBASE_KIND_MOVES || Tablebase_Matches(Tablebase, rules) != GST_SUCCESS || Score >= header->Entries)
+    {
+        return GST_INVALID_STATE;
+    }
+
+    if (header->EntrySize == sizeof(uint16_t))
+    {
+        *Advancement = ((const uint16_t *) Tablebase->Entries)[Score];
+    }
+    else
+    {
+        *Advancement = ((const uint32_t *) Tablebase->Entries)[Score];
+    }
+
+    return GST_SUCCESS;
+};
+
+/**
+ * @brief 
+ * Picks the move to take in a game on many counters from a 
+ * TABLEBASE_KIND_COUNTERS table. Every move of every counter is 
+ * tried until one leaves a lost combination for the opponent. Lost 
+ * games play the smallest move on the first counter that has one.
+ * 
+ * @param Tablebase The open tablebase.
+ * @param game The game to pick the move in.
+ * @param Counter Pointer to a uint. Tablebase_MoveCounters stores the counter to advance here.
+ * @param Advancement Pointer to a uint. Tablebase_MoveCounters stores the advancement here.
+ * @return GStatus GST_INVALID_STATE if the table doesn't cover the game, GST_FAILURE if it is lost, GST_SUCCESS otherwise.
+ */
+GStatus Tablebase_MoveCounters(tablebase_t Tablebase, game_t game, uint32_t *Counter, uint64_t *Advancement)
+{
+    const struct tablebase_header *header = Tablebase->Header;
+    const uint8_t *Entries = (const uint8_t *) Tablebase->Entries;
+    rules_t rules = game->Rules;
+    uint32_t counters = game->Counters;
+    uint64_t *Sorted = Tablebase->Scores;
+    uint64_t *Child = Tablebase->Scores + counters;
+    uint64_t Score;
+    uint64_t a;
+    uint32_t c;
+    uint32_t i;
+    uint32_t j;
+
+    *Counter = 0U;
+    *Advancement = 1U;
+    if (header->Kind != TABLEBASE_KIND_COUNTERS || header->Counters != counters || Tablebase_Matches(Tablebase, rules) != GST_SUCCESS)
+    {
+        return GST_INVALID_STATE;
+    }
+
+    // Insertion sort, the number of counters is small
+    for (i = 0U; i < counters; i++)
+    {
+        Score = GAME_COUNTER(game, i);
+        for (j = i; j > 0U && Sorted[j - 1U] > Score; j--)
+        {
+            Sorted[j] = Sorted[j - 1U];
+        }
+        Sorted[j] = Score;
+    }
+
+    for (c = 0U; c < counters; c++)
+    {
+        Score = GAME_COUNTER(game, c);
+        for (a = 1U; a <= rules->MaxAdvancement && a <= rules->Target - Score; a++)
+        {
+            // The child is the sorted scores with one copy of Score moved up by a
+            for (i = 0U, j = 0U; i < counters; i++)
+            {
+                if (Sorted[i] == Score && j == i)
+                {
+                    continue;
+                }
+                Child[j++] = Sorted[i];
+            }
+            for (j = counters - 1U; j > 0U && Child[j - 1U] > Score + a; j--)
+            {
+                Child[j] = Child[j - 1U];
+            }
+            Child[j] = Score + a;
+
+            if (Entries[Tablebase_Index(Tablebase->Binomial, counters, Child)] == TABLEBASE_LOST)
+            {
+                *Counter = c;
+                *Advancement = a;
+                return GST_SUCCESS;
+            }
+        }
+    }
+
+    for (c = 0U; c < counters; c++)
+    {
+        if (GAME_COUNTER(game, c) < rules->Target)
+        {
+            *Counter = c;
+            return GST_FAILURE;
+        }
+    }
+
+    return GST_INVALID_STATE;
+};
+
+/**
+ * @brief 
+ * Initializes a tablebase controller Actor, playing from the table 
+ * in the passed in file.
+ * 
+ * @param Actor The actor who will use Tablebase_Act to advance a game state. 
+ * @param Tablebase The pointer to the tablebase struct, used as a class-like representation.
+ * @param Path The path of the tablebase file.
+ * @return GStatus The success of opening the file.
+ */
+GStatus Tablebase_Init(Actor_t Actor, tablebase_t Tablebase, const char *Path)
+{
+    Actor->Type = TABLEBASE;
+    Actor->Action = Tablebase_Act;
+    Actor->Choose = Tablebase_Choose;
+    Actor->ActorBase = Tablebase;
+
+    return Tablebase_Open(Tablebase, Path);
+};
+
+/**
+ * @brief 
+ * Takes an action of behalf of the Actor that called it, playing 
+ * the move stored in the table.
+ * 
+ * @param game The game to take the action in.
+ * @param ActorBase The Actors base structure, a Tablebase structure.
+ * @return GStatus The success of the action.
+ */
+GStatus Tablebase_Act(game_t game, void *ActorBase)
+{
+    tablebase_t Tablebase = (tablebase_t) ActorBase;
+    uint64_t Advancement = 1U;
+    uint32_t Counter = 0U;
+
+    if (Tablebase->Header->Kind == TABLEBASE_KIND_COUNTERS)
+    {
+        Tablebase_MoveCounters(Tablebase, game, &Counter, &Advancement);
+        LOG_PRINTF(LOG_INFO, "Tablebase AI Adds: %" PRIu64 " To Counter %" PRIu32 "\n", Advancement, Counter + 1U);
+
+        return Game_AdvanceCounter(game, Counter, Advancement);
+    }
+    Tablebase_Choose(game, ActorBase, &Advancement);
+
+    LOG_PRINTF(LOG_INFO, "Tablebase AI Adds: %" PRIu64 "\n", Advancement);
+
+    return Game_AdvanceState(game, Advancement);
+};
+
+/**
+ * @brief 
+ * Calculates the move the Actor would take, without taking it.
+ * 
+ * @param game The game to calculate the move in.
+ * @param ActorBase The Actors base structure, a Tablebase structure.
+ * @param Advancement Pointer to a uint. Tablebase_Choose stores the action to take here.
+ * @return GStatus The success of the lookup.
+ */
+GStatus Tablebase_Choose(game_t game, void *ActorBase, uint64_t *Advancement)
+{
+    return Tablebase_Lookup((tablebase_t) ActorBase, game->Rules, game->State, Advancement);
+};
+
+/**
+ * @brief 
+ * Checks Tablebase_SolveCounters against an exhaustive search over 
+ * every ordering of the scores, for every ending, 2 to 3 counters and 
+ * small games. Prints the number of positions checked.
+ * 
+ * @param maxTarget The largest target to check, capped to keep the search small.
+ * @param maxAdvancement The largest max advancement to check, capped likewise.
+ * @param Mismatches Pointer to a uint. Tablebase_Verify stores the number of positions where the two disagree here.
+ * @return GStatus GST_SUCCESS if every position was solved and agrees, GST_FAILURE otherwise.
+ */
+GStatus Tablebase_Verify(uint64_t maxTarget, uint64_t maxAdvancement, uint64_t *Mismatches)
+{
+    struct rules rules;
+    uint64_t States[TABLEBASE_VERIFY_COUNTERS];
+    uint64_t Sorted[TABLEBASE_VERIFY_COUNTERS];
+    uint64_t *Binomial;
+    uint8_t *Entries;
+    int8_t *Won;
+    uint64_t Positions;
+    uint64_t Product;
+    uint64_t Checked = 0U;
+    uint64_t target;
+    uint64_t k;
+    uint64_t p;
+    uint64_t rest;
+    uint32_t counters;
+    uint32_t i;
+    uint32_t j;
+    uint8_t ending;
+    GStatus Status = GST_SUCCESS;
+
+    maxTarget = (maxTarget < TABLEBASE_VERIFY_TARGET) ? maxTarget : TABLEBASE_VERIFY_TARGET;
+    maxAdvancement = (maxAdvancement < TABLEBASE_VERIFY_MOVES) ? maxAdvancement : TABLEBASE_VERIFY_MOVES;
+    *Mismatches = 0U;
+
+    for (ending = GAME_END_NORMAL; ending <= GAME_END_FIRST && Status == GST_SUCCESS; ending++)
+    for (counters = 2U; counters <= TABLEBASE_VERIFY_COUNTERS && Status == GST_SUCCESS; counters++)
+    for (target = 1U; target <= maxTarget && Status == GST_SUCCESS; target++)
+    for (k = 1U; k <= maxAdvancement && Status == GST_SUCCESS; k++)
+    {
+        Game_InitRules(&rules, target, k);
+        rules.Ending = ending;
+
+        for (Product = 1U, i = 0U; i < counters; i++)
+        {
+            Product *= target + 1U;
+        }
+        if (Tablebase_CountPositions(&rules, counters, &Positions) != GST_SUCCESS)
+        {
+            Status = GST_FAILURE;
+            break;
+        }
+        Entries = calloc(Positions, sizeof(uint8_t));
+        Won = malloc(Product*sizeof(int8_t));
+        Binomial = Tablebase_Binomials(target, counters);
+        if (Entries == NULL || Won == NULL || Binomial == NULL ||
+            Tablebase_SolveCounters(&rules, counters, TABLEBASE_VERIFY_THREADS, Entries) != GST_SUCCESS)
+        {
+            Status = GST_FAILURE;
+        }
+        else
+        {
+            memset(Won, -1, Product*sizeof(int8_t));
+            for (p = 0U; p < Product; p++)
+            {
+                for (rest = p, i = 0U; i < counters; i++)
+                {
+                    States[i] = rest % (target + 1U);
+                    rest /= target + 1U;
+
+                    for (j = i; j > 0U && Sorted[j - 1U] > States[i]; j--)
+                    {
+                        Sorted[j] = Sorted[j - 1U];
+                    }
+                    Sorted[j] = States[i];
+                }
+
+                if (Entries[Tablebase_Index(Binomial, counters, Sorted)] !=
+                    (Game_Search(&rules, counters, States, Won, p) ? TABLEBASE_WON : TABLEBASE_LOST))
+                {
+                    (*Mismatches)++;
+                }
+                Checked++;
+            }
+        }
+
+        free(Entries);
+        free(Won);
+        free(Binomial);
+    }
+
+    printf("Verified %" PRIu64 " tablebase positions, %" PRIu64 " mismatches\n", Checked, *Mismatches);
+
+    return (Status == GST_SUCCESS && *Mismatches == 0U) ? GST_SUCCESS : GST_FAILURE;
+};
+
+/**
+ * @brief 
+ * Builds Pascal's triangle for the indexes of up to counters scores 
+ * no higher than target. Entries too large for 64 bits saturate, they 
+ * are only reached by games too large to store anyway.
+ */
+static uint64_t *Tablebase_Binomials(uint64_t target, uint32_t counters)
+{
+    uint64_t rows = target + counters;
+    uint64_t *table;
+    uint64_t n;
+    uint64_t k;
+
+    if (rows > SIZE_MAX / sizeof(uint64_t) / ((uint64_t) counters + 1U))
+    {
+        return NULL;
+    }
+    table = calloc(rows*((uint64_t) counters + 1U), sizeof(uint64_t));
+    if (table == NULL)
+    {
+        return NULL;
+    }
+
+    for (n = 0U; n < rows; n++)
+    {
+        TABLEBASE_BINOMIAL(table, counters, n, 0U) = 1U;
+        for (k = 1U; k <= counters && k <= n; k++)
+        {
+            uint64_t a = TABLEBASE_BINOMIAL(table, counters, n - 1U, k - 1U);
+            uint64_t b = TABLEBASE_BINOMIAL(table, counters, n - 1U, k);
+            TABLEBASE_BINOMIAL(table, counters, n, k) = (a > UINT64_MAX - b) ? UINT64_MAX : a + b;
+        }
+    }
+
+    return table;
+}
+
+/**
+ * @brief 
+ * The index of a combination of scores sorted in ascending order. 
+ * Adding i to the i-th score makes them strictly increasing, and the 
+ * combinatorial number system numbers those densely from 0.
+ */
+static uint64_t Tablebase_Index(const uint64_t *Binomial, uint32_t counters, const uint64_t *Scores)
+{
+    uint64_t index = 0U;
+    uint32_t i;
+
+    for (i = 0U; i < counters; i++)
+    {
+        index += TABLEBASE_BINOMIAL(Binomial, counters, Scores[i] + i, i + 1U);
+    }
+
+    return index;
+}
+
+/**
+ * @brief Solves every combination of the current layer whose highest score is the task's Top.
+ */
+static void Tablebase_SolveTop(threadpool_t pool, uint32_t Worker, void *Arg)
+{
+    struct counters_task *task = (struct counters_task *) Arg;
+    struct counters_solve *Solve = task->Solve;
+    uint64_t *Scores = Solve->Scratch + (uint64_t) Worker*Solve->Counters;
+    (void) pool;
+
+    Scores[Solve->Counters - 1U] = task->Top;
+    Tablebase_Enumerate(Solve, Scores, Solve->Counters - 1U, Solve->Layer - task->Top, task->Top);
+}
+
+/**
+ * @brief 
+ * Fills the lowest Slots scores, in descending order, with every way 
+ * of adding up to Remaining without going over Ceiling, and solves 
+ * each combination once they are all filled.
+ */
+static void Tablebase_Enumerate(struct counters_solve *Solve, uint64_t *Scores, uint32_t Slots, uint64_t Remaining, uint64_t Ceiling)
+{
+    uint64_t v;
+
+    if (Slots == 0U)
+    {
+        if (Remaining == 0U)
+        {
+            Tablebase_SolvePosition(Solve, Scores);
+        }
+        return;
+    }
+
+    // The rest can't add up to Remaining once this slot is below an even share
+    for (v = (Remaining < Ceiling) ? Remaining : Ceiling; v*Slots >= Remaining; v--)
+    {
+        Scores[Slots - 1U] = v;
+        Tablebase_Enumerate(Solve, Scores, Slots - 1U, Remaining - v, v);
+        if (v == 0U)
+        {
+            break;
+        }
+    }
+}
+
+/**
+ * @brief 
+ * Solves one combination from the layers above it. Moving the last 
+ * of a run of equal scores keeps the rest sorted, so the index of 
+ * every child is found by updating the parent's, as the moved score 
+ * passes the scores above it.
+ */
+static void Tablebase_SolvePosition(struct counters_solve *Solve, const uint64_t *Scores)
+{
+    const uint64_t *Binomial = Solve->Binomial;
+    rules_t rules = Solve->Rules;
+    uint32_t counters = Solve->Counters;
+    uint64_t index = Tablebase_Index(Binomial, counters, Scores);
+    uint64_t base;
+    uint64_t delta;
+    uint64_t v;
+    uint64_t a;
+    uint32_t p;
+    uint32_t q;
+    uint8_t moverWins;
+
+    if (Game_IsOver(rules, Scores, counters, &moverWins))
+    {
+        Solve->Entries[index] = moverWins ? TABLEBASE_WON : TABLEBASE_LOST;
+        return;
+    }
+
+    for (p = 0U; p < counters; p++)
+    {
+        if (p + 1U < counters && Scores[p + 1U] == Scores[p])
+        {
+            continue;
+        }
+
+        base = index - TABLEBASE_BINOMIAL(Binomial, counters, Scores[p] + p, p + 1U);
+        delta = 0U;
+        q = p;
+        for (a = 1U; a <= rules->MaxAdvancement && a <= rules->Target - Scores[p]; a++)
+        {
+            v = Scores[p] + a;
+            // Scores the moved one passes shift down a place, wrapping sums cancel out
+            while (q + 1U < counters && Scores[q + 1U] <= v)
+            {
+                q++;
+                delta += TABLEBASE_BINOMIAL(Binomial, counters, Scores[q] + q - 1U, q)
+                       - TABLEBASE_BINOMIAL(Binomial, counters, Scores[q] + q, q + 1U);
+            }
+            if (Solve->Entries[base + delta + TABLEBASE_BINOMIAL(Binomial, counters, v + q, q + 1U)] == TABLEBASE_LOST)
+            {
+                Solve->Entries[index] = TABLEBASE_WON;
+                return;
+            }
+        }
+    }
+
+    // No move leaves the opponent lost
+    Solve->Entries[index] = TABLEBASE_LOST;
+}
+
+/**
+ * @brief Allocates the path a file is written to before it is renamed to Path.
+ */
+static char *Tablebase_TempPath(const char *Path)
+{
+    size_t length = strlen(Path);
+    char *tmpPath = malloc(length + sizeof(".tmp"));
+
+    if (tmpPath != NULL)
+    {
+        memcpy(tmpPath, Path, length);
+        memcpy(tmpPath + length, ".tmp", sizeof(".tmp"));
+    }
+
+    return tmpPath;
+}
+
+/*** end of file ***/
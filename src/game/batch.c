@@ -0,0 +1,525 @@
+/** @file batch.c
+ * 
+ * @brief 
+ * Plays many games of "Who Say's 20 First" between two players 
+ * without any output, and collects the results. Pairings of the 
+ * players whose moves are cheap are played by loops generated for 
+ * the pairing, with both players inlined.
+ *
+ * @par       
+ * COPYRIGHT NOTICE: (c) 2021 Graham Power.  All rights reserved.
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */ 
+
+#include "batch.h"
+#include "random.h"
+#include "closedform.h"
+#include "compiled.h"
+#include "generated/policy.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+/************************** Constant Definitions *****************************/
+
+// The player types Batch_Play inlines, and their index in BatchPairs
+#define BATCH_INLINE_RANDOM         0U
+#define BATCH_INLINE_CLOSED_FORM    1U
+#define BATCH_INLINE_COMPILED       2U
+#define BATCH_INLINE_TYPES          3U
+#define BATCH_INLINE_NONE           UINT8_MAX
+
+// The games every pairing plays for every rules in Batch_Verify
+#define BATCH_VERIFY_GAMES          16U
+
+/**************************** Type Definitions *******************************/
+
+// A loop generated by BATCH_DEFINE_PAIR. Seeds holds the random state
+// of both players, and gets the state they finish with.
+typedef void (*batch_pair_t)(rules_t rules, uint64_t *Seeds, uint64_t games, batch_result_t result);
+
+/***************** Macros (Inline Functions) Definitions *********************/
+
+// The move each inlined player picks with Remaining left to the target,
+// the same one its Choose function picks. Seed is the players random state.
+#define BATCH_MOVE_RANDOM(rules, Remaining, Seed) \
+    RULES_MOVE(rules, RANDOM_NEXT(Seed) % (((rules)->Moves == NULL) ? \
+        (((Remaining) < (rules)->MaxAdvancement) ? (Remaining) : (rules)->MaxAdvancement) : Game_LegalMoves(rules, Remaining)))
+#define BATCH_MOVE_CLOSED_FORM(rules, Remaining, Seed)  CLOSEDFORM_ADVANCE(rules, Remaining)
+#define BATCH_MOVE_COMPILED(rules, Remaining, Seed)     ((uint64_t) PolicyMoves[(rules)->Target - (Remaining)])
+
+// Plays one move of a pairing loop, and leaves the game loop once no move fits
+#define BATCH_PAIR_MOVE(Move, Seed, Player) \
+    advancement = Move(rules, remaining, Seed); \
+    remaining -= advancement; \
+    counts[advancement - 1U]++; \
+    moves++; \
+    if (remaining < first) \
+    { \
+        lastMover[Player]++; \
+        break; \
+    }
+
+// Defines Batch_Play<Name>, the loop of the pairing where Move1 moves
+// first. Both moves are inlined and a round is two moves, so there is
+// no call through the Actors and no test of whose turn it is. Only legal
+// moves are picked, so only the end of the game has to be checked.
+#define BATCH_DEFINE_PAIR(Name, Move1, Move2) \
+    static void Batch_Play##Name(rules_t rules, uint64_t *Seeds, uint64_t games, batch_result_t result) \
+    { \
+        const uint64_t first = RULES_MOVE(rules, 0U); \
+        uint64_t *counts = result->MoveCounts; \
+        uint64_t seed1 = Seeds[0]; \
+        uint64_t seed2 = Seeds[1]; \
+        uint64_t lastMover[2] = { 0U, 0U }; \
+        uint64_t moves = 0U; \
+        uint64_t remaining; \
+        uint64_t advancement; \
+        uint64_t i; \
+        uint8_t mover = GAME_MOVER_WINS(rules) ? 0U : 1U; \
+        \
+        for (i = 0U; i < games; i++) \
+        { \
+            remaining = rules->Target; \
+            for (;;) \
+            { \
+                BATCH_PAIR_MOVE(Move1, seed1, 0U) \
+                BATCH_PAIR_MOVE(Move2, seed2, 1U) \
+            } \
+        } \
+        \
+        result->Games += games; \
+        result->TotalMoves += moves; \
+        result->Wins[mover] += lastMover[0]; \
+        result->Wins[mover ^ 1U] += lastMover[1]; \
+        Seeds[0] = seed1; \
+        Seeds[1] = seed2; \
+    }
+
+/************************** Function Prototypes ******************************/
+
+static uint8_t Batch_InlineType(Actor_t Actor, rules_t rules);
+
+/************************** Function Definitions *****************************/
+
+BATCH_DEFINE_PAIR(RandomRandom, BATCH_MOVE_RANDOM, BATCH_MOVE_RANDOM)
+BATCH_DEFINE_PAIR(RandomClosedForm, BATCH_MOVE_RANDOM, BATCH_MOVE_CLOSED_FORM)
+BATCH_DEFINE_PAIR(RandomCompiled, BATCH_MOVE_RANDOM, BATCH_MOVE_COMPILED)
+BATCH_DEFINE_PAIR(ClosedFormRandom, BATCH_MOVE_CLOSED_FORM, BATCH_MOVE_RANDOM)
+BATCH_DEFINE_PAIR(ClosedFormClosedForm, BATCH_MOVE_CLOSED_FORM, BATCH_MOVE_CLOSED_FORM)
+BATCH_DEFINE_PAIR(ClosedFormCompiled, BATCH_MOVE_CLOSED_FORM, BATCH_MOVE_COMPILED)
+BATCH_DEFINE_PAIR(CompiledRandom, BATCH_MOVE_COMPILED, BATCH_MOVE_RANDOM)
+BATCH_DEFINE_PAIR(CompiledClosedForm, BATCH_MOVE_COMPILED, BATCH_MOVE_CLOSED_FORM)
+BATCH_DEFINE_PAIR(CompiledCompiled, BATCH_MOVE_COMPILED, BATCH_MOVE_COMPILED)
+
+// Indexed by the inline types of [player 1][player 2]
+static const batch_pair_t BatchPairs[BATCH_INLINE_TYPES][BATCH_INLINE_TYPES] = {
+    { Batch_PlayRandomRandom, Batch_PlayRandomClosedForm, Batch_PlayRandomCompiled },
+    { Batch_PlayClosedFormRandom, Batch_PlayClosedFormClosedForm, Batch_PlayClosedFormCompiled },
+    { Batch_PlayCompiledRandom, Batch_PlayCompiledClosedForm, Batch_PlayCompiledCompiled },
+};
+
+/**
+ * @brief Initializes an empty result for games played with the passed in rules.
+ * 
+ * @param result The result to initialize.
+ * @param rules The rules of the games that will be counted.
+ * @return GStatus GST_FAILURE if the move counts could not be allocated, GST_SUCCESS otherwise.
+ */
+GStatus Batch_InitResult(batch_result_t result, rules_t rules)
+{
+    result->Games = 0U;
+    result->Wins[0] = 0U;
+    result->Wins[1] = 0U;
+    result->Errors = 0U;
+    result->TotalMoves = 0U;
+    result->MaxAdvancement = rules->MaxAdvancement;
+    result->MoveCounts = calloc(rules->MaxAdvancement, sizeof(uint64_t));
+
+    return (result->MoveCounts == NULL) ? GST_FAILURE : GST_SUCCESS;
+};
+
+/**
+ * @brief Releases the move counts allocated by Batch_InitResult.
+ * 
+ * @param result The result to release.
+ * @return GStatus The success of the release.
+ */
+GStatus Batch_FreeResult(batch_result_t result)
+{
+    free(result->MoveCounts);
+    result->MoveCounts = NULL;
+
+    return GST_SUCCESS;
+};
+
+/**
+ * @brief 
+ * Creates both players from their configurations, plays the passed 
+ * in number of games between them with Batch_Play, and releases them.
+ * 
+ * @param rules The rules of every game.
+ * @param player1 The configuration of the player who moves first.
+ * @param player2 The configuration of the player who moves second.
+ * @param games The number of games to play.
+ * @param result 
+ * The result to add the games to. Must have been initialized 
+ * with Batch_InitResult for the same rules.
+ * @return GStatus GST_FAILURE if a player can't be created or can't play on its own, GST_SUCCESS otherwise.
+ */
+GStatus Batch_Run(rules_t rules, const struct actor_config *player1, const struct actor_config *player2, uint64_t games, batch_result_t result)
+{
+    struct Actor Actor1;
+    struct Actor Actor2;
+    GStatus Status;
+
+    if (Actors_Create(&Actor1, player1, rules) != GST_SUCCESS)
+    {
+        return GST_FAILURE;
+    }
+    if (Actors_Create(&Actor2, player2, rules) != GST_SUCCESS)
+    {
+        Actors_Destroy(&Actor1);
+        return GST_FAILURE;
+    }
+
+    Status = Batch_Play(rules, &Actor1, &Actor2, games, result);
+
+    Actors_Destroy(&Actor1);
+    Actors_Destroy(&Actor2);
+
+    return Status;
+};
+
+/**
+ * @brief 
+ * Plays the passed in number of games between two players, so 
+ * nothing is printed. When both players are random, closed form or 
+ * compiled players, the games are played by the loop generated for 
+ * the pairing. Any other pairing is played by Batch_PlayActors. 
+ * Both give the same result and leave the players in the same state.
+ * 
+ * @param rules The rules of every game.
+ * @param player1 The player who moves first.
+ * @param player2 The player who moves second.
+ * @param games The number of games to play.
+ * @param result The result to add the games to.
+ * @return GStatus GST_FAILURE if a player can't play on its own, GST_SUCCESS otherwise.
+ */
+GStatus Batch_Play(rules_t rules, Actor_t player1, Actor_t player2, uint64_t games, batch_result_t result)
+{
+    uint64_t Seeds[2] = { 0U, 0U };
+    uint8_t inline1 = Batch_InlineType(player1, rules);
+    uint8_t inline2 = Batch_InlineType(player2, rules);
+
+    // A random player playing itself would need both moves to share one state
+    if (inline1 == BATCH_INLINE_NONE || inline2 == BATCH_INLINE_NONE || rules->Target < RULES_MOVE(rules, 0U) ||
+        (inline1 == BATCH_INLINE_RANDOM && player1->ActorBase == player2->ActorBase))
+    {
+        return Batch_PlayActors(rules, player1, player2, games, result);
+    }
+
+    if (inline1 == BATCH_INLINE_RANDOM)
+    {
+        Seeds[0] = ((random_t) player1->ActorBase)->State;
+    }
+    if (inline2 == BATCH_INLINE_RANDOM)
+    {
+        Seeds[1] = ((random_t) player2->ActorBase)->State;
+    }
+
+    BatchPairs[inline1][inline2](rules, Seeds, games, result);
+
+    if (inline1 == BATCH_INLINE_RANDOM)
+    {
+        ((random_t) player1->ActorBase)->State = Seeds[0];
+    }
+    if (inline2 == BATCH_INLINE_RANDOM)
+    {
+        ((random_t) player2->ActorBase)->State = Seeds[1];
+    }
+
+    return GST_SUCCESS;
+};
+
+/**
+ * @brief 
+ * Plays the passed in number of games between any two players that 
+ * can play on their own. Moves are picked with each Actors Choose 
+ * function and applied with Game_AdvanceState. A game that hits an 
+ * illegal move is stopped and counted as an error.
+ * 
+ * @param rules The rules of every game.
+ * @param player1 The player who moves first.
+ * @param player2 The player who moves second.
+ * @param games The number of games to play.
+ * @param result The result to add the games to.
+ * @return GStatus GST_FAILURE if a player can't play on its own, GST_SUCCESS otherwise.
+ */
+GStatus Batch_PlayActors(rules_t rules, Actor_t player1, Actor_t player2, uint64_t games, batch_result_t result)
+{
+    struct game game;
+    Actor_t players[2] = { player1, player2 };
+    Actor_t actor;
+    uint64_t Advancement;
+    uint64_t i;
+    GStatus Status;
+    uint8_t turn;
+
+    if (player1->Choose == NULL || player2->Choose == NULL)
+    {
+        return GST_FAILURE;
+    }
+
+    game.Rules = rules;
+    game.Player1 = player1;
+    game.Player2 = player2;
+    game.States = NULL;
+    game.Counters = 1U;
+
+    for (i = 0U; i < games; i++)
+    {
+        game.State = 0U;
+        game.Live = 1U;
+        game.Won = GAME_NOT_WON;
+        turn = 0U;
+
+        do
+        {
+            actor = players[turn];
+            game.PlayerTurn = turn ? TURN_PLAYER2 : TURN_PLAYER1;
+            actor->Choose(&game, actor->ActorBase, &Advancement);
+            Status = Game_AdvanceState(&game, Advancement);
+            if (Status == GST_INVALID_STATE)
+            {
+                result->Errors++;
+                break;
+            }
+
+            result->TotalMoves++;
+            result->MoveCounts[Advancement - 1U]++;
+            if (Status == GST_GAME_WON)
+            {
+                result->Wins[GAME_MOVER_WINS(rules) ? turn : turn ^ 1U]++;
+            }
+            turn ^= 1U;
+        } while (Status == GST_SUCCESS);
+
+        result->Games++;
+    }
+
+    return GST_SUCCESS;
+};
+
+/**
+ * @brief Adds the games counted in one result to another.
+ * 
+ * @param into The result to add to.
+ * @param from The result to add, played with the same max advancement.
+ * @return GStatus GST_INVALID_STATE if the results don't have the same max advancement, GST_SUCCESS otherwise.
+ */
+GStatus Batch_Merge(batch_result_t into, const struct batch_result *from)
+{
+    uint64_t a;
+
+    if (into->MaxAdvancement != from->MaxAdvancement)
+    {
+        return GST_INVALID_STATE;
+    }
+
+    into->Games += from->Games;
+    into->Wins[0] += from->Wins[0];
+    into->Wins[1] += from->Wins[1];
+    into->Errors += from->Errors;
+    into->TotalMoves += from->TotalMoves;
+    for (a = 0U; a < into->MaxAdvancement; a++)
+    {
+        into->MoveCounts[a] += from->MoveCounts[a];
+    }
+
+    return GST_SUCCESS;
+};
+
+/**
+ * @brief Prints the win counts, average game length and move distribution of a result.
+ * 
+ * @param result The result to print.
+ * @return GStatus The success of the print.
+ */
+GStatus Batch_PrintResult(const struct batch_result *result)
+{
+    uint64_t a;
+    double length = (result->Games == 0U) ? 0.0 : (double) result->TotalMoves / (double) result->Games;
+
+    printf("Games: %" PRIu64 "\n", result->Games);
+    printf("Player 1 Wins: %" PRIu64 "\n", result->Wins[0]);
+    printf("Player 2 Wins: %" PRIu64 "\n", result->Wins[1]);
+    printf("Errors: %" PRIu64 "\n", result->Errors);
+    printf("Average Game Length: %.3f moves\n", length);
+    printf("Move Distribution:\n");
+    for (a = 0U; a < result->MaxAdvancement; a++)
+    {
+        if (result->MoveCounts[a] != 0U)
+        {
+            printf("  Add %" PRIu64 ": %" PRIu64 " (%.2f%%)\n", a + 1U, result->MoveCounts[a],
+                100.0 * (double) result->MoveCounts[a] / (double) result->TotalMoves);
+        }
+    }
+
+    return GST_SUCCESS;
+};
+
+/**
+ * @brief 
+ * Checks the loops generated for every pairing of the inlined 
+ * players against Batch_PlayActors, for every target up to maxTarget, 
+ * every range of moves up to maxAdvancement, a few sets of moves and 
+ * every ending. The results and the random states the players are 
+ * left in have to match. Prints the number of games checked.
+ * 
+ * @param maxTarget The largest target in the sweep.
+ * @param maxAdvancement The largest max advancement in the sweep.
+ * @param Mismatches Pointer to a uint. Batch_Verify stores the number of pairings and rules that disagree here.
+ * @return GStatus GST_SUCCESS if every pairing agrees, GST_FAILURE otherwise.
+ */
+GStatus Batch_Verify(uint64_t maxTarget, uint64_t maxAdvancement, uint64_t *Mismatches)
+{
+    static const uint64_t Sparse[][3] = {
+        { 1U, 3U, 4U },
+        { 2U, 5U, 0U },
+        { 3U, 64U, 65U },
+    };
+    static const uint32_t SparseCounts[] = { 3U, 2U, 3U };
+    static const uint8_t Types[BATCH_INLINE_TYPES] = { RANDOM, CLOSED_FORM, COMPILED };
+    uint64_t sparseSets = sizeof(SparseCounts)/sizeof(SparseCounts[0]);
+    struct actor_config Config1 = { .Seed = 0x9E3779B97F4A7C15ULL };
+    struct actor_config Config2 = { .Seed = 0xD1B54A32D192ED03ULL };
+    struct Actor Inlined[2];
+    struct Actor Called[2];
+    struct batch_result InlinedResult;
+    struct batch_result CalledResult;
+    struct rules rules;
+    uint64_t Checked = 0U;
+    uint64_t Target;
+    uint64_t Config;
+    uint8_t Ending;
+    uint8_t t1;
+    uint8_t t2;
+    uint8_t i;
+    GStatus Status = GST_SUCCESS;
+
+    *Mismatches = 0U;
+
+    // The compiled player only plays the rules in parameters.h, they are always part of the sweep
+    if (maxTarget < MAX_STATE)
+    {
+        maxTarget = MAX_STATE;
+    }
+    if (maxAdvancement < MAX_STATE_ADVANCEMENT)
+    {
+        maxAdvancement = MAX_STATE_ADVANCEMENT;
+    }
+
+    for (Ending = GAME_END_NORMAL; Ending <= GAME_END_FIRST && Status == GST_SUCCESS; Ending++)
+    for (Target = 1U; Target <= maxTarget && Status == GST_SUCCESS; Target++)
+    for (Config = 0U; Config < maxAdvancement + sparseSets && Status == GST_SUCCESS; Config++)
+    {
+        // The first configs are the ranges 1 to K, then the sets of moves
+        if (Config < maxAdvancement)
+        {
+            Game_InitRules(&rules, Target, Config + 1U);
+        }
+        else if (Game_InitMoveSet(&rules, Target, Sparse[Config - maxAdvancement], SparseCounts[Config - maxAdvancement]) != GST_SUCCESS)
+        {
+            continue;
+        }
+        rules.Ending = Ending;
+
+        for (t1 = 0U; t1 < BATCH_INLINE_TYPES && Status == GST_SUCCESS; t1++)
+        for (t2 = 0U; t2 < BATCH_INLINE_TYPES && Status == GST_SUCCESS; t2++)
+        {
+            Config1.Type = Types[t1];
+            Config2.Type = Types[t2];
+            if (Actors_Supports(Config1.Type, &rules) != GST_SUCCESS || Actors_Supports(Config2.Type, &rules) != GST_SUCCESS)
+            {
+                continue;
+            }
+
+            // Zeroed, so players that were never created can still be destroyed
+            memset(Inlined, 0, sizeof(Inlined));
+            memset(Called, 0, sizeof(Called));
+            InlinedResult.MoveCounts = NULL;
+            CalledResult.MoveCounts = NULL;
+            if (Actors_Create(&Inlined[0], &Config1, &rules) != GST_SUCCESS || Actors_Create(&Inlined[1], &Config2, &rules) != GST_SUCCESS ||
+                Actors_Create(&Called[0], &Config1, &rules) != GST_SUCCESS || Actors_Create(&Called[1], &Config2, &rules) != GST_SUCCESS ||
+                Batch_InitResult(&InlinedResult, &rules) != GST_SUCCESS || Batch_InitResult(&CalledResult, &rules) != GST_SUCCESS)
+            {
+                Status = GST_FAILURE;
+            }
+            else
+            {
+                Batch_Play(&rules, &Inlined[0], &Inlined[1], BATCH_VERIFY_GAMES, &InlinedResult);
+                Batch_PlayActors(&rules, &Called[0], &Called[1], BATCH_VERIFY_GAMES, &CalledResult);
+                Checked += BATCH_VERIFY_GAMES;
+
+                if (InlinedResult.Games != CalledResult.Games || InlinedResult.Wins[0] != CalledResult.Wins[0] ||
+                    InlinedResult.Wins[1] != CalledResult.Wins[1] || InlinedResult.Errors != CalledResult.Errors ||
+                    InlinedResult.TotalMoves != CalledResult.TotalMoves ||
+                    memcmp(InlinedResult.MoveCounts, CalledResult.MoveCounts, rules.MaxAdvancement*sizeof(uint64_t)) != 0 ||
+                    (Types[t1] == RANDOM && ((random_t) Inlined[0].ActorBase)->State != ((random_t) Called[0].ActorBase)->State) ||
+                    (Types[t2] == RANDOM && ((random_t) Inlined[1].ActorBase)->State != ((random_t) Called[1].ActorBase)->State))
+                {
+                    (*Mismatches)++;
+                    printf("Mismatch: Target(%" PRIu64 "), Config(%" PRIu64 "), Ending(%u), Players(%s, %s), Inlined Wins(%" PRIu64 ", %" PRIu64 ") Moves(%" PRIu64 ") Errors(%" PRIu64 "), Called Wins(%" PRIu64 ", %" PRIu64 ") Moves(%" PRIu64 ") Errors(%" PRIu64 ")\n",
+                        Target, Config, Ending, Actors_Name(Types[t1]), Actors_Name(Types[t2]),
+                        InlinedResult.Wins[0], InlinedResult.Wins[1], InlinedResult.TotalMoves, InlinedResult.Errors,
+                        CalledResult.Wins[0], CalledResult.Wins[1], CalledResult.TotalMoves, CalledResult.Errors);
+                }
+            }
+            Batch_FreeResult(&InlinedResult);
+            Batch_FreeResult(&CalledResult);
+
+            for (i = 0U; i < 2U; i++)
+            {
+                Actors_Destroy(&Inlined[i]);
+                Actors_Destroy(&Called[i]);
+            }
+        }
+    }
+
+    printf("Verified %" PRIu64 " inlined batch games, %" PRIu64 " mismatches\n", Checked, *Mismatches);
+
+    return (Status == GST_SUCCESS && *Mismatches == 0U) ? GST_SUCCESS : GST_FAILURE;
+};
+
+/**
+ * @brief Finds which of the inlined players an Actor is, BATCH_INLINE_NONE if it is none of them.
+ */
+static uint8_t Batch_InlineType(Actor_t Actor, rules_t rules)
+{
+    switch (Actor->Type)
+    {
+    case RANDOM:
+        return (Actor->ActorBase != NULL) ? BATCH_INLINE_RANDOM : BATCH_INLINE_NONE;
+    case CLOSED_FORM:
+        return (ClosedForm_Supports(rules) == GST_SUCCESS) ? BATCH_INLINE_CLOSED_FORM : BATCH_INLINE_NONE;
+    case COMPILED:
+        return (Compiled_Supports(rules) == GST_SUCCESS) ? BATCH_INLINE_COMPILED : BATCH_INLINE_NONE;
+    default:
+        return BATCH_INLINE_NONE;
+    }
+}
+
+/*** end of file ***/
@@ -20,6 +20,8 @@
 
 #include "game.h"
 
+#include <string.h>
+
 /************************** Constant Definitions *****************************/
 
 /**************************** Type Definitions *******************************/
@@ -28,22 +30,281 @@
 
 /************************** Function Definitions *****************************/
 
-GStatus Game_Init (game_t game, Actor_t player1, Actor_t player2)
+GStatus Game_InitRules(rules_t rules, uint64_t target, uint64_t maxAdvancement)
+{
+    if (target == 0U || maxAdvancement == 0U)
+    {
+        return GST_INVALID_STATE;
+    }
+
+    rules->Target = target;
+    rules->MaxAdvancement = maxAdvancement;
+    rules->Moves = NULL;
+    rules->MoveCount = 0U;
+    rules->MoveHash = 0U;
+    rules->Ending = GAME_END_NORMAL;
+
+    return GST_SUCCESS;
+};
+
+/**
+ * @brief 
+ * Initializes rules whose moves are any set of advancements, like 
+ * {1, 3, 7}. The moves are not copied, so they must outlive the 
+ * rules. A set that is the whole range 1 to K is stored as a range, 
+ * so it gets the faster paths the solvers have for ranges.
+ * 
+ * A player who can't move without passing the target loses, the 
+ * same as if the other player had said the target.
+ * 
+ * @param rules The rules to initialize.
+ * @param target The score that has to be said to win.
+ * @param moves The allowed moves, ascending and without repeats.
+ * @param count The number of moves.
+ * @return GStatus GST_INVALID_STATE if the moves are not ascending or the first one passes the target, GST_SUCCESS otherwise.
+ */
+GStatus Game_InitMoveSet(rules_t rules, uint64_t target, const uint64_t *moves, uint64_t count)
+{
+    uint64_t hash = 0x6A09E667F3BCC909ULL;
+    uint64_t i;
+
+    if (count == 0U || moves[0] == 0U || moves[0] > target)
+    {
+        return GST_INVALID_STATE;
+    }
+    for (i = 1U; i < count; i++)
+    {
+        if (moves[i] <= moves[i - 1U])
+        {
+            return GST_INVALID_STATE;
+        }
+    }
+
+    if (moves[count - 1U] == count)
+    {
+        return Game_InitRules(rules, target, count);
+    }
+
+    for (i = 0U; i < count; i++)
+    {
+        hash = (hash ^ moves[i]) * 0x100000001B3ULL;
+    }
+
+    rules->Target = target;
+    rules->MaxAdvancement = moves[count - 1U];
+    rules->Moves = moves;
+    rules->MoveCount = count;
+    rules->MoveHash = (hash == 0U) ? 1U : hash;
+    rules->Ending = GAME_END_NORMAL;
+
+    return GST_SUCCESS;
+};
+
+/**
+ * @brief Counts the moves that don't pass the target.
+ * 
+ * @param rules The rules of the game.
+ * @param remaining How far the score is from the target.
+ * @return uint64_t The number of moves no larger than remaining, they are the smallest ones.
+ */
+uint64_t Game_LegalMoves(rules_t rules, uint64_t remaining)
+{
+    uint64_t low = 0U;
+    uint64_t high;
+    uint64_t mid;
+
+    if (rules->Moves == NULL)
+    {
+        return (remaining < rules->MaxAdvancement) ? remaining : rules->MaxAdvancement;
+    }
+
+    // Binary search for the first move past remaining
+    high = rules->MoveCount;
+    while (low < high)
+    {
+        mid = low + (high - low)/2U;
+        if (rules->Moves[mid] <= remaining)
+        {
+            low = mid + 1U;
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+
+    return low;
+};
+
+/**
+ * @brief Checks whether an advancement is one of the moves of the rules.
+ * 
+ * @param rules The rules of the game.
+ * @param advancement The advancement to check.
+ * @return uint8_t 1 if it is a move, 0 otherwise.
+ */
+uint8_t Game_IsLegalMove(rules_t rules, uint64_t advancement)
+{
+    uint64_t below;
+
+    if (advancement == 0U || advancement > rules->MaxAdvancement)
+    {
+        return 0U;
+    }
+    if (rules->Moves == NULL)
+    {
+        return 1U;
+    }
+    below = Game_LegalMoves(rules, advancement);
+
+    return (below > 0U && rules->Moves[below - 1U] == advancement) ? 1U : 0U;
+};
+
+/**
+ * @brief 
+ * Searches whether the player to move wins from the scores of every 
+ * counter, by trying every move on every counter. Slow, but simple 
+ * enough to trust, so it is the reference the solvers are verified 
+ * against.
+ * 
+ * @param rules The rules of the game.
+ * @param counters The number of counters.
+ * @param States The score of every counter. Changed during the search, and restored after it.
+ * @param Won 
+ * The answers so far, by the index of the scores, -1 when not yet 
+ * searched. Holds (Target + 1)^counters entries.
+ * @param Index The index of States, the scores as digits in base Target + 1 with counter 0 the lowest.
+ * @return uint8_t 1 if the player to move wins, 0 otherwise.
+ */
+uint8_t Game_Search(rules_t rules, uint32_t counters, uint64_t *States, int8_t *Won, uint64_t Index)
+{
+    uint64_t place = 1U;
+    uint64_t legal;
+    uint64_t a;
+    uint64_t i;
+    uint32_t c;
+    uint8_t result = 0U;
+
+    if (Won[Index] >= 0)
+    {
+        return (uint8_t) Won[Index];
+    }
+
+    if (Game_IsOver(rules, States, counters, &result))
+    {
+        Won[Index] = (int8_t) result;
+        return result;
+    }
+
+    for (c = 0U; c < counters && result == 0U; c++, place *= rules->Target + 1U)
+    {
+        legal = Game_LegalMoves(rules, rules->Target - States[c]);
+        for (i = 0U; i < legal && result == 0U; i++)
+        {
+            a = RULES_MOVE(rules, i);
+            States[c] += a;
+            result = !Game_Search(rules, counters, States, Won, Index + a*place);
+            States[c] -= a;
+        }
+    }
+    Won[Index] = (int8_t) result;
+    return result;
+};
+
+/**
+ * @brief Gets the ending known by a name on the command line.
+ * 
+ * @param Name Any of normal, misere, first.
+ * @param Ending Pointer to a uint. Game_ParseEnding stores the GAME_END value here.
+ * @return GStatus GST_FAILURE if the name is unknown, GST_SUCCESS otherwise.
+ */
+GStatus Game_ParseEnding(const char *Name, uint8_t *Ending)
+{
+    static const char *const Names[] = {
+        [GAME_END_NORMAL] = "normal",
+        [GAME_END_MISERE] = "misere",
+        [GAME_END_FIRST]  = "first",
+    };
+    uint8_t i;
+
+    for (i = 0U; i < sizeof(Names)/sizeof(Names[0]); i++)
+    {
+        if (strcmp(Name, Names[i]) == 0)
+        {
+            *Ending = i;
+            return GST_SUCCESS;
+        }
+    }
+
+    return GST_FAILURE;
+};
+
+GStatus Game_Init (game_t game, rules_t rules, Actor_t player1, Actor_t player2)
 {
     game->State = 0;
     //DEBUG, REMOVE WHEN FIXED
     // game->State = 15;
+    game->States = NULL;
+    game->Counters = 1U;
+    game->Live = 1U;
     game->Won = GAME_NOT_WON;
+    game->Rules = rules;
     game->Player1 = player1;
     game->Player2 = player2;
     game->PlayerTurn = TURN_PLAYER1;
 
-    #ifdef VERBOSE_OUTPUT
+    if (LOG_ENABLED(LOG_INFO))
+    {
+        printf("===== WHO SAY'S %" PRIu64 " FIRST =====\n", rules->Target);
+        Game_PrintScore(game);
+    }
 
-    printf("===== WHO SAY'S 20 FIRST =====\n");
-    Game_PrintScore(game);
+    return GST_SUCCESS;
+};
 
-    #endif
+/**
+ * @brief 
+ * Initializes a game played on many counters at once. Every counter 
+ * starts at 0 and has the same rules, and a turn advances exactly 
+ * one of them. The counters are stored in the passed in array, which 
+ * must outlive the game.
+ * 
+ * @param game The game to initialize.
+ * @param rules The rules of every counter.
+ * @param states The storage of the counters, counters long.
+ * @param counters The number of counters, at least 1.
+ * @param player1 The actor who moves first.
+ * @param player2 The actor who moves second.
+ * @return GStatus GST_INVALID_STATE if there are no counters, GST_SUCCESS otherwise.
+ */
+GStatus Game_InitCounters(game_t game, rules_t rules, uint64_t *states, uint32_t counters, Actor_t player1, Actor_t player2)
+{
+    uint32_t i;
+
+    if (counters == 0U)
+    {
+        return GST_INVALID_STATE;
+    }
+    for (i = 0U; i < counters; i++)
+    {
+        states[i] = 0U;
+    }
+
+    game->State = 0;
+    game->States = states;
+    game->Counters = counters;
+    game->Live = counters;
+    game->Won = GAME_NOT_WON;
+    game->Rules = rules;
+    game->Player1 = player1;
+    game->Player2 = player2;
+    game->PlayerTurn = TURN_PLAYER1;
+
+    if (LOG_ENABLED(LOG_INFO))
+    {
+        printf("===== WHO SAY'S %" PRIu64 " FIRST, ON %" PRIu32 " COUNTERS =====\n", rules->Target, counters);
+        Game_PrintScore(game);
+    }
 
     return GST_SUCCESS;
 };
@@ -79,11 +340,11 @@ GStatus Game_Spin(game_t game)
         ActionStatus = Game_SpinOnce(game);
     }
 
-    #ifdef VERBOSE_OUTPUT
-    if (ActionStatus == GST_GAME_WON)
+    if (ActionStatus == GST_GAME_WON && LOG_ENABLED(LOG_INFO))
     {
         printf("\n\nGame Over!\n");
-        if (game->PlayerTurn == TURN_PLAYER1)
+        // The turn has already passed on from the player who moved last
+        if ((game->PlayerTurn == TURN_PLAYER1) == GAME_MOVER_WINS(game->Rules))
         {
             printf("Player 2 Wins!\n");
         }
@@ -92,14 +353,27 @@ GStatus Game_Spin(game_t game)
             printf("Player 1 Wins!\n");
         }
     }
-    #endif
 
     return ActionStatus;
 };
 
-GStatus Game_AdvanceState(game_t game, uint8_t advancement)
+GStatus Game_AdvanceState(game_t game, uint64_t advancement)
 {
-    if (advancement <= 0 || advancement > MAX_STATE_ADVANCEMENT || game->State + advancement > MAX_STATE)
+    return Game_AdvanceCounter(game, 0U, advancement);
+};
+
+GStatus Game_AdvanceCounter(game_t game, uint32_t counter, uint64_t advancement)
+{
+    uint64_t *state;
+
+    if (counter >= game->Counters)
+    {
+        return GST_INVALID_STATE;
+    }
+    state = (game->States == NULL) ? &game->State : &game->States[counter];
+
+    // Written as a subtraction so a huge advancement can't wrap the state around
+    if (!Game_IsLegalMove(game->Rules, advancement) || advancement > game->Rules->Target - *state)
     {
         return GST_INVALID_STATE;
     }
@@ -108,9 +382,15 @@ GStatus Game_AdvanceState(game_t game, uint8_t advancement)
         return GST_GAME_WON;
     }
 
-    game->State += advancement;
+    *state += advancement;
+    if (game->Rules->Target - *state < RULES_MOVE(game->Rules, 0U))
+    {
+        game->Live--;
+    }
 
-    if (game->State == MAX_STATE)
+    // The game is over when every move on every counter passes the
+    // target, or as soon as any counter reaches it when that ends it
+    if (game->Live == 0U || (game->Rules->Ending == GAME_END_FIRST && *state == game->Rules->Target))
     {
         game->Won = GAME_WON;
         return GST_GAME_WON;
@@ -121,7 +401,72 @@ GStatus Game_AdvanceState(game_t game, uint8_t advancement)
     }    
 };
 
-GStatus Game_GetState(game_t game, uint8_t *state)
+/**
+ * @brief 
+ * Checks if a game on many counters is over with the passed in 
+ * scores, the same rule Game_AdvanceCounter ends games by, and if 
+ * it is, whether the player to move won. For searches, which keep 
+ * scores of their own instead of a game.
+ * 
+ * @param rules The rules of every counter.
+ * @param Scores The score of every counter.
+ * @param counters The number of counters.
+ * @param MoverWins Pointer to a uint. Game_IsOver stores 1 here if the game is over and the player to move won, 0 otherwise.
+ * @return uint8_t 1 if the game is over, 0 otherwise.
+ */
+uint8_t Game_IsOver(rules_t rules, const uint64_t *Scores, uint32_t counters, uint8_t *MoverWins)
+{
+    uint8_t moved = 0U;
+    uint32_t c;
+
+    *MoverWins = 0U;
+    for (c = 0U; c < counters; c++)
+    {
+        // The player who just moved said the target
+        if (rules->Ending == GAME_END_FIRST && Scores[c] == rules->Target)
+        {
+            return 1U;
+        }
+        if (rules->Target - Scores[c] >= RULES_MOVE(rules, 0U))
+        {
+            moved = 1U;
+        }
+    }
+    if (moved)
+    {
+        return 0U;
+    }
+    // Nobody can move, under misere rules the player who can't move wins
+    *MoverWins = (rules->Ending == GAME_END_MISERE) ? 1U : 0U;
+
+    return 1U;
+};
+
+/**
+ * @brief 
+ * Checks if an earlier counter has the same score as a counter, so 
+ * its moves lead to the same states. Searches skip such counters.
+ * 
+ * @param Scores The score of every counter.
+ * @param Counter The counter to check.
+ * @return uint8_t 1 if a counter before Counter has its score, 0 otherwise.
+ */
+uint8_t Game_IsRepeated(const uint64_t *Scores, uint32_t Counter)
+{
+    uint32_t c;
+
+    for (c = 0U; c < Counter; c++)
+    {
+        if (Scores[c] == Scores[Counter])
+        {
+            return 1U;
+        }
+    }
+
+    return 0U;
+};
+
+GStatus Game_GetState(game_t game, uint64_t *state)
 {
     *state = game->State;
 
@@ -137,25 +482,35 @@ GStatus Game_IsWon(game_t game, uint8_t *isWon)
 
 GStatus Game_PrintTurn(game_t game)
 {
-    #ifdef VERBOSE_OUTPUT
     if (game->PlayerTurn == TURN_PLAYER1)
     {
-        printf("\n\nTurn: Player 1\n");
+        LOG_PRINTF(LOG_INFO, "\n\nTurn: Player 1\n");
     }
     else
     {
-        printf("\n\nTurn: Player 2\n");
+        LOG_PRINTF(LOG_INFO, "\n\nTurn: Player 2\n");
     }
-    #endif
 
     return GST_SUCCESS;
 };
 
 GStatus Game_PrintScore(game_t game)
 {
-    #ifdef VERBOSE_OUTPUT
-    printf("\nCurrent Score: %u\n", game->State);
-    #endif
+    uint32_t i;
+
+    if (game->States == NULL)
+    {
+        LOG_PRINTF(LOG_INFO, "\nCurrent Score: %" PRIu64 "\n", game->State);
+    }
+    else if (LOG_ENABLED(LOG_INFO))
+    {
+        printf("\nCurrent Scores:");
+        for (i = 0U; i < game->Counters; i++)
+        {
+            printf(" %" PRIu64, game->States[i]);
+        }
+        printf("\n");
+    }
 
     return GST_SUCCESS;
 };
@@ -0,0 +1,469 @@
+/** @file gamebatch.c
+ * 
+ * @brief 
+ * Many games with the same rules stored as parallel arrays, a struct of
+ * arrays, and stepped together. A step applies one move to every game
+ * without branching on any of them, with SIMD kernels where the CPU
+ * has them.
+ *
+ * @par       
+ * COPYRIGHT NOTICE: (c) 2021 Graham Power.  All rights reserved.
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */ 
+
+#include "gamebatch.h"
+#include "random.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define GAME_BATCH_X86
+#endif
+
+/************************** Constant Definitions *****************************/
+
+// The games of a batch in GameBatch_Verify, not a multiple of the lanes
+// of any kernel so the scalar tail is checked too.
+#define GAME_BATCH_VERIFY_GAMES     67U
+
+/**************************** Type Definitions *******************************/
+
+/************************** Function Prototypes ******************************/
+
+static uint64_t GameBatch_StepScalar(game_batch_t Batch, const uint64_t *Moves, uint64_t First, uint64_t Last);
+#ifdef GAME_BATCH_X86
+static uint64_t GameBatch_StepAVX2(game_batch_t Batch, const uint64_t *Moves, uint64_t First, uint64_t Last);
+#endif
+
+/************************** Function Definitions *****************************/
+
+/**
+ * @brief 
+ * Allocates a batch of games and starts every one of them, as 
+ * GameBatch_Reset does.
+ * 
+ * @param Batch The batch to initialize.
+ * @param rules The rules of every game, they must outlive the batch.
+ * @param Games The number of games.
+ * @param Kernel Any of the GAME_BATCH_KERNEL_ values, falls back to scalar if the CPU lacks it.
+ * @return GStatus GST_FAILURE if the arrays could not be allocated, GST_SUCCESS otherwise.
+ */
+GStatus GameBatch_Init(game_batch_t Batch, rules_t rules, uint64_t Games, uint8_t Kernel)
+{
+    uint64_t words = (rules->Moves == NULL) ? 1U : (rules->MaxAdvancement >> 6) + 1U;
+    uint64_t i;
+
+    memset(Batch, 0, sizeof(*Batch));
+    Batch->Games = Games;
+    Batch->Rules = rules;
+    if (Games > SIZE_MAX / sizeof(uint64_t) || words > SIZE_MAX / sizeof(uint64_t))
+    {
+        return GST_FAILURE;
+    }
+
+    Batch->States = malloc(Games*sizeof(uint64_t));
+    Batch->Turns = malloc(Games*sizeof(uint8_t));
+    Batch->Won = malloc(Games*sizeof(uint8_t));
+    Batch->Errors = malloc(Games*sizeof(uint8_t));
+    Batch->Legal = calloc(words, sizeof(uint64_t));
+    if ((Games > 0U && (Batch->States == NULL || Batch->Turns == NULL || Batch->Won == NULL || Batch->Errors == NULL)) ||
+        Batch->Legal == NULL)
+    {
+        GameBatch_Free(Batch);
+        return GST_FAILURE;
+    }
+
+    if (rules->Moves == NULL)
+    {
+        Batch->Legal[0] = UINT64_MAX;
+        Batch->WordMask = 0U;
+    }
+    else
+    {
+        for (i = 0U; i < rules->MoveCount; i++)
+        {
+            Batch->Legal[rules->Moves[i] >> 6] |= UINT64_C(1) << (rules->Moves[i] & 63U);
+        }
+        Batch->WordMask = UINT64_MAX;
+    }
+
+    Batch->Kernel = GAME_BATCH_KERNEL_SCALAR;
+    #ifdef GAME_BATCH_X86
+    if (Kernel == GAME_BATCH_KERNEL_AUTO)
+    {
+        Kernel = GameBatch_BestKernel();
+    }
+    if (Kernel == GAME_BATCH_KERNEL_AVX2 && __builtin_cpu_supports("avx2"))
+    {
+        Batch->Kernel = GAME_BATCH_KERNEL_AVX2;
+    }
+    #else
+    (void) Kernel;
+    #endif
+
+    return GameBatch_Reset(Batch);
+};
+
+/**
+ * @brief Starts every game of the batch over, at a score of 0 with player 1 to move.
+ * 
+ * @param Batch The batch to reset.
+ * @return GStatus The success of the reset.
+ */
+GStatus GameBatch_Reset(game_batch_t Batch)
+{
+    if (Batch->Games > 0U)
+    {
+        memset(Batch->States, 0, Batch->Games*sizeof(uint64_t));
+        memset(Batch->Turns, TURN_PLAYER1, Batch->Games*sizeof(uint8_t));
+        memset(Batch->Won, GAME_NOT_WON, Batch->Games*sizeof(uint8_t));
+        memset(Batch->Errors, 0, Batch->Games*sizeof(uint8_t));
+    }
+    Batch->Live = Batch->Games;
+
+    return GST_SUCCESS;
+};
+
+/**
+ * @brief Releases the arrays allocated by GameBatch_Init.
+ * 
+ * @param Batch The batch to release.
+ * @return GStatus The success of the release.
+ */
+GStatus GameBatch_Free(game_batch_t Batch)
+{
+    free(Batch->States);
+    free(Batch->Turns);
+    free(Batch->Won);
+    free(Batch->Errors);
+    free(Batch->Legal);
+    Batch->States = NULL;
+    Batch->Turns = NULL;
+    Batch->Won = NULL;
+    Batch->Errors = NULL;
+    Batch->Legal = NULL;
+    Batch->Games = 0U;
+    Batch->Live = 0U;
+
+    return GST_SUCCESS;
+};
+
+/**
+ * @brief 
+ * Makes one move in every game of the batch, Moves[i] in game i, the 
+ * same way Game_AdvanceState and Game_SpinOnce do for one game. In 
+ * every game still played the move is checked, taken when it is 
+ * legal, the game is won when no move is left after it, and the turn 
+ * passes on. An illegal move stops the game with its Errors set. 
+ * Games that are over ignore their move.
+ * 
+ * Every game is stepped with the same instructions, whatever its 
+ * state, so the kernels have no branches per game.
+ * 
+ * @param Batch The batch to step.
+ * @param Moves Array of Games uints, the move to make in each game.
+ * @return GStatus GST_GAME_WON if every game is over after the step, GST_SUCCESS otherwise.
+ */
+GStatus GameBatch_Step(game_batch_t Batch, const uint64_t *Moves)
+{
+    uint64_t ended;
+
+    #ifdef GAME_BATCH_X86
+    if (Batch->Kernel == GAME_BATCH_KERNEL_AVX2)
+    {
+        ended = GameBatch_StepAVX2(Batch, Moves, 0U, Batch->Games);
+    }
+    else
+    #endif
+    {
+        ended = GameBatch_StepScalar(Batch, Moves, 0U, Batch->Games);
+    }
+    Batch->Live -= ended;
+
+    return (Batch->Live == 0U) ? GST_GAME_WON : GST_SUCCESS;
+};
+
+/**
+ * @brief Gets the fastest kernel the CPU supports.
+ * 
+ * @return uint8_t Any of the GAME_BATCH_KERNEL_ values but auto.
+ */
+uint8_t GameBatch_BestKernel(void)
+{
+    #ifdef GAME_BATCH_X86
+    if (__builtin_cpu_supports("avx2"))
+    {
+        return GAME_BATCH_KERNEL_AVX2;
+    }
+    #endif
+
+    return GAME_BATCH_KERNEL_SCALAR;
+};
+
+/**
+ * @brief Gets the name of a kernel.
+ * 
+ * @param Kernel Any of the GAME_BATCH_KERNEL_ values.
+ * @return const char* The name of the kernel.
+ */
+const char *GameBatch_KernelName(uint8_t Kernel)
+{
+    static const char *const Names[GAME_BATCH_KERNELS] = { "auto", "scalar", "avx2" };
+
+    return (Kernel < GAME_BATCH_KERNELS) ? Names[Kernel] : "unknown";
+};
+
+/**
+ * @brief 
+ * Checks GameBatch_Step with every kernel the CPU supports against 
+ * Game_AdvanceState, for every target up to maxTarget, every max 
+ * advancement up to maxAdvancement and a few sets of moves, under 
+ * normal and misere endings. Every game of a batch is played with 
+ * random moves, some of them illegal, next to a struct game played 
+ * with the same moves. After every step the two have to agree on 
+ * the score, the turn, whether the game is won and whether it was 
+ * stopped.
+ * 
+ * @param maxTarget The largest target in the sweep.
+ * @param maxAdvancement The largest max advancement in the sweep.
+ * @param Mismatches Pointer to a uint. GameBatch_Verify stores the number of disagreements here.
+ * @return GStatus GST_SUCCESS if every step agrees, GST_FAILURE otherwise.
+ */
+GStatus GameBatch_Verify(uint64_t maxTarget, uint64_t maxAdvancement, uint64_t *Mismatches)
+{
+    static const uint64_t Sparse[][3] = {
+        { 1U, 3U, 4U },
+        { 2U, 5U, 0U },
+        { 3U, 64U, 65U },
+    };
+    static const uint32_t SparseCounts[] = { 3U, 2U, 3U };
+    uint64_t sparseSets = sizeof(SparseCounts)/sizeof(SparseCounts[0]);
+    struct game_batch Batch;
+    struct game Games[GAME_BATCH_VERIFY_GAMES];
+    uint8_t Stopped[GAME_BATCH_VERIFY_GAMES];
+    uint64_t Moves[GAME_BATCH_VERIFY_GAMES];
+    struct Random Random = { .State = 0x9E3779B97F4A7C15ULL };
+    struct rules rules;
+    uint64_t Checked = 0U;
+    uint64_t Target;
+    uint64_t Config;
+    uint64_t i;
+    uint8_t Kernel;
+    uint8_t Ending;
+    uint8_t Won;
+    GStatus Status = GST_SUCCESS;
+
+    *Mismatches = 0U;
+
+    for (Kernel = GAME_BATCH_KERNEL_SCALAR; Kernel <= GameBatch_BestKernel() && Status == GST_SUCCESS; Kernel++)
+    for (Ending = GAME_END_NORMAL; Ending <= GAME_END_MISERE && Status == GST_SUCCESS; Ending++)
+    for (Target = 1U; Target <= maxTarget && Status == GST_SUCCESS; Target++)
+    for (Config = 0U; Config < maxAdvancement + sparseSets && Status == GST_SUCCESS; Config++)
+    {
+        // The first configs are the ranges 1 to K, then the sets of moves
+        if (Config < maxAdvancement)
+        {
+            Game_InitRules(&rules, Target, Config + 1U);
+        }
+        else if (Game_InitMoveSet(&rules, Target, Sparse[Config - maxAdvancement], SparseCounts[Config - maxAdvancement]) != GST_SUCCESS)
+        {
+            continue;
+        }
+        rules.Ending = Ending;
+
+        if (GameBatch_Init(&Batch, &rules, GAME_BATCH_VERIFY_GAMES, Kernel) != GST_SUCCESS)
+        {
+            Status = GST_FAILURE;
+            break;
+        }
+        memset(Games, 0, sizeof(Games));
+        memset(Stopped, 0, sizeof(Stopped));
+        for (i = 0U; i < GAME_BATCH_VERIFY_GAMES; i++)
+        {
+            Games[i].Rules = &rules;
+            Games[i].Counters = 1U;
+            Games[i].Live = 1U;
+            Games[i].Won = GAME_NOT_WON;
+            Games[i].PlayerTurn = TURN_PLAYER1;
+        }
+
+        while (Batch.Live > 0U)
+        {
+            // Mostly legal moves, and now and then 0, one past the max or one past the target
+            for (i = 0U; i < GAME_BATCH_VERIFY_GAMES; i++)
+            {
+                Moves[i] = Random_Next(&Random) % (rules.MaxAdvancement + 2U);
+                if (Random_Next(&Random) % 8U != 0U)
+                {
+                    Moves[i] = RULES_MOVE(&rules, Random_Next(&Random) % RULES_MOVE_COUNT(&rules));
+                }
+            }
+
+            GameBatch_Step(&Batch, Moves);
+
+            for (i = 0U; i < GAME_BATCH_VERIFY_GAMES; i++)
+            {
+                if (Games[i].Won != GAME_WON && !Stopped[i])
+                {
+                    Stopped[i] = (Game_AdvanceState(&Games[i], Moves[i]) == GST_INVALID_STATE) ? 1U : 0U;
+                    Games[i].PlayerTurn = (Games[i].PlayerTurn == TURN_PLAYER1) ? TURN_PLAYER2 : TURN_PLAYER1;
+                }
+
+                Won = (Games[i].Won == GAME_WON) ? GAME_WON : GAME_NOT_WON;
+                Checked++;
+                if (Batch.States[i] != Games[i].State || Batch.Turns[i] != Games[i].PlayerTurn ||
+                    Batch.Won[i] != Won || Batch.Errors[i] != Stopped[i])
+                {
+                    (*Mismatches)++;
+                    printf("Mismatch: Kernel(%s), Target(%" PRIu64 "), Config(%" PRIu64 "), Ending(%u), Game(%" PRIu64 "), Move(%" PRIu64 "), Batch State(%" PRIu64 ") Turn(%u) Won(%u) Error(%u), Game State(%" PRIu64 ") Turn(%u) Won(%u) Error(%u)\n",
+                        GameBatch_KernelName(Kernel), Target, Config, Ending, i, Moves[i],
+                        Batch.States[i], Batch.Turns[i], Batch.Won[i], Batch.Errors[i],
+                        Games[i].State, Games[i].PlayerTurn, Won, Stopped[i]);
+                }
+            }
+        }
+
+        GameBatch_Free(&Batch);
+    }
+
+    printf("Verified %" PRIu64 " batch steps, %" PRIu64 " mismatches\n", Checked, *Mismatches);
+
+    return (Status == GST_SUCCESS && *Mismatches == 0U) ? GST_SUCCESS : GST_FAILURE;
+};
+
+/**
+ * @brief 
+ * Steps games First to Last - 1 one at a time. Every condition is 
+ * worked out as 0 or 1 and used as a mask, so the compiler has no 
+ * branches to emit.
+ */
+static uint64_t GameBatch_StepScalar(game_batch_t Batch, const uint64_t *Moves, uint64_t First, uint64_t Last)
+{
+    const uint64_t target = Batch->Rules->Target;
+    const uint64_t max = Batch->Rules->MaxAdvancement;
+    const uint64_t smallest = RULES_MOVE(Batch->Rules, 0U);
+    const uint64_t *Legal = Batch->Legal;
+    const uint64_t wordMask = Batch->WordMask;
+    uint64_t ended = 0U;
+    uint64_t move;
+    uint64_t state;
+    uint64_t playing;
+    uint64_t inRange;
+    uint64_t legal;
+    uint64_t moved;
+    uint64_t over;
+    uint64_t illegal;
+    uint64_t i;
+
+    for (i = First; i < Last; i++)
+    {
+        move = Moves[i];
+        state = Batch->States[i];
+        playing = (uint64_t) ((Batch->Won[i] | Batch->Errors[i]) ^ 1U);
+
+        // A move of 0 wraps around, and fails the check with those past the max
+        inRange = (uint64_t) (move - 1U < max);
+        legal = inRange & (Legal[(move >> 6) & wordMask & (0U - inRange)] >> (move & 63U));
+        legal &= (uint64_t) (move <= target - state);
+
+        moved = playing & legal;
+        illegal = playing & (legal ^ 1U);
+        state += move & (0U - moved);
+        over = moved & (uint64_t) (target - state < smallest);
+
+        Batch->States[i] = state;
+        Batch->Won[i] |= (uint8_t) over;
+        Batch->Errors[i] |= (uint8_t) illegal;
+        Batch->Turns[i] ^= (uint8_t) ((TURN_PLAYER1 ^ TURN_PLAYER2) * playing);
+        ended += over + illegal;
+    }
+
+    return ended;
+}
+
+#ifdef GAME_BATCH_X86
+/**
+ * @brief 
+ * Steps four games per instruction, the rest with the scalar kernel. 
+ * AVX2 only compares signed lanes, so unsigned comparisons flip the 
+ * sign bit of both sides first.
+ */
+__attribute__((target("avx2")))
+static uint64_t GameBatch_StepAVX2(game_batch_t Batch, const uint64_t *Moves, uint64_t First, uint64_t Last)
+{
+    const __m256i one = _mm256_set1_epi64x(1);
+    const __m256i sign = _mm256_set1_epi64x(INT64_MIN);
+    const __m256i low = _mm256_set1_epi64x(63);
+    const __m256i target = _mm256_set1_epi64x((int64_t) Batch->Rules->Target);
+    const __m256i max = _mm256_set1_epi64x((int64_t) (Batch->Rules->MaxAdvancement ^ (uint64_t) INT64_MIN));
+    const __m256i smallest = _mm256_set1_epi64x((int64_t) (RULES_MOVE(Batch->Rules, 0U) ^ (uint64_t) INT64_MIN));
+    const __m256i wordMask = _mm256_set1_epi64x((int64_t) Batch->WordMask);
+    const long long *Legal = (const long long *) Batch->Legal;
+    __m256i move;
+    __m256i state;
+    __m256i playing;
+    __m256i inRange;
+    __m256i legal;
+    __m256i moved;
+    __m256i over;
+    __m256i illegal;
+    uint64_t ended = 0U;
+    uint64_t i;
+    uint32_t done;
+    uint32_t error;
+    uint32_t j;
+    int overBits;
+    int illegalBits;
+    int playingBits;
+
+    for (i = First; i + 4U <= Last; i += 4U)
+    {
+        move = _mm256_loadu_si256((const __m256i *) &Moves[i]);
+        state = _mm256_loadu_si256((const __m256i *) &Batch->States[i]);
+        memcpy(&done, &Batch->Won[i], sizeof(done));
+        memcpy(&error, &Batch->Errors[i], sizeof(error));
+        playing = _mm256_cmpeq_epi64(_mm256_cvtepu8_epi64(_mm_cvtsi32_si128((int) (done | error))), _mm256_setzero_si256());
+
+        inRange = _mm256_cmpgt_epi64(max, _mm256_xor_si256(_mm256_sub_epi64(move, one), sign));
+        legal = _mm256_i64gather_epi64(Legal, _mm256_and_si256(_mm256_and_si256(_mm256_srli_epi64(move, 6), wordMask), inRange), 8);
+        legal = _mm256_cmpeq_epi64(_mm256_and_si256(_mm256_srlv_epi64(legal, _mm256_and_si256(move, low)), one), one);
+        legal = _mm256_and_si256(legal, inRange);
+        legal = _mm256_andnot_si256(_mm256_cmpgt_epi64(_mm256_xor_si256(move, sign), _mm256_xor_si256(_mm256_sub_epi64(target, state), sign)), legal);
+
+        moved = _mm256_and_si256(playing, legal);
+        illegal = _mm256_andnot_si256(legal, playing);
+        state = _mm256_add_epi64(state, _mm256_and_si256(move, moved));
+        over = _mm256_and_si256(moved, _mm256_cmpgt_epi64(smallest, _mm256_xor_si256(_mm256_sub_epi64(target, state), sign)));
+        _mm256_storeu_si256((__m256i *) &Batch->States[i], state);
+
+        // One bit per game, spread back over the byte arrays
+        overBits = _mm256_movemask_pd(_mm256_castsi256_pd(over));
+        illegalBits = _mm256_movemask_pd(_mm256_castsi256_pd(illegal));
+        playingBits = _mm256_movemask_pd(_mm256_castsi256_pd(playing));
+        for (j = 0U; j < 4U; j++)
+        {
+            Batch->Won[i + j] |= (uint8_t) ((overBits >> j) & 1);
+            Batch->Errors[i + j] |= (uint8_t) ((illegalBits >> j) & 1);
+            Batch->Turns[i + j] ^= (uint8_t) ((TURN_PLAYER1 ^ TURN_PLAYER2) * ((playingBits >> j) & 1));
+        }
+        ended += (uint64_t) __builtin_popcount((unsigned int) (overBits | illegalBits));
+    }
+
+    return ended + GameBatch_StepScalar(Batch, Moves, i, Last);
+}
+#endif
+
+/*** end of file ***/
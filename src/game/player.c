@@ -1,6 +1,10 @@
 /** @file player.c
  * 
- * @brief A manual player for the game. 
+ * @brief 
+ * A manual player for the game. The player is a state machine fed 
+ * with whatever input has arrived, so it never waits on a human and 
+ * one thread can drive the turns of many of them. Player_Act drives 
+ * it from a descriptor for games played in the terminal.
  *
  * @par       
  * COPYRIGHT NOTICE: (c) 2021 Graham Power.  All rights reserved.
@@ -19,39 +23,632 @@
  */ 
 
 #include "player.h"
+#include "random.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <unistd.h>
+#include <inttypes.h>
 
 /************************** Constant Definitions *****************************/
 
+// The kinds of line Player_Verify types, most of them not a legal move
+#define PLAYER_VERIFY_MOVE      0U
+#define PLAYER_VERIFY_PADDED    1U
+#define PLAYER_VERIFY_PAST      2U
+#define PLAYER_VERIFY_ZERO      3U
+#define PLAYER_VERIFY_WORD      4U
+#define PLAYER_VERIFY_EMPTY     5U
+#define PLAYER_VERIFY_OVERLONG  6U
+#define PLAYER_VERIFY_SUFFIX    7U
+#define PLAYER_VERIFY_KINDS     8U
+
+// The most bytes of script Player_Verify types for one game
+#define PLAYER_VERIFY_SCRIPT    4096U
+
+// How Player_Verify splits the script, all at once, a byte at a time or in random chunks
+#define PLAYER_VERIFY_FEEDS     3U
+
 /**************************** Type Definitions *******************************/
 
 /************************** Function Prototypes ******************************/
 
+static GStatus Player_Write(player_t Player, const char *Format, ...);
+static GStatus Player_Prompt(player_t Player, game_t game);
+static GStatus Player_Line(player_t Player, game_t game);
+static GStatus Player_Parse(const char *Line, uint32_t Length, uint64_t *Value);
+static GStatus Player_Run(rules_t rules, const char *Script, size_t Length, uint8_t Feed, uint64_t *Trace, uint64_t *Moves, struct Player *Players);
+
 /************************** Function Definitions *****************************/
 
-GStatus Player_Init(Actor_t Actor)
+/**
+ * @brief 
+ * Initializes a manual player Actor. Player_Act reads the moves 
+ * from the passed in descriptor, event loops that read for the 
+ * player pass them to Player_Feed instead.
+ * 
+ * @param Actor The actor who will use Player_Act to advance a game state.
+ * @param Player The pointer to the player struct, used as a class-like representation.
+ * @param Fd The descriptor Player_Act reads, -1 if it is never called.
+ * @return GStatus The success of the initialization.
+ */
+GStatus Player_Init(Actor_t Actor, player_t Player, int Fd)
 {
+    Actor->Type = USER;
     Actor->Action = Player_Act;
+    Actor->Choose = NULL;
+    Actor->ActorBase = Player;
+
+    memset(Player, 0, sizeof(*Player));
+    Player->Phase = PLAYER_IDLE;
+    Player->Fd = Fd;
 
     return GST_SUCCESS;
 };
 
-GStatus Player_Act(game_t game, void* ActorBase)
+/**
+ * @brief Releases the output allocated by the player.
+ * 
+ * @param Player The player to release.
+ * @return GStatus The success of the release.
+ */
+GStatus Player_Free(player_t Player)
 {
-    GStatus ActionState = GST_INVALID_STATE;    
-    int score = 0;
-    while(ActionState == GST_INVALID_STATE)
+    free(Player->Output);
+    Player->Output = NULL;
+    Player->OutputLength = 0U;
+    Player->OutputCapacity = 0U;
+
+    return GST_SUCCESS;
+};
+
+/**
+ * @brief 
+ * Takes an action of behalf of the Actor that called it. Reads the 
+ * players descriptor until a line makes a legal move, and prints the 
+ * prompts and errors to stdout. Input after the move is kept for the 
+ * next turn.
+ * 
+ * @param game The game to take the action in.
+ * @param ActorBase The Actors base structure, a Player structure.
+ * @return GStatus The status of the move, GST_FAILURE if the input ended without one.
+ */
+GStatus Player_Act(game_t game, void *ActorBase)
+{
+    player_t Player = (player_t) ActorBase;
+    GStatus Status = Player_Begin(Player, game);
+    ssize_t got;
+    size_t used;
+
+    while (Status == GST_NEEDS_INPUT)
     {
-        printf("Add 1 or 2? : ");
+        fwrite(Player->Output, 1U, Player->OutputLength, stdout);
         fflush(stdout);
-        scanf("%d", &score);
-        ActionState = Game_AdvanceState(game, (uint8_t) score);
-        if (ActionState == GST_INVALID_STATE)
+        Player_Drain(Player, Player->OutputLength);
+
+        if (Player->UnreadLength == 0U)
+        {
+            got = read(Player->Fd, Player->Unread, sizeof(Player->Unread));
+            if (got < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (got <= 0)
+            {
+                Status = Player_Close(Player, game);
+                break;
+            }
+            Player->UnreadStart = 0U;
+            Player->UnreadLength = (size_t) got;
+        }
+
+        Status = Player_Feed(Player, game, &Player->Unread[Player->UnreadStart], Player->UnreadLength, &used);
+        Player->UnreadStart += used;
+        Player->UnreadLength -= used;
+    }
+
+    fwrite(Player->Output, 1U, Player->OutputLength, stdout);
+    fflush(stdout);
+    Player_Drain(Player, Player->OutputLength);
+
+    return Status;
+};
+
+/**
+ * @brief 
+ * Starts the turn of the player, and queues the first prompt. Once 
+ * the input has ended every turn fails straight away.
+ * 
+ * @param Player The player whose turn it is.
+ * @param game The game being played.
+ * @return GStatus GST_FAILURE if the input has ended, GST_NEEDS_INPUT otherwise.
+ */
+GStatus Player_Begin(player_t Player, game_t game)
+{
+    if (Player->Phase == PLAYER_CLOSED)
+    {
+        return GST_FAILURE;
+    }
+    Player->Phase = (game->Counters > 1U) ? PLAYER_COUNTER : PLAYER_MOVE;
+    Player->Counter = 0U;
+
+    return (Player_Prompt(Player, game) == GST_SUCCESS) ? GST_NEEDS_INPUT : GST_FAILURE;
+};
+
+/**
+ * @brief 
+ * Feeds the player the input that has arrived, in pieces of any size. 
+ * Bytes are used up to the end of the line that makes a legal move, 
+ * the rest belongs to the next turn. Lines that aren't a number, or 
+ * not a legal one, are refused and the turn starts over.
+ * 
+ * @param Player The player whose turn it is.
+ * @param game The game being played.
+ * @param Input The bytes that arrived.
+ * @param Length The number of bytes that arrived.
+ * @param Used Pointer to a uint. Player_Feed stores the number of bytes it used here.
+ * @return GStatus The status of the move once one is made, GST_NEEDS_INPUT until then, GST_INVALID_STATE if it isn't the players turn.
+ */
+GStatus Player_Feed(player_t Player, game_t game, const char *Input, size_t Length, size_t *Used)
+{
+    GStatus Status;
+    size_t i;
+
+    *Used = 0U;
+    if (Player->Phase != PLAYER_COUNTER && Player->Phase != PLAYER_MOVE)
+    {
+        return GST_INVALID_STATE;
+    }
+
+    for (i = 0U; i < Length; i++)
+    {
+        if (Input[i] != '\n')
+        {
+            if (Player->LineLength < PLAYER_LINE_MAX)
+            {
+                Player->Line[Player->LineLength++] = Input[i];
+            }
+            else
+            {
+                Player->Overlong = 1U;
+            }
+            continue;
+        }
+
+        Status = Player_Line(Player, game);
+        if (Status != GST_NEEDS_INPUT)
+        {
+            *Used = i + 1U;
+            return Status;
+        }
+    }
+    *Used = Length;
+
+    return GST_NEEDS_INPUT;
+};
+
+/**
+ * @brief 
+ * Tells the player its input has ended. A last line without a 
+ * newline is still read, after that every turn fails.
+ * 
+ * @param Player The player whose input ended.
+ * @param game The game being played.
+ * @return GStatus The status of the move if the last line made one, GST_FAILURE otherwise.
+ */
+GStatus Player_Close(player_t Player, game_t game)
+{
+    GStatus Status = GST_FAILURE;
+
+    if ((Player->Phase == PLAYER_COUNTER || Player->Phase == PLAYER_MOVE) &&
+        (Player->LineLength > 0U || Player->Overlong))
+    {
+        Status = Player_Line(Player, game);
+    }
+    if (Status == GST_NEEDS_INPUT || Status == GST_FAILURE)
+    {
+        Status = GST_FAILURE;
+        Player_Write(Player, "\nInput Ended!\n");
+    }
+    Player->Phase = PLAYER_CLOSED;
+
+    return Status;
+};
+
+/**
+ * @brief Removes output that has been written out from the front of the players output.
+ * 
+ * @param Player The player whose output was written.
+ * @param Written The number of bytes written, at most OutputLength.
+ * @return GStatus The success of the drain.
+ */
+GStatus Player_Drain(player_t Player, size_t Written)
+{
+    if (Written > Player->OutputLength)
+    {
+        Written = Player->OutputLength;
+    }
+    memmove(Player->Output, Player->Output + Written, Player->OutputLength - Written);
+    Player->OutputLength -= Written;
+
+    return GST_SUCCESS;
+};
+
+/**
+ * @brief 
+ * Plays scripted games between two players, for every target up to 
+ * maxTarget and every max advancement up to maxAdvancement. Scripts 
+ * mix legal moves with words, empty and overlong lines, and numbers 
+ * that can't be played, and end without a newline half of the time. 
+ * Each script is fed whole, a byte at a time and in random chunks, 
+ * and every feed has to play the moves the script holds and print 
+ * the same output.
+ * 
+ * @param maxTarget The largest target in the sweep.
+ * @param maxAdvancement The largest max advancement in the sweep.
+ * @param Mismatches Pointer to a uint. Player_Verify stores the number of feeds that went wrong here.
+ * @return GStatus GST_SUCCESS if every feed plays its script, GST_FAILURE otherwise.
+ */
+GStatus Player_Verify(uint64_t maxTarget, uint64_t maxAdvancement, uint64_t *Mismatches)
+{
+    struct Random Random = { .State = 0x2545F4914F6CDD1DULL };
+    struct Player Whole[2];
+    struct Player Fed[2];
+    struct rules rules;
+    char *Script;
+    uint64_t *Expected;
+    uint64_t *Trace;
+    uint64_t ExpectedMoves;
+    uint64_t Moves;
+    uint64_t Checked = 0U;
+    uint64_t Target;
+    uint64_t K;
+    uint64_t State;
+    uint64_t Move;
+    size_t Length;
+    uint8_t Kind;
+    uint8_t Feed;
+    uint8_t p;
+    int Written;
+
+    *Mismatches = 0U;
+    Script = malloc(PLAYER_VERIFY_SCRIPT);
+    Expected = malloc((maxTarget + 1U)*sizeof(uint64_t));
+    Trace = malloc((maxTarget + 1U)*sizeof(uint64_t));
+    if (Script == NULL || Expected == NULL || Trace == NULL)
+    {
+        free(Script);
+        free(Expected);
+        free(Trace);
+        return GST_FAILURE;
+    }
+
+    for (Target = 1U; Target <= maxTarget; Target++)
+    for (K = 1U; K <= maxAdvancement; K++)
+    {
+        Game_InitRules(&rules, Target, K);
+
+        // Write a script for a whole game, with the states each legal move leads to
+        Length = 0U;
+        State = 0U;
+        ExpectedMoves = 0U;
+        while (State < Target && Length + 3U*PLAYER_LINE_MAX < PLAYER_VERIFY_SCRIPT)
+        {
+            Move = 1U + Random_Next(&Random) % ((Target - State < K) ? Target - State : K);
+            Kind = (uint8_t) (Random_Next(&Random) % PLAYER_VERIFY_KINDS);
+            switch (Kind)
+            {
+            case PLAYER_VERIFY_MOVE:
+                Written = snprintf(&Script[Length], PLAYER_VERIFY_SCRIPT - Length, "%" PRIu64 "\n", Move);
+                break;
+            case PLAYER_VERIFY_PADDED:
+                Written = snprintf(&Script[Length], PLAYER_VERIFY_SCRIPT - Length, " \t%" PRIu64 " \r\n", Move);
+                break;
+            case PLAYER_VERIFY_PAST:
+                Written = snprintf(&Script[Length], PLAYER_VERIFY_SCRIPT - Length, "%" PRIu64 "\n", Target - State + 1U);
+                break;
+            case PLAYER_VERIFY_ZERO:
+                Written = snprintf(&Script[Length], PLAYER_VERIFY_SCRIPT - Length, "0\n");
+                break;
+            case PLAYER_VERIFY_WORD:
+                Written = snprintf(&Script[Length], PLAYER_VERIFY_SCRIPT - Length, "two\n");
+                break;
+            case PLAYER_VERIFY_EMPTY:
+                Written = snprintf(&Script[Length], PLAYER_VERIFY_SCRIPT - Length, "\n");
+                break;
+            case PLAYER_VERIFY_OVERLONG:
+                // Starts with a legal move, but is longer than a line can be
+                Written = snprintf(&Script[Length], PLAYER_VERIFY_SCRIPT - Length, "%" PRIu64 "%*s\n", Move, (int) PLAYER_LINE_MAX, "");
+                break;
+            default:
+                Written = snprintf(&Script[Length], PLAYER_VERIFY_SCRIPT - Length, "%" PRIu64 "x\n", Move);
+                break;
+            }
+            Length += (size_t) Written;
+
+            if (Kind == PLAYER_VERIFY_MOVE || Kind == PLAYER_VERIFY_PADDED)
+            {
+                State += Move;
+                Expected[ExpectedMoves++] = State;
+            }
+        }
+        // Half of the scripts end without a newline after the last line
+        if (Random_Next(&Random) % 2U == 0U && Length > 0U)
+        {
+            Length--;
+        }
+
+        Player_Run(&rules, Script, Length, 0U, Trace, &Moves, Whole);
+        for (Feed = 0U; Feed < PLAYER_VERIFY_FEEDS; Feed++)
+        {
+            if (Feed > 0U)
+            {
+                Player_Run(&rules, Script, Length, Feed, Trace, &Moves, Fed);
+            }
+            else
+            {
+                memcpy(Fed, Whole, sizeof(Fed));
+            }
+
+            Checked++;
+            if (Moves != ExpectedMoves || memcmp(Trace, Expected, Moves*sizeof(uint64_t)) != 0 ||
+                Fed[0].OutputLength != Whole[0].OutputLength || Fed[1].OutputLength != Whole[1].OutputLength ||
+                memcmp(Fed[0].Output, Whole[0].Output, Whole[0].OutputLength) != 0 ||
+                memcmp(Fed[1].Output, Whole[1].Output, Whole[1].OutputLength) != 0)
+            {
+                (*Mismatches)++;
+                printf("Mismatch: Target(%" PRIu64 "), K(%" PRIu64 "), Feed(%u), Moves(%" PRIu64 ") Expected(%" PRIu64 ")\n",
+                    Target, K, Feed, Moves, ExpectedMoves);
+            }
+
+            if (Feed > 0U)
+            {
+                for (p = 0U; p < 2U; p++)
+                {
+                    Player_Free(&Fed[p]);
+                }
+            }
+        }
+        for (p = 0U; p < 2U; p++)
         {
-            printf("Input Not Allowed, Can Only Be 1 or 2!\n");
+            Player_Free(&Whole[p]);
         }
     }
 
-    return ActionState;
+    free(Script);
+    free(Expected);
+    free(Trace);
+
+    printf("Verified %" PRIu64 " scripted player feeds, %" PRIu64 " mismatches\n", Checked, *Mismatches);
+
+    return (*Mismatches == 0U) ? GST_SUCCESS : GST_FAILURE;
 };
 
-/*** end of file ***/
\ No newline at end of file
+/**
+ * @brief Adds formatted text to the end of the players output, growing it as needed.
+ */
+static GStatus Player_Write(player_t Player, const char *Format, ...)
+{
+    va_list args;
+    char *grown;
+    size_t capacity;
+    int needed;
+
+    va_start(args, Format);
+    needed = vsnprintf(NULL, 0, Format, args);
+    va_end(args);
+    if (needed < 0)
+    {
+        return GST_FAILURE;
+    }
+
+    if (Player->OutputLength + (size_t) needed + 1U > Player->OutputCapacity)
+    {
+        capacity = (Player->OutputCapacity == 0U) ? 64U : Player->OutputCapacity;
+        while (Player->OutputLength + (size_t) needed + 1U > capacity)
+        {
+            capacity *= 2U;
+        }
+        grown = realloc(Player->Output, capacity);
+        if (grown == NULL)
+        {
+            return GST_FAILURE;
+        }
+        Player->Output = grown;
+        Player->OutputCapacity = capacity;
+    }
+
+    va_start(args, Format);
+    vsnprintf(Player->Output + Player->OutputLength, Player->OutputCapacity - Player->OutputLength, Format, args);
+    va_end(args);
+    Player->OutputLength += (size_t) needed;
+
+    return GST_SUCCESS;
+}
+
+/**
+ * @brief Queues the prompt for the phase the player is in.
+ */
+static GStatus Player_Prompt(player_t Player, game_t game)
+{
+    GStatus Status;
+    uint64_t i;
+
+    if (Player->Phase == PLAYER_COUNTER)
+    {
+        return Player_Write(Player, "Counter 1 to %" PRIu32 "? : ", game->Counters);
+    }
+    if (game->Rules->Moves == NULL)
+    {
+        return Player_Write(Player, "Add 1 to %" PRIu64 "? : ", game->Rules->MaxAdvancement);
+    }
+
+    Status = Player_Write(Player, "Add %" PRIu64, game->Rules->Moves[0]);
+    for (i = 1U; i < game->Rules->MoveCount && Status == GST_SUCCESS; i++)
+    {
+        Status = Player_Write(Player, ", %" PRIu64, game->Rules->Moves[i]);
+    }
+
+    return (Status == GST_SUCCESS) ? Player_Write(Player, "? : ") : Status;
+}
+
+/**
+ * @brief 
+ * Acts on the line the player finished typing, and clears it. 
+ * Returns the status of the move if it made one, GST_NEEDS_INPUT if 
+ * the player has more to type.
+ */
+static GStatus Player_Line(player_t Player, game_t game)
+{
+    GStatus Status = GST_INVALID_STATE;
+    uint64_t Value = 0U;
+
+    if (!Player->Overlong && Player_Parse(Player->Line, Player->LineLength, &Value) == GST_SUCCESS)
+    {
+        Status = GST_SUCCESS;
+    }
+    Player->LineLength = 0U;
+    Player->Overlong = 0U;
+
+    if (Player->Phase == PLAYER_COUNTER)
+    {
+        if (Status == GST_SUCCESS && Value >= 1U && Value <= game->Counters)
+        {
+            Player->Counter = (uint32_t) (Value - 1U);
+            Player->Phase = PLAYER_MOVE;
+        }
+        else
+        {
+            Player_Write(Player, "Input Not Allowed, Can Only Be A Counter From 1 to %" PRIu32 "!\n", game->Counters);
+        }
+        Player_Prompt(Player, game);
+
+        return GST_NEEDS_INPUT;
+    }
+
+    if (Status == GST_SUCCESS)
+    {
+        Status = Game_AdvanceCounter(game, Player->Counter, Value);
+    }
+    if (Status != GST_INVALID_STATE)
+    {
+        Player->Phase = PLAYER_IDLE;
+        return Status;
+    }
+
+    if (game->Rules->Moves == NULL)
+    {
+        Player_Write(Player, "Input Not Allowed, Can Only Be 1 to %" PRIu64 " Without Passing %" PRIu64 "!\n", game->Rules->MaxAdvancement, game->Rules->Target);
+    }
+    else
+    {
+        Player_Write(Player, "Input Not Allowed, Can Only Be One Of The Moves Without Passing %" PRIu64 "!\n", game->Rules->Target);
+    }
+    // A bad move asks for the counter again too
+    Player->Phase = (game->Counters > 1U) ? PLAYER_COUNTER : PLAYER_MOVE;
+    Player_Prompt(Player, game);
+
+    return GST_NEEDS_INPUT;
+}
+
+/**
+ * @brief 
+ * Reads a line as a whole number. Blanks around the number are 
+ * allowed, anything else in the line, or a number too big for 64 
+ * bits, is not.
+ */
+static GStatus Player_Parse(const char *Line, uint32_t Length, uint64_t *Value)
+{
+    uint32_t i = 0U;
+    uint32_t digits = 0U;
+    uint64_t value = 0U;
+
+    while (i < Length && (Line[i] == ' ' || Line[i] == '\t'))
+    {
+        i++;
+    }
+    for (; i < Length && Line[i] >= '0' && Line[i] <= '9'; i++, digits++)
+    {
+        if (value > (UINT64_MAX - (uint64_t) (Line[i] - '0'))/10U)
+        {
+            return GST_FAILURE;
+        }
+        value = 10U*value + (uint64_t) (Line[i] - '0');
+    }
+    while (i < Length && (Line[i] == ' ' || Line[i] == '\t' || Line[i] == '\r'))
+    {
+        i++;
+    }
+    if (digits == 0U || i != Length)
+    {
+        return GST_FAILURE;
+    }
+    *Value = value;
+
+    return GST_SUCCESS;
+}
+
+/**
+ * @brief 
+ * Plays one scripted game for Player_Verify, between two players 
+ * fed from the same script in turn. Feed 0 passes all that is left 
+ * at once, 1 a byte at a time and 2 random chunks. Stores the state 
+ * after each move in Trace, and leaves the players for their output 
+ * to be compared.
+ */
+static GStatus Player_Run(rules_t rules, const char *Script, size_t Length, uint8_t Feed, uint64_t *Trace, uint64_t *Moves, struct Player *Players)
+{
+    struct Random Random = { .State = 0x9E3779B97F4A7C15ULL };
+    struct Actor Actors[2];
+    struct game game;
+    GStatus Status;
+    size_t Position = 0U;
+    size_t Chunk;
+    size_t used;
+    uint8_t turn = 0U;
+
+    memset(&game, 0, sizeof(game));
+    game.Rules = rules;
+    game.Counters = 1U;
+    game.Live = 1U;
+    game.Won = GAME_NOT_WON;
+    game.PlayerTurn = TURN_PLAYER1;
+    Player_Init(&Actors[0], &Players[0], -1);
+    Player_Init(&Actors[1], &Players[1], -1);
+    game.Player1 = &Actors[0];
+    game.Player2 = &Actors[1];
+
+    *Moves = 0U;
+    Status = Player_Begin(&Players[turn], &game);
+    while (Status == GST_NEEDS_INPUT || Status == GST_SUCCESS)
+    {
+        if (Status == GST_SUCCESS)
+        {
+            Trace[(*Moves)++] = game.State;
+            turn ^= 1U;
+            game.PlayerTurn = turn ? TURN_PLAYER2 : TURN_PLAYER1;
+            Status = Player_Begin(&Players[turn], &game);
+            continue;
+        }
+
+        if (Position == Length)
+        {
+            Status = Player_Close(&Players[turn], &game);
+            continue;
+        }
+        Chunk = (Feed == 0U) ? Length - Position : (Feed == 1U) ? 1U : 1U + Random_Next(&Random) % 7U;
+        Chunk = (Chunk > Length - Position) ? Length - Position : Chunk;
+        Status = Player_Feed(&Players[turn], &game, &Script[Position], Chunk, &used);
+        Position += used;
+    }
+    if (Status == GST_GAME_WON)
+    {
+        Trace[(*Moves)++] = game.State;
+    }
+
+    return Status;
+}
+
+/*** end of file ***/
@@ -0,0 +1,923 @@
+/** @file server.c
+ * 
+ * @brief 
+ * A long running server that plays games against clients over a Unix
+ * or localhost TCP socket. One thread multiplexes every connection
+ * with epoll, and the players are shared by every game with the same
+ * rules, so each game is solved once.
+ * 
+ * Requests and replies are lines of text, one reply per request:
+ *   NEW <player> <first> [<target> <max advancement> [<ending>]]
+ *       Starts a game against a player type, abandoning the last one.
+ *       first is 1 if the client moves first and 2 if the server does.
+ *       Without rules, the rules the server was started with are used.
+ *       dynamic games are played by the table solver, whose cost is bounded.
+ *   MOVE <advancement>
+ *       Plays a move of the client, and the move of the server after it.
+ *   QUIT
+ *       Closes the connection once the reply is sent.
+ * The replies to NEW and MOVE are PLAY, WIN or LOSS, with the move the
+ * server played, 0 if it didn't move, and the score after it. PLAY is
+ * the clients turn, WIN and LOSS end the game. QUIT is answered with
+ * BYE, and a request that can't be played with ERR and a reason.
+ *
+ * @par       
+ * COPYRIGHT NOTICE: (c) 2021 Graham Power.  All rights reserved.
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */ 
+
+#include "server.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <signal.h>
+#include <inttypes.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+
+#include "log.h"
+
+/************************** Constant Definitions *****************************/
+
+// The most bytes taken from a session at once, the rest waits for the next event
+#define SERVER_READ_SIZE        4096U
+
+/**************************** Type Definitions *******************************/
+
+// Set by Server_Stop, from a signal handler or anywhere else
+static volatile sig_atomic_t Stopping = 0;
+
+/************************** Function Prototypes ******************************/
+
+static GStatus Server_Listen(server_t Server, const char *Address);
+static GStatus Server_Accept(server_t Server);
+static GStatus Server_Read(server_t Server, struct server_session *Session);
+static GStatus Server_Request(server_t Server, struct server_session *Session, char *Line);
+static GStatus Server_New(server_t Server, struct server_session *Session, char **Save);
+static GStatus Server_Move(server_t Server, struct server_session *Session, char **Save);
+static GStatus Server_Play(server_t Server, struct server_session *Session, uint64_t *Advancement);
+static GStatus Server_Result(server_t Server, struct server_session *Session, GStatus Status, uint64_t Advancement);
+static GStatus Server_Reply(struct server_session *Session, const char *Format, ...);
+static GStatus Server_Error(server_t Server, struct server_session *Session, const char *Reason);
+static GStatus Server_Flush(server_t Server, struct server_session *Session);
+static GStatus Server_Close(server_t Server, struct server_session *Session);
+static struct server_player *Server_Acquire(server_t Server, uint8_t Type, rules_t rules);
+static GStatus Server_Release(struct server_session *Session);
+static GStatus Server_Number(const char *Text, uint64_t *Value);
+static uint64_t Server_Work(uint8_t Type, rules_t rules);
+static void Server_OnSignal(int Signal);
+
+/************************** Function Definitions *****************************/
+
+/**
+ * @brief 
+ * Opens the socket of the server and starts listening on it. No 
+ * connection is taken until Server_Run.
+ * 
+ * @param Server The server to initialize.
+ * @param Address Either unix:PATH, or tcp:PORT to listen on localhost.
+ * @param rules The rules of games that don't name their own, copied. A move set must outlive the server.
+ * @param Config The settings every server player is made with, the type is picked by each game.
+ * @return GStatus GST_FAILURE if the address can't be listened on, GST_SUCCESS otherwise.
+ */
+GStatus Server_Init(server_t Server, const char *Address, rules_t rules, const struct actor_config *Config)
+{
+    memset(Server, 0, sizeof(*Server));
+    Server->Epoll = -1;
+    Server->Listen = -1;
+    Server->Rules = *rules;
+    Server->Config = *Config;
+
+    Server->Epoll = epoll_create1(EPOLL_CLOEXEC);
+    if (Server->Epoll < 0 || Server_Listen(Server, Address) != GST_SUCCESS)
+    {
+        Server_Free(Server);
+        return GST_FAILURE;
+    }
+
+    return GST_SUCCESS;
+};
+
+/**
+ * @brief 
+ * Closes every session and the socket of the server, removes a Unix 
+ * socket from the file system and releases the players.
+ * 
+ * @param Server The server to release.
+ * @return GStatus The success of the release.
+ */
+GStatus Server_Free(server_t Server)
+{
+    uint32_t i;
+
+    while (Server->Sessions != NULL)
+    {
+        Server_Close(Server, Server->Sessions);
+    }
+    if (Server->Listen >= 0)
+    {
+        close(Server->Listen);
+        Server->Listen = -1;
+    }
+    if (Server->Epoll >= 0)
+    {
+        close(Server->Epoll);
+        Server->Epoll = -1;
+    }
+    if (Server->Path != NULL)
+    {
+        unlink(Server->Path);
+        free(Server->Path);
+        Server->Path = NULL;
+    }
+
+    for (i = 0U; i < SERVER_PLAYERS; i++)
+    {
+        if (Server->Players[i].Used)
+        {
+            Actors_Destroy(&Server->Players[i].Actor);
+            Server->Players[i].Used = 0U;
+        }
+    }
+
+    return GST_SUCCESS;
+};
+
+/**
+ * @brief 
+ * Serves every connection until Server_Stop is called, or the 
+ * process gets SIGINT or SIGTERM. The signals are only let through 
+ * while waiting for events, so a stop is never missed.
+ * 
+ * @param Server The server to run.
+ * @return GStatus GST_FAILURE if waiting for events fails, GST_SUCCESS once stopped.
+ */
+GStatus Server_Run(server_t Server)
+{
+    struct epoll_event Events[SERVER_EVENTS];
+    struct sigaction Action;
+    struct sigaction OldInt;
+    struct sigaction OldTerm;
+    struct server_session *Session;
+    sigset_t Blocked;
+    sigset_t Original;
+    sigset_t Waiting;
+    GStatus Status = GST_SUCCESS;
+    int count;
+    int i;
+
+    memset(&Action, 0, sizeof(Action));
+    Action.sa_handler = Server_OnSignal;
+    sigemptyset(&Action.sa_mask);
+    sigemptyset(&Blocked);
+    sigaddset(&Blocked, SIGINT);
+    sigaddset(&Blocked, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &Blocked, &Original);
+    Waiting = Original;
+    sigdelset(&Waiting, SIGINT);
+    sigdelset(&Waiting, SIGTERM);
+    sigaction(SIGINT, &Action, &OldInt);
+    sigaction(SIGTERM, &Action, &OldTerm);
+
+    Stopping = 0;
+    while (!Stopping)
+    {
+        count = epoll_pwait(Server->Epoll, Events, SERVER_EVENTS, -1, &Waiting);
+        if (count < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            Status = GST_FAILURE;
+            break;
+        }
+
+        for (i = 0; i < count; i++)
+        {
+            Session = (struct server_session *) Events[i].data.ptr;
+            if (Session == NULL)
+            {
+                Server_Accept(Server);
+                continue;
+            }
+
+            // Sending first frees room, which may let the session be read again
+            if ((Events[i].events & EPOLLOUT) && Server_Flush(Server, Session) != GST_SUCCESS)
+            {
+                continue;
+            }
+            if (Events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR))
+            {
+                Server_Read(Server, Session);
+            }
+        }
+    }
+
+    sigaction(SIGINT, &OldInt, NULL);
+    sigaction(SIGTERM, &OldTerm, NULL);
+    pthread_sigmask(SIG_SETMASK, &Original, NULL);
+
+    return Status;
+};
+
+/**
+ * @brief Makes Server_Run return once the events it is handling are done. Safe to call from a signal handler.
+ * 
+ * @return GStatus The success of the request.
+ */
+GStatus Server_Stop(void)
+{
+    Stopping = 1;
+
+    return GST_SUCCESS;
+};
+
+/**
+ * @brief Prints the connections, requests and games the server has served.
+ * 
+ * @param Server The server to print.
+ * @return GStatus The success of the print.
+ */
+GStatus Server_PrintStats(server_t Server)
+{
+    uint32_t players = 0U;
+    uint32_t i;
+
+    for (i = 0U; i < SERVER_PLAYERS; i++)
+    {
+        players += Server->Players[i].Used;
+    }
+
+    printf("Connections: %" PRIu64 "\n", Server->Stats.Accepted);
+    printf("Requests: %" PRIu64 " (%" PRIu64 " errors)\n", Server->Stats.Requests, Server->Stats.Errors);
+    printf("Games: %" PRIu64 " (%" PRIu64 " finished)\n", Server->Stats.Games, Server->Stats.Finished);
+    printf("Players: %" PRIu32 "\n", players);
+
+    return GST_SUCCESS;
+};
+
+/**
+ * @brief 
+ * Creates the listening socket for an address and adds it to epoll. 
+ * A Unix socket left behind by a server that is gone is replaced, 
+ * any other file in the way is not.
+ */
+static GStatus Server_Listen(server_t Server, const char *Address)
+{
+    struct sockaddr_un Unix;
+    struct sockaddr_in Inet;
+    struct epoll_event Event;
+    struct stat Info;
+    uint64_t port;
+    int probe;
+    int one = 1;
+
+    if (strncmp(Address, "unix:", 5U) == 0)
+    {
+        memset(&Unix, 0, sizeof(Unix));
+        Unix.sun_family = AF_UNIX;
+        if (Address[5] == '\0' || strlen(&Address[5]) >= sizeof(Unix.sun_path))
+        {
+            return GST_FAILURE;
+        }
+        strcpy(Unix.sun_path, &Address[5]);
+
+        if (lstat(Unix.sun_path, &Info) == 0)
+        {
+            probe = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+            if (!S_ISSOCK(Info.st_mode) || probe < 0 || connect(probe, (struct sockaddr *) &Unix, sizeof(Unix)) == 0)
+            {
+                LOG_PRINTF(LOG_INFO, "%s is in use\n", Unix.sun_path);
+                if (probe >= 0)
+                {
+                    close(probe);
+                }
+                return GST_FAILURE;
+            }
+            close(probe);
+            unlink(Unix.sun_path);
+        }
+
+        Server->Listen = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (Server->Listen < 0 || bind(Server->Listen, (struct sockaddr *) &Unix, sizeof(Unix)) != 0)
+        {
+            return GST_FAILURE;
+        }
+        Server->Path = strdup(Unix.sun_path);
+    }
+    else if (strncmp(Address, "tcp:", 4U) == 0)
+    {
+        if (Server_Number(&Address[4], &port) != GST_SUCCESS || port == 0U || port > UINT16_MAX)
+        {
+            return GST_FAILURE;
+        }
+        memset(&Inet, 0, sizeof(Inet));
+        Inet.sin_family = AF_INET;
+        Inet.sin_port = htons((uint16_t) port);
+        Inet.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+        Server->Listen = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (Server->Listen < 0)
+        {
+            return GST_FAILURE;
+        }
+        setsockopt(Server->Listen, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        if (bind(Server->Listen, (struct sockaddr *) &Inet, sizeof(Inet)) != 0)
+        {
+            return GST_FAILURE;
+        }
+    }
+    else
+    {
+        return GST_FAILURE;
+    }
+
+    // The listening socket is the one event without a session
+    memset(&Event, 0, sizeof(Event));
+    Event.events = EPOLLIN;
+    Event.data.ptr = NULL;
+    if (listen(Server->Listen, SERVER_BACKLOG) != 0 || epoll_ctl(Server->Epoll, EPOLL_CTL_ADD, Server->Listen, &Event) != 0)
+    {
+        return GST_FAILURE;
+    }
+
+    return GST_SUCCESS;
+}
+
+/**
+ * @brief Takes every pending connection as a new session.
+ */
+static GStatus Server_Accept(server_t Server)
+{
+    struct server_session *Session;
+    struct epoll_event Event;
+    int fd;
+
+    for (;;)
+    {
+        fd = accept(Server->Listen, NULL, NULL);
+        if (fd < 0)
+        {
+            // Out of descriptors or memory leaves the rest in the backlog for later
+            return (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) ? GST_SUCCESS : GST_FAILURE;
+        }
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+        fcntl(fd, F_SETFD, FD_CLOEXEC);
+
+        Session = calloc(1U, sizeof(struct server_session));
+        memset(&Event, 0, sizeof(Event));
+        Event.events = EPOLLIN;
+        Event.data.ptr = Session;
+        if (Session == NULL || epoll_ctl(Server->Epoll, EPOLL_CTL_ADD, fd, &Event) != 0)
+        {
+            free(Session);
+            close(fd);
+            continue;
+        }
+        Session->Fd = fd;
+        Session->Events = EPOLLIN;
+        Session->Next = Server->Sessions;
+        if (Server->Sessions != NULL)
+        {
+            Server->Sessions->Prev = Session;
+        }
+        Server->Sessions = Session;
+        Server->Open++;
+        Server->Stats.Accepted++;
+
+        LOG_PRINTF(LOG_DEBUG, "Session %d connected, %" PRIu64 " open\n", fd, Server->Open);
+    }
+}
+
+/**
+ * @brief 
+ * Takes what a session sent, answers every request that is complete 
+ * and sends the replies. A session that hung up is closed once the 
+ * replies are sent.
+ */
+static GStatus Server_Read(server_t Server, struct server_session *Session)
+{
+    char Buffer[SERVER_READ_SIZE];
+    ssize_t got;
+    ssize_t i;
+
+    got = recv(Session->Fd, Buffer, sizeof(Buffer), 0);
+    if (got < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR))
+    {
+        return GST_SUCCESS;
+    }
+    if (got <= 0)
+    {
+        // Requests that came without a newline before the end are dropped
+        Session->Closing = 1U;
+        return Server_Flush(Server, Session);
+    }
+
+    for (i = 0; i < got && !Session->Closing; i++)
+    {
+        if (Buffer[i] != '\n')
+        {
+            if (Session->InLength < SERVER_LINE_MAX - 1U)
+            {
+                Session->In[Session->InLength++] = Buffer[i];
+            }
+            else
+            {
+                Session->Overlong = 1U;
+            }
+            continue;
+        }
+
+        Session->In[Session->InLength] = '\0';
+        if (Session->Overlong)
+        {
+            Server->Stats.Requests++;
+            Server_Error(Server, Session, "too long");
+        }
+        else
+        {
+            Server_Request(Server, Session, Session->In);
+        }
+        Session->InLength = 0U;
+        Session->Overlong = 0U;
+    }
+
+    return Server_Flush(Server, Session);
+}
+
+/**
+ * @brief Answers one request line.
+ */
+static GStatus Server_Request(server_t Server, struct server_session *Session, char *Line)
+{
+    char *Save = NULL;
+    char *Command = strtok_r(Line, " \t\r", &Save);
+
+    Server->Stats.Requests++;
+    if (Command == NULL)
+    {
+        return Server_Error(Server, Session, "empty");
+    }
+    if (strcmp(Command, "NEW") == 0)
+    {
+        return Server_New(Server, Session, &Save);
+    }
+    if (strcmp(Command, "MOVE") == 0)
+    {
+        return Server_Move(Server, Session, &Save);
+    }
+    if (strcmp(Command, "QUIT") == 0)
+    {
+        Session->Closing = 1U;
+        return Server_Reply(Session, "BYE\n");
+    }
+
+    return Server_Error(Server, Session, "unknown request");
+}
+
+/**
+ * @brief Starts a game for a NEW request, and plays the first move if the server has it.
+ */
+static GStatus Server_New(server_t Server, struct server_session *Session, char **Save)
+{
+    struct rules rules = Server->Rules;
+    char *Name = strtok_r(NULL, " \t\r", Save);
+    char *First = strtok_r(NULL, " \t\r", Save);
+    char *Target = strtok_r(NULL, " \t\r", Save);
+    char *Max = strtok_r(NULL, " \t\r", Save);
+    char *Ending = strtok_r(NULL, " \t\r", Save);
+    uint64_t first;
+    uint64_t target;
+    uint64_t max;
+    uint64_t Advancement = 0U;
+    GStatus Status = GST_SUCCESS;
+    uint8_t Type;
+
+    if (Name == NULL || Actors_Parse(Name, &Type) != GST_SUCCESS || Type == USER)
+    {
+        return Server_Error(Server, Session, "unknown player");
+    }
+    if (First == NULL || Server_Number(First, &first) != GST_SUCCESS || first < TURN_PLAYER1 || first > TURN_PLAYER2)
+    {
+        return Server_Error(Server, Session, "first must be 1 or 2");
+    }
+    if (Target != NULL)
+    {
+        if (Max == NULL || strtok_r(NULL, " \t\r", Save) != NULL ||
+            Server_Number(Target, &target) != GST_SUCCESS || Server_Number(Max, &max) != GST_SUCCESS ||
+            target > SERVER_MAX_TARGET || max > SERVER_MAX_TARGET || Game_InitRules(&rules, target, max) != GST_SUCCESS)
+        {
+            return Server_Error(Server, Session, "bad rules");
+        }
+        rules.Ending = Server->Rules.Ending;
+        if (Ending != NULL && Game_ParseEnding(Ending, &rules.Ending) != GST_SUCCESS)
+        {
+            return Server_Error(Server, Session, "unknown ending");
+        }
+    }
+
+    // Recursive dynamic searches again whatever its table evicted, which
+    // no cap bounds, the table solver plays the same game in bounded time
+    if (Type == DYNAMIC)
+    {
+        Type = DYNAMIC_TABLE;
+    }
+
+    // Every move runs on the event loop, so no game may take long enough to stall the others
+    if ((Type == MCTS && rules.Target > SERVER_MAX_MCTS_TARGET) || Server_Work(Type, &rules) > SERVER_MAX_WORK)
+    {
+        return Server_Error(Server, Session, "game too large for player");
+    }
+
+    // A game that was being played is abandoned
+    Server_Release(Session);
+    Session->Player = Server_Acquire(Server, Type, &rules);
+    if (Session->Player == NULL)
+    {
+        return Server_Error(Server, Session, "player unavailable");
+    }
+
+    memset(&Session->Game, 0, sizeof(Session->Game));
+    Session->Game.Rules = &Session->Player->Rules;
+    Session->Game.Counters = 1U;
+    Session->Game.Live = 1U;
+    Session->Game.Won = GAME_NOT_WON;
+    Session->Game.PlayerTurn = TURN_PLAYER1;
+    Session->ClientTurn = (uint8_t) first;
+    if (first == TURN_PLAYER1)
+    {
+        Session->Game.Player2 = &Session->Player->Actor;
+    }
+    else
+    {
+        Session->Game.Player1 = &Session->Player->Actor;
+        Status = Server_Play(Server, Session, &Advancement);
+    }
+    Server->Stats.Games++;
+
+    return Server_Result(Server, Session, Status, Advancement);
+}
+
+/**
+ * @brief Plays the move of a MOVE request, and the move of the server after it.
+ */
+static GStatus Server_Move(server_t Server, struct server_session *Session, char **Save)
+{
+    char *Text = strtok_r(NULL, " \t\r", Save);
+    uint64_t Move;
+    uint64_t Advancement = 0U;
+    GStatus Status;
+
+    if (Session->Player == NULL)
+    {
+        return Server_Error(Server, Session, "no game");
+    }
+    if (Text == NULL || strtok_r(NULL, " \t\r", Save) != NULL || Server_Number(Text, &Move) != GST_SUCCESS)
+    {
+        return Server_Error(Server, Session, "bad move");
+    }
+
+    Status = Game_AdvanceState(&Session->Game, Move);
+    if (Status == GST_INVALID_STATE)
+    {
+        return Server_Error(Server, Session, "illegal move");
+    }
+    Session->Game.PlayerTurn = (Session->ClientTurn == TURN_PLAYER1) ? TURN_PLAYER2 : TURN_PLAYER1;
+    if (Status == GST_SUCCESS)
+    {
+        Status = Server_Play(Server, Session, &Advancement);
+    }
+
+    return Server_Result(Server, Session, Status, Advancement);
+}
+
+/**
+ * @brief Picks and plays the move of the server in a sessions game.
+ */
+static GStatus Server_Play(server_t Server, struct server_session *Session, uint64_t *Advancement)
+{
+    Actor_t Actor = &Session->Player->Actor;
+
+    Session->Player->LastUsed = ++Server->Clock;
+    if (Actor->Choose(&Session->Game, Actor->ActorBase, Advancement) == GST_INVALID_STATE)
+    {
+        return GST_INVALID_STATE;
+    }
+    Session->Game.PlayerTurn = Session->ClientTurn;
+
+    return Game_AdvanceState(&Session->Game, *Advancement);
+}
+
+/**
+ * @brief 
+ * Replies with the state of the game after a request, and releases 
+ * the player once the game is over. The mover who ends the game wins 
+ * unless the ending is misere.
+ */
+static GStatus Server_Result(server_t Server, struct server_session *Session, GStatus Status, uint64_t Advancement)
+{
+    uint8_t ClientMovedLast = (Advancement == 0U) ? 1U : 0U;
+
+    if (Status == GST_INVALID_STATE)
+    {
+        Server_Release(Session);
+        return Server_Error(Server, Session, "player failed");
+    }
+    if (Status == GST_SUCCESS)
+    {
+        return Server_Reply(Session, "PLAY %" PRIu64 " %" PRIu64 "\n", Advancement, Session->Game.State);
+    }
+
+    Server->Stats.Finished++;
+    Status = Server_Reply(Session, "%s %" PRIu64 " %" PRIu64 "\n",
+        (ClientMovedLast == GAME_MOVER_WINS(Session->Game.Rules)) ? "WIN" : "LOSS", Advancement, Session->Game.State);
+    Server_Release(Session);
+
+    return Status;
+}
+
+/**
+ * @brief Adds a formatted reply to the output of a session, growing it as needed.
+ */
+static GStatus Server_Reply(struct server_session *Session, const char *Format, ...)
+{
+    va_list args;
+    char *grown;
+    size_t capacity;
+    int needed;
+
+    va_start(args, Format);
+    needed = vsnprintf(NULL, 0, Format, args);
+    va_end(args);
+    if (needed < 0)
+    {
+        return GST_FAILURE;
+    }
+
+    if (Session->OutLength + (size_t) needed + 1U > Session->OutCapacity)
+    {
+        capacity = (Session->OutCapacity == 0U) ? 256U : Session->OutCapacity;
+        while (Session->OutLength + (size_t) needed + 1U > capacity)
+        {
+            capacity *= 2U;
+        }
+        grown = realloc(Session->Out, capacity);
+        if (grown == NULL)
+        {
+            return GST_FAILURE;
+        }
+        Session->Out = grown;
+        Session->OutCapacity = capacity;
+    }
+
+    va_start(args, Format);
+    vsnprintf(Session->Out + Session->OutLength, Session->OutCapacity - Session->OutLength, Format, args);
+    va_end(args);
+    Session->OutLength += (size_t) needed;
+
+    return GST_SUCCESS;
+}
+
+/**
+ * @brief Replies with an error, the game of the session is left as it was.
+ */
+static GStatus Server_Error(server_t Server, struct server_session *Session, const char *Reason)
+{
+    Server->Stats.Errors++;
+
+    return Server_Reply(Session, "ERR %s\n", Reason);
+}
+
+/**
+ * @brief 
+ * Sends as much of the output of a session as the socket takes, and 
+ * waits for the events that matter to it next. Closes the session 
+ * when the socket fails, or when it is closing and all was sent.
+ * Returns GST_FAILURE if the session was closed.
+ */
+static GStatus Server_Flush(server_t Server, struct server_session *Session)
+{
+    struct epoll_event Event;
+    ssize_t sent;
+    uint32_t Events;
+
+    while (Session->OutLength > 0U)
+    {
+        sent = send(Session->Fd, Session->Out, Session->OutLength, MSG_NOSIGNAL);
+        if (sent < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        {
+            break;
+        }
+        if (sent <= 0)
+        {
+            Server_Close(Server, Session);
+            return GST_FAILURE;
+        }
+        memmove(Session->Out, Session->Out + sent, Session->OutLength - (size_t) sent);
+        Session->OutLength -= (size_t) sent;
+    }
+
+    if (Session->Closing && Session->OutLength == 0U)
+    {
+        Server_Close(Server, Session);
+        return GST_FAILURE;
+    }
+
+    Events = (Session->OutLength > 0U) ? EPOLLOUT : 0U;
+    if (!Session->Closing && Session->OutLength < SERVER_OUTPUT_MAX)
+    {
+        Events |= EPOLLIN;
+    }
+    if (Events != Session->Events)
+    {
+        memset(&Event, 0, sizeof(Event));
+        Event.events = Events;
+        Event.data.ptr = Session;
+        epoll_ctl(Server->Epoll, EPOLL_CTL_MOD, Session->Fd, &Event);
+        Session->Events = Events;
+    }
+
+    return GST_SUCCESS;
+}
+
+/**
+ * @brief Closes the connection of a session and frees it.
+ */
+static GStatus Server_Close(server_t Server, struct server_session *Session)
+{
+    LOG_PRINTF(LOG_DEBUG, "Session %d closed, %" PRIu64 " open\n", Session->Fd, Server->Open - 1U);
+
+    epoll_ctl(Server->Epoll, EPOLL_CTL_DEL, Session->Fd, NULL);
+    close(Session->Fd);
+    Server_Release(Session);
+
+    if (Session->Prev != NULL)
+    {
+        Session->Prev->Next = Session->Next;
+    }
+    else
+    {
+        Server->Sessions = Session->Next;
+    }
+    if (Session->Next != NULL)
+    {
+        Session->Next->Prev = Session->Prev;
+    }
+    Server->Open--;
+
+    free(Session->Out);
+    free(Session);
+
+    return GST_SUCCESS;
+}
+
+/**
+ * @brief 
+ * Gets the shared player of a type for the rules, creating it if no 
+ * game played it yet. A new player takes a free slot, or else the 
+ * least recently used one no game is playing. NULL if the player 
+ * can't play the rules, or every slot is being played.
+ */
+static struct server_player *Server_Acquire(server_t Server, uint8_t Type, rules_t rules)
+{
+    struct server_player *Player;
+    struct server_player *Victim = NULL;
+    struct actor_config Config = Server->Config;
+    uint32_t i;
+
+    for (i = 0U; i < SERVER_PLAYERS; i++)
+    {
+        Player = &Server->Players[i];
+        if (Player->Used && Player->Type == Type && Player->Rules.Target == rules->Target &&
+            Player->Rules.MaxAdvancement == rules->MaxAdvancement && Player->Rules.Moves == rules->Moves &&
+            Player->Rules.MoveCount == rules->MoveCount && Player->Rules.Ending == rules->Ending)
+        {
+            Player->Sessions++;
+            Player->LastUsed = ++Server->Clock;
+            return Player;
+        }
+
+        if (!Player->Used)
+        {
+            Victim = (Victim == NULL || Victim->Used) ? Player : Victim;
+        }
+        else if (Player->Sessions == 0U && (Victim == NULL || (Victim->Used && Player->LastUsed < Victim->LastUsed)))
+        {
+            Victim = Player;
+        }
+    }
+
+    if (Victim == NULL)
+    {
+        return NULL;
+    }
+    if (Victim->Used)
+    {
+        Actors_Destroy(&Victim->Actor);
+        Victim->Used = 0U;
+    }
+
+    Victim->Rules = *rules;
+    Config.Type = Type;
+    if (Actors_Create(&Victim->Actor, &Config, &Victim->Rules) != GST_SUCCESS || Victim->Actor.Choose == NULL)
+    {
+        Actors_Destroy(&Victim->Actor);
+        return NULL;
+    }
+    LOG_PRINTF(LOG_DEBUG, "Created a %s player for %" PRIu64 " and %" PRIu64 "\n", Actors_Name(Type), rules->Target, rules->MaxAdvancement);
+
+    Victim->Used = 1U;
+    Victim->Type = Type;
+    Victim->Sessions = 1U;
+    Victim->LastUsed = ++Server->Clock;
+
+    return Victim;
+}
+
+/**
+ * @brief Lets go of the player of a sessions game, if it has one.
+ */
+static GStatus Server_Release(struct server_session *Session)
+{
+    if (Session->Player != NULL)
+    {
+        Session->Player->Sessions--;
+        Session->Player = NULL;
+    }
+
+    return GST_SUCCESS;
+}
+
+/**
+ * @brief 
+ * Estimates what solving a game costs a player type, in states times 
+ * the moves tried from each. Table players try every move from every 
+ * state unless Dynamic_SolveRange applies. Bitset players try 64 
+ * states with each word operation. The others need no solve, or run 
+ * to a deadline, and cost the target.
+ */
+static uint64_t Server_Work(uint8_t Type, rules_t rules)
+{
+    uint64_t work = rules->Target * RULES_MOVE_COUNT(rules);
+
+    switch (Type)
+    {
+    case DYNAMIC_TABLE:
+        return (rules->Moves == NULL && rules->Ending != GAME_END_MISERE) ? rules->Target : work;
+    case BITSET:
+        return work / 64U;
+    default:
+        return rules->Target;
+    }
+}
+
+/**
+ * @brief Reads a whole, unsigned decimal number that fits in 64 bits.
+ */
+static GStatus Server_Number(const char *Text, uint64_t *Value)
+{
+    char *End;
+
+    if (Text[0] < '0' || Text[0] > '9')
+    {
+        return GST_FAILURE;
+    }
+    errno = 0;
+    *Value = strtoull(Text, &End, 10);
+
+    return (errno == 0 && *End == '\0') ? GST_SUCCESS : GST_FAILURE;
+}
+
+/**
+ * @brief Stops the server on SIGINT and SIGTERM.
+ */
+static void Server_OnSignal(int Signal)
+{
+    (void) Signal;
+    Server_Stop();
+}
+
+/*** end of file ***/
@@ -0,0 +1,319 @@
+/** @file tournament.c
+ * 
+ * @brief 
+ * Plays round robin matches between player types on every core, 
+ * using a work-stealing thread pool.
+ *
+ * @par       
+ * COPYRIGHT NOTICE: (c) 2021 Graham Power.  All rights reserved.
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */ 
+
+#include "tournament.h"
+
+#include <stdlib.h>
+#include <inttypes.h>
+
+#include "actors.h"
+#include "random.h"
+
+/************************** Constant Definitions *****************************/
+
+/**************************** Type Definitions *******************************/
+
+// Everything one worker owns while the tournament runs. Nothing in
+// here is shared, so no worker ever waits on another.
+struct tournament_worker
+{
+    struct Actor Actors[2][PLAYER_TYPES];   // Created on first use, per seat and type
+    uint8_t Created[2][PLAYER_TYPES];
+    struct batch_result *Results;           // Same layout as the tournament results
+};
+
+struct tournament_chunk
+{
+    tournament_t Tournament;
+    struct tournament_worker *Workers;
+    uint32_t Pairing;
+    uint64_t Index;
+    uint64_t Games;
+    struct task Task;
+};
+
+/************************** Function Prototypes ******************************/
+
+static void Tournament_PlayChunk(threadpool_t pool, uint32_t Worker, void *Arg);
+static Actor_t Tournament_GetActor(tournament_t tournament, struct tournament_worker *worker, uint8_t Seat, uint8_t Type);
+
+/************************** Function Definitions *****************************/
+
+/**
+ * @brief 
+ * Initializes a tournament between every player type that can 
+ * play on its own for the rules (every type but USER, TABLEBASE
+ * which needs a file, and the types Actors_Supports rules out).
+ * MCTS only takes part when the config limits its playouts or 
+ * budget, its default search is far too slow for this many games.
+ * 
+ * @param tournament The tournament to initialize.
+ * @param rules The rules of every game.
+ * @param games The number of games every pairing plays.
+ * @param threads The number of threads to play on, 0 for one per core.
+ * @param config The seed random players are derived from, and the search limits of every player.
+ * @return GStatus GST_FAILURE if the results could not be allocated, GST_SUCCESS otherwise.
+ */
+GStatus Tournament_Init(tournament_t tournament, rules_t rules, uint64_t games, uint32_t threads, const struct actor_config *config)
+{
+    uint32_t i;
+    uint8_t Type;
+
+    tournament->Rules = *rules;
+    tournament->Games = games;
+    tournament->Seed = config->Seed;
+    tournament->Iterations = config->Iterations;
+    tournament->Budget = config->Budget;
+    tournament->Threads = (threads == 0U) ? ThreadPool_Cores() : threads;
+    tournament->TypeCount = 0U;
+    for (Type = 0U; Type < PLAYER_TYPES; Type++)
+    {
+        if (Type == MCTS && config->Iterations == 0U && config->Budget == 0U)
+        {
+            continue;
+        }
+        if (Type != USER && Type != TABLEBASE && Actors_Supports(Type, rules) == GST_SUCCESS)
+        {
+            tournament->Types[tournament->TypeCount++] = Type;
+        }
+    }
+
+    tournament->Results = calloc(tournament->TypeCount * tournament->TypeCount, sizeof(struct batch_result));
+    if (tournament->Results == NULL)
+    {
+        return GST_FAILURE;
+    }
+    for (i = 0U; i < tournament->TypeCount * tournament->TypeCount; i++)
+    {
+        if (Batch_InitResult(&tournament->Results[i], &tournament->Rules) != GST_SUCCESS)
+        {
+            Tournament_Free(tournament);
+            return GST_FAILURE;
+        }
+    }
+
+    return GST_SUCCESS;
+};
+
+/**
+ * @brief Releases the results allocated by Tournament_Init.
+ * 
+ * @param tournament The tournament to release.
+ * @return GStatus The success of the release.
+ */
+GStatus Tournament_Free(tournament_t tournament)
+{
+    uint32_t i;
+
+    if (tournament->Results != NULL)
+    {
+        for (i = 0U; i < tournament->TypeCount * tournament->TypeCount; i++)
+        {
+            Batch_FreeResult(&tournament->Results[i]);
+        }
+    }
+    free(tournament->Results);
+    tournament->Results = NULL;
+
+    return GST_SUCCESS;
+};
+
+/**
+ * @brief 
+ * Plays every pairing, split in chunks of TOURNAMENT_CHUNK_GAMES 
+ * games, on a work-stealing pool. Each worker creates its own 
+ * players and counts into its own results, which are merged into 
+ * the tournament results once every worker has stopped. Random 
+ * players are reseeded per chunk, so the results don't depend on 
+ * which worker played which chunk.
+ * 
+ * @param tournament The tournament to play.
+ * @return GStatus The success of the tournament.
+ */
+GStatus Tournament_Run(tournament_t tournament)
+{
+    struct threadpool pool;
+    struct tournament_worker *workers;
+    struct tournament_chunk *chunks;
+    uint32_t Pairings = tournament->TypeCount * tournament->TypeCount;
+    uint64_t PerPairing = (tournament->Games + TOURNAMENT_CHUNK_GAMES - 1U) / TOURNAMENT_CHUNK_GAMES;
+    uint64_t Count = Pairings * PerPairing;
+    uint64_t c;
+    uint32_t w;
+    uint32_t p;
+    uint8_t seat;
+    uint8_t Type;
+    GStatus Status = GST_SUCCESS;
+
+    workers = calloc(tournament->Threads, sizeof(struct tournament_worker));
+    chunks = calloc(Count, sizeof(struct tournament_chunk));
+    if (workers == NULL || chunks == NULL ||
+        ThreadPool_Init(&pool, tournament->Threads, Count / tournament->Threads + 1U) != GST_SUCCESS)
+    {
+        free(workers);
+        free(chunks);
+        return GST_FAILURE;
+    }
+
+    for (w = 0U; w < tournament->Threads && Status == GST_SUCCESS; w++)
+    {
+        workers[w].Results = calloc(Pairings, sizeof(struct batch_result));
+        Status = (workers[w].Results == NULL) ? GST_FAILURE : GST_SUCCESS;
+        for (p = 0U; p < Pairings && Status == GST_SUCCESS; p++)
+        {
+            Status = Batch_InitResult(&workers[w].Results[p], &tournament->Rules);
+        }
+    }
+
+    for (c = 0U; c < Count && Status == GST_SUCCESS; c++)
+    {
+        chunks[c].Tournament = tournament;
+        chunks[c].Workers = workers;
+        chunks[c].Pairing = (uint32_t) (c / PerPairing);
+        chunks[c].Index = c % PerPairing;
+        chunks[c].Games = tournament->Games - chunks[c].Index * TOURNAMENT_CHUNK_GAMES;
+        if (chunks[c].Games > TOURNAMENT_CHUNK_GAMES)
+        {
+            chunks[c].Games = TOURNAMENT_CHUNK_GAMES;
+        }
+        chunks[c].Task.Run = Tournament_PlayChunk;
+        chunks[c].Task.Arg = &chunks[c];
+        Status = ThreadPool_Submit(&pool, &chunks[c].Task);
+    }
+
+    if (Status == GST_SUCCESS)
+    {
+        Status = ThreadPool_Run(&pool);
+    }
+
+    // Every worker has been joined, merge without any locking
+    for (w = 0U; w < tournament->Threads; w++)
+    {
+        for (p = 0U; p < Pairings && workers[w].Results != NULL; p++)
+        {
+            if (workers[w].Results[p].MoveCounts != NULL)
+            {
+                Batch_Merge(&tournament->Results[p], &workers[w].Results[p]);
+            }
+            Batch_FreeResult(&workers[w].Results[p]);
+        }
+        free(workers[w].Results);
+
+        for (seat = 0U; seat < 2U; seat++)
+        {
+            for (Type = 0U; Type < PLAYER_TYPES; Type++)
+            {
+                if (workers[w].Created[seat][Type])
+                {
+                    Actors_Destroy(&workers[w].Actors[seat][Type]);
+                }
+            }
+        }
+    }
+
+    ThreadPool_Free(&pool);
+    free(workers);
+    free(chunks);
+
+    return Status;
+};
+
+/**
+ * @brief Prints the results of every pairing.
+ * 
+ * @param tournament The tournament to print.
+ * @return GStatus The success of the print.
+ */
+GStatus Tournament_PrintResult(tournament_t tournament)
+{
+    uint32_t i;
+    uint32_t j;
+    struct batch_result *result;
+
+    printf("%-10s %-10s %12s %12s %8s %10s\n", "Player 1", "Player 2", "P1 Wins", "P2 Wins", "Errors", "Avg Moves");
+    for (i = 0U; i < tournament->TypeCount; i++)
+    {
+        for (j = 0U; j < tournament->TypeCount; j++)
+        {
+            result = &tournament->Results[i * tournament->TypeCount + j];
+            printf("%-10s %-10s %12" PRIu64 " %12" PRIu64 " %8" PRIu64 " %10.3f\n",
+                Actors_Name(tournament->Types[i]), Actors_Name(tournament->Types[j]),
+                result->Wins[0], result->Wins[1], result->Errors,
+                (result->Games == 0U) ? 0.0 : (double) result->TotalMoves / (double) result->Games);
+        }
+    }
+
+    return GST_SUCCESS;
+};
+
+/**
+ * @brief Plays one chunk of games of one pairing, on the worker that runs it.
+ */
+static void Tournament_PlayChunk(threadpool_t pool, uint32_t Worker, void *Arg)
+{
+    struct tournament_chunk *chunk = (struct tournament_chunk *) Arg;
+    tournament_t tournament = chunk->Tournament;
+    struct tournament_worker *worker = &chunk->Workers[Worker];
+    uint32_t i = chunk->Pairing / tournament->TypeCount;
+    uint32_t j = chunk->Pairing % tournament->TypeCount;
+    uint64_t seed = Random_Seed(tournament->Seed, ((uint64_t) chunk->Pairing << 40) + chunk->Index);
+    Actor_t player1 = Tournament_GetActor(tournament, worker, 0U, tournament->Types[i]);
+    Actor_t player2 = Tournament_GetActor(tournament, worker, 1U, tournament->Types[j]);
+
+    (void) pool;
+
+    if (player1 == NULL || player2 == NULL)
+    {
+        worker->Results[chunk->Pairing].Errors += chunk->Games;
+        return;
+    }
+
+    // Every chunk and seat gets its own stream, so the two players never share one
+    Actors_Reseed(player1, Random_Seed(seed, 0U));
+    Actors_Reseed(player2, Random_Seed(seed, 1U));
+    Batch_Play(&tournament->Rules, player1, player2, chunk->Games, &worker->Results[chunk->Pairing]);
+}
+
+/**
+ * @brief Gets the worker's player of a type for a seat, creating it the first time.
+ */
+static Actor_t Tournament_GetActor(tournament_t tournament, struct tournament_worker *worker, uint8_t Seat, uint8_t Type)
+{
+    // Games are already spread over the threads, so each player searches on one
+    struct actor_config config = {
+        .Type = Type, .Seed = tournament->Seed, .Threads = 1U,
+        .Iterations = tournament->Iterations, .Budget = tournament->Budget,
+    };
+
+    if (!worker->Created[Seat][Type])
+    {
+        if (Actors_Create(&worker->Actors[Seat][Type], &config, &tournament->Rules) != GST_SUCCESS)
+        {
+            return NULL;
+        }
+        worker->Created[Seat][Type] = 1U;
+    }
+
+    return &worker->Actors[Seat][Type];
+}
+
+/*** end of file ***/
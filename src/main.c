@@ -21,65 +21,532 @@
 /***************************** Include Files *********************************/
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
 
 #include "status.h"
 
 #include "game.h"
+#include "actors.h"
 #include "player.h"
+#include "batch.h"
+#include "gamebatch.h"
+#include "tournament.h"
+#include "server.h"
+#include "closedform.h"
+#include "tablebase.h"
 #include "dynamic.h"
+#include "bitset.h"
+#include "grundy.h"
+#include "alphabeta.h"
+#include "query.h"
 
 /************************** Constant Definitions *****************************/
 
+#define TOURNAMENT_DEFAULT_GAMES	100000U
+
 /**************************** Type Definitions *******************************/
 
-#if PLAYER1 == DYNAMIC
-	struct Dynamic player1_d_s;
-	dynamic_t player1_d = &player1_d_s;
-	struct hashtable player1_ht_s;
-	hashtable_t player1_ht = &player1_ht_s;
-	struct Actor player1_s;
-	Actor_t player1 = &player1_s;
-#else // Default to Player1 being a user
-	struct Actor player1_s;
-	Actor_t player1 = &player1_s;
-#endif
-
-#if PLAYER2 == DYNAMIC
-	struct Dynamic player2_d_s;
-	dynamic_t player2_d = &player2_d_s;
-	struct hashtable player2_ht_s;
-	hashtable_t player2_ht = &player2_ht_s;
-	struct Actor player2_s;
-	Actor_t player2 = &player2_s;
-#else // Default to Player2 being a user
-	struct Actor player2_s;
-	Actor_t player2 = &player2_s;
-#endif
+struct actor_config player1_c = { .Type = PLAYER1, .Seed = 1U };
+struct actor_config player2_c = { .Type = PLAYER2, .Seed = 2U };
+
+struct Actor player1_s;
+Actor_t player1 = &player1_s;
+
+struct Actor player2_s;
+Actor_t player2 = &player2_s;
+
+struct rules rules_s;
+rules_t rules = &rules_s;
 
 struct game game_s;
 game_t game = &game_s;
 
+struct tournament tournament_s;
+tournament_t tournament = &tournament_s;
+
 /************************** Function Prototypes ******************************/
 
 /************************** Function Definitions *****************************/
 
-int main()
+static int CompareMoves(const void *a, const void *b)
+{
+	uint64_t x = *(const uint64_t *) a;
+	uint64_t y = *(const uint64_t *) b;
+
+	return (x > y) - (x < y);
+}
+
+/**
+ * @brief 
+ * Parses a comma separated list of moves, like 1,3,7, into an 
+ * ascending array without repeats. The array is allocated here.
+ */
+static GStatus ParseMoves(const char *list, uint64_t **moves, uint64_t *count)
+{
+	const char *c;
+	char *end;
+	uint64_t n = 1U;
+	uint64_t i;
+
+	for (c = list; *c != '\0'; c++)
+	{
+		n += (*c == ',');
+	}
+	*moves = malloc(n*sizeof(uint64_t));
+	if (*moves == NULL)
+	{
+		return GST_FAILURE;
+	}
+
+	for (i = 0U, c = list; i < n; i++, c = end + 1)
+	{
+		(*moves)[i] = strtoull(c, &end, 10);
+		if (end == c || (*end != ',' && *end != '\0') || (*moves)[i] == 0U)
+		{
+			free(*moves);
+			*moves = NULL;
+			return GST_FAILURE;
+		}
+	}
+
+	qsort(*moves, n, sizeof(uint64_t), CompareMoves);
+	for (*count = 0U, i = 0U; i < n; i++)
+	{
+		if (*count == 0U || (*moves)[*count - 1U] != (*moves)[i])
+		{
+			(*moves)[(*count)++] = (*moves)[i];
+		}
+	}
+
+	return GST_SUCCESS;
+}
+
+static void PrintSearchStats(const char *label, Actor_t player)
+{
+	struct dynamic_stats stats;
+
+	if (player->Type == DYNAMIC || player->Type == DYNAMIC_TABLE)
+	{
+		Dynamic_GetGameStats((dynamic_t) player->ActorBase, &stats);
+		Dynamic_PrintStats(label, &stats);
+	}
+	else if (player->Type == ALPHABETA)
+	{
+		Dynamic_PrintStats(label, &((alphabeta_t) player->ActorBase)->GameStats);
+	}
+}
+
+/**
+ * @brief 
+ * Formats the search trace of every thread, to the passed in file or 
+ * to stdout if there is none. Does nothing below the trace log level.
+ */
+static void DumpTrace(const char *path)
+{
+	FILE *out = stdout;
+
+	if (!LOG_ENABLED(LOG_TRACE))
+	{
+		return;
+	}
+	if (path != NULL && (out = fopen(path, "w")) == NULL)
+	{
+		printf("Could not open the trace file %s\n", path);
+		return;
+	}
+	Trace_Dump(out);
+	if (out != stdout)
+	{
+		fclose(out);
+	}
+	Trace_Free();
+}
+
+/**
+ * @brief Whether a player type looks at every counter of a game.
+ */
+static int PlaysCounters(uint8_t Type)
+{
+	return Type == USER || Type == GRUNDY || Type == TABLEBASE || Type == ALPHABETA || Type == MCTS;
+}
+
+/**
+ * @brief Whether a player, if it is a tablebase, was solved for games on this many counters.
+ */
+static int TablebaseCovers(Actor_t Actor, uint32_t counters)
+{
+	const struct tablebase_header *header;
+
+	if (Actor->Type != TABLEBASE)
+	{
+		return 1;
+	}
+	header = ((tablebase_t) Actor->ActorBase)->Header;
+
+	return (counters > 1U) ? (header->Kind == TABLEBASE_KIND_COUNTERS && header->Counters == counters) : (header->Kind == TABLEBASE_KIND_MOVES);
+}
+
+static void Usage(const char *name)
 {
-	#if PLAYER1 == DYNAMIC
-	Dynamic_Init(player1, player1_d, player2_ht);
-	#else
-	Player_Init(player1);
-	#endif
+	printf("Usage: %s [-n target] [-k max advancement] [-m moves] [-c counters] [-e ending] [-1 player] [-2 player] [-s seed] [-d micros] [-i playouts] [-b games] [-t threads] [-v] [-w file] [-f file] [-l level] [-T file] [-p] [-S address]\n", name);
+	printf("  -n  The score that has to be said to win (default %u)\n", MAX_STATE);
+	printf("  -k  The most a player can add on their turn (default %u)\n", MAX_STATE_ADVANCEMENT);
+	printf("  -m  Instead of 1 to -k, the moves players can make, like 1,3,7\n");
+	printf("  -c  Play on this many counters at once, every turn advances one of\n");
+	printf("      them (default 1). Only user, grundy, tablebase, alphabeta and mcts\n");
+	printf("      players can play on more than one\n");
+	printf("  -e  How the game ends, any of normal (the player who can't move loses),\n");
+	printf("      misere (the player who can't move wins) or first (saying the target on\n");
+	printf("      any counter wins) (default normal)\n");
+	printf("  -1  The type of player 1 (default %s)\n", Actors_Name(PLAYER1));
+	printf("  -2  The type of player 2 (default %s)\n", Actors_Name(PLAYER2));
+	printf("      Any of user, dynamic, table, closed, random, tablebase, compiled,\n");
+	printf("      bitset, grundy, alphabeta, mcts\n");
+	printf("  -s  The seed of random players (default 1 for player 1, 2 for player 2)\n");
+	printf("  -d  The microseconds alphabeta and mcts players may search every move\n");
+	printf("      for (default %u for alphabeta, none for mcts)\n", ALPHABETA_BUDGET_US);
+	printf("  -i  The playouts mcts players run for every move (default %u, unless -d\n", MCTS_ITERATIONS);
+	printf("      is given)\n");
+	printf("  -b  Instead of playing one game, play this many without output and\n");
+	printf("      print the results\n");
+	printf("  -t  Instead of playing one game, play a round robin tournament between\n");
+	printf("      every player type but user and tablebase on this many threads\n");
+	printf("      (0 for every core). mcts only plays when -i or -d is given.\n");
+	printf("      Every pairing plays -b games (default %u)\n", TOURNAMENT_DEFAULT_GAMES);
+	printf("  -v  Instead of playing, check the closed form, bitset and dynamic players\n");
+	printf("      and batch queries against the Dynamic table, batch stepped games\n");
+	printf("      against single games, and inlined batch games against the players\n");
+	printf("      own moves, for every target up to -n and max advancement\n");
+	printf("      up to -k, and the grundy, alphabeta and counters tablebase players\n");
+	printf("      against a search over small games on many counters, and scripted\n");
+	printf("      input to the user player fed in pieces against the script\n");
+	printf("  -p  Instead of playing, print where the won and lost positions of the\n");
+	printf("      moves become periodic\n");
+	printf("  -w  Instead of playing, solve the game for -n and -k and write the\n");
+	printf("      tablebase to this file. With -c, every combination of the counters\n");
+	printf("      is solved on -t threads\n");
+	printf("  -f  The tablebase file tablebase players map (written with -w)\n");
+	printf("  -l  The log level, any of quiet, info, debug, trace (default %s)\n", (LOG_DEFAULT_LEVEL == LOG_QUIET) ? "quiet" :
+		(LOG_DEFAULT_LEVEL == LOG_INFO) ? "info" : (LOG_DEFAULT_LEVEL == LOG_DEBUG) ? "debug" : "trace");
+	printf("  -T  The file the search trace is written to at the trace level (default stdout)\n");
+	printf("  -S  Instead of playing, serve games to clients on unix:PATH or on\n");
+	printf("      tcp:PORT on localhost until interrupted. Games that don't name\n");
+	printf("      their rules are played with -n, -k, -m and -e, and server players\n");
+	printf("      are made with -s, -d, -i and -f. See server.c for the protocol\n");
+}
+
+int main(int argc, char *argv[])
+{
+	uint64_t target = MAX_STATE;
+	uint64_t maxAdvancement = MAX_STATE_ADVANCEMENT;
+	uint64_t mismatches;
+	uint64_t games = 0U;
+	struct batch_result result;
+	GStatus status;
+	const char *writePath = NULL;
+	const char *tracePath = NULL;
+	const char *serveAddress = NULL;
+	struct server server_s;
+	uint8_t level;
+	struct Bitset bitset;
+	uint64_t *moveSet = NULL;
+	uint64_t *counterStates;
+	uint32_t counters = 1U;
+	uint8_t ending = GAME_END_NORMAL;
+	uint64_t moveCount = 0U;
+	uint64_t *moves;
+	uint64_t i;
+	int period = 0;
+	int verify = 0;
+	int threads = -1;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "n:k:m:c:e:1:2:s:d:i:b:t:vpw:f:l:T:S:h")) != -1)
+	{
+		switch (opt)
+		{
+		case 'n':
+			target = strtoull(optarg, NULL, 10);
+			break;
+		case 'k':
+			maxAdvancement = strtoull(optarg, NULL, 10);
+			break;
+		case 'm':
+			free(moveSet);
+			if (ParseMoves(optarg, &moveSet, &moveCount) != GST_SUCCESS)
+			{
+				Usage(argv[0]);
+				return (1);
+			}
+			break;
+		case 'c':
+			counters = (uint32_t) strtoul(optarg, NULL, 10);
+			break;
+		case 'e':
+			if (Game_ParseEnding(optarg, &ending) != GST_SUCCESS)
+			{
+				Usage(argv[0]);
+				return (1);
+			}
+			break;
+		case '1':
+			if (Actors_Parse(optarg, &player1_c.Type) != GST_SUCCESS)
+			{
+				Usage(argv[0]);
+				return (1);
+			}
+			break;
+		case '2':
+			if (Actors_Parse(optarg, &player2_c.Type) != GST_SUCCESS)
+			{
+				Usage(argv[0]);
+				return (1);
+			}
+			break;
+		case 's':
+			player1_c.Seed = strtoull(optarg, NULL, 10);
+			player2_c.Seed = player1_c.Seed + 1U;
+			break;
+		case 'd':
+			player1_c.Budget = strtoull(optarg, NULL, 10);
+			player2_c.Budget = player1_c.Budget;
+			break;
+		case 'i':
+			player1_c.Iterations = strtoull(optarg, NULL, 10);
+			player2_c.Iterations = player1_c.Iterations;
+			break;
+		case 'b':
+			games = strtoull(optarg, NULL, 10);
+			break;
+		case 't':
+			threads = atoi(optarg);
+			break;
+		case 'v':
+			verify = 1;
+			break;
+		case 'p':
+			period = 1;
+			break;
+		case 'w':
+			writePath = optarg;
+			break;
+		case 'f':
+			player1_c.Path = optarg;
+			player2_c.Path = optarg;
+			break;
+		case 'l':
+			if (Log_Parse(optarg, &level) != GST_SUCCESS || Log_SetLevel(level) != GST_SUCCESS)
+			{
+				Usage(argv[0]);
+				return (1);
+			}
+			break;
+		case 'T':
+			tracePath = optarg;
+			break;
+		case 'S':
+			serveAddress = optarg;
+			break;
+		default:
+			Usage(argv[0]);
+			return (opt == 'h') ? 0 : 1;
+		}
+	}
+
+	status = (moveSet != NULL) ? Game_InitMoveSet(rules, target, moveSet, moveCount) : Game_InitRules(rules, target, maxAdvancement);
+	if (status != GST_SUCCESS || counters == 0U)
+	{
+		Usage(argv[0]);
+		return (1);
+	}
+	rules->Ending = ending;
+
+	if (counters > 1U && writePath != NULL)
+	{
+		if (Tablebase_WriteCounters(writePath, rules, counters, (threads > 0) ? (uint32_t) threads : 0U) != GST_SUCCESS)
+		{
+			printf("Could not write the tablebase to %s\n", writePath);
+			return (1);
+		}
+		return (0);
+	}
+	if (counters > 1U && (games > 0U || threads >= 0 || serveAddress != NULL))
+	{
+		printf("Batches, tournaments and served games are played on one counter\n");
+		return (1);
+	}
+
+	if (verify)
+	{
+		status = ClosedForm_Verify(target, maxAdvancement, &mismatches);
+		if (Dynamic_Verify(target, maxAdvancement, &mismatches) != GST_SUCCESS)
+		{
+			status = GST_FAILURE;
+		}
+		if (Query_Verify(target, maxAdvancement, &mismatches) != GST_SUCCESS)
+		{
+			status = GST_FAILURE;
+		}
+		if (GameBatch_Verify(target, maxAdvancement, &mismatches) != GST_SUCCESS)
+		{
+			status = GST_FAILURE;
+		}
+		if (Batch_Verify(target, maxAdvancement, &mismatches) != GST_SUCCESS)
+		{
+			status = GST_FAILURE;
+		}
+		if (Player_Verify(target, maxAdvancement, &mismatches) != GST_SUCCESS)
+		{
+			status = GST_FAILURE;
+		}
+		if (Bitset_Verify(target, maxAdvancement, &mismatches) != GST_SUCCESS)
+		{
+			status = GST_FAILURE;
+		}
+		if (Grundy_Verify(target, maxAdvancement, &mismatches) != GST_SUCCESS)
+		{
+			status = GST_FAILURE;
+		}
+		if (Tablebase_Verify(target, maxAdvancement, &mismatches) != GST_SUCCESS)
+		{
+			status = GST_FAILURE;
+		}
+		if (AlphaBeta_Verify(target, maxAdvancement, &mismatches) != GST_SUCCESS)
+		{
+			status = GST_FAILURE;
+		}
+		return (status == GST_SUCCESS) ? 0 : 1;
+	}
 
-	#if PLAYER2 == DYNAMIC
-	Dynamic_Init(player2, player2_d, player2_ht);
-	#else
-	Player_Init(player2);
-	#endif
+	if (period)
+	{
+		moves = malloc(RULES_MOVE_COUNT(rules)*sizeof(uint64_t));
+		for (i = 0U; moves != NULL && i < RULES_MOVE_COUNT(rules); i++)
+		{
+			moves[i] = RULES_MOVE(rules, i);
+		}
+		if (moves == NULL || Bitset_SolvePeriodic(&bitset, moves, (uint32_t) RULES_MOVE_COUNT(rules), UINT64_MAX/2U, BITSET_KERNEL_AUTO) != GST_SUCCESS)
+		{
+			free(moves);
+			return (1);
+		}
+		printf("%" PRIu64 " moves up to %" PRIu64 ": pre-period %" PRIu64 ", period %" PRIu64 " (%" PRIu64 " positions solved)\n",
+			RULES_MOVE_COUNT(rules), rules->MaxAdvancement, bitset.PrePeriod, bitset.Period, bitset.Positions);
+		Bitset_Free(&bitset);
+		free(moves);
+		return (0);
+	}
 
-	Game_Init(game, player1, player2);
+	if (writePath != NULL)
+	{
+		if (Tablebase_Write(writePath, rules) != GST_SUCCESS)
+		{
+			printf("Could not write the tablebase to %s\n", writePath);
+			return (1);
+		}
+		return (0);
+	}
+
+	if (serveAddress != NULL)
+	{
+		if (Server_Init(&server_s, serveAddress, rules, &player2_c) != GST_SUCCESS)
+		{
+			printf("Could not serve on %s\n", serveAddress);
+			return (1);
+		}
+		printf("Serving on %s\n", serveAddress);
+		fflush(stdout);
+		status = Server_Run(&server_s);
+		Server_PrintStats(&server_s);
+		Server_Free(&server_s);
+
+		return (status == GST_SUCCESS) ? 0 : 1;
+	}
+
+	if (threads >= 0)
+	{
+		if (Tournament_Init(tournament, rules, (games > 0U) ? games : TOURNAMENT_DEFAULT_GAMES, (uint32_t) threads, &player1_c) != GST_SUCCESS)
+		{
+			return (1);
+		}
+		status = Tournament_Run(tournament);
+		Tournament_PrintResult(tournament);
+		Tournament_Free(tournament);
+		DumpTrace(tracePath);
+
+		return (status == GST_SUCCESS) ? 0 : 1;
+	}
+
+	if (games > 0U)
+	{
+		if (Batch_InitResult(&result, rules) != GST_SUCCESS)
+		{
+			return (1);
+		}
+		status = Batch_Run(rules, &player1_c, &player2_c, games, &result);
+		if (status == GST_SUCCESS)
+		{
+			Batch_PrintResult(&result);
+		}
+		else
+		{
+			printf("Batch games need two players who can play on their own, for the rules played\n");
+		}
+		Batch_FreeResult(&result);
+		DumpTrace(tracePath);
+
+		return (status == GST_SUCCESS) ? 0 : 1;
+	}
+
+	if (counters > 1U)
+	{
+		// Every other player only ever looks at one counter
+		if (!PlaysCounters(player1_c.Type) || !PlaysCounters(player2_c.Type))
+		{
+			printf("Only user, grundy, tablebase, alphabeta and mcts players can play on more than one counter\n");
+			return (1);
+		}
+		counterStates = malloc(counters*sizeof(uint64_t));
+		if (counterStates == NULL)
+		{
+			return (1);
+		}
+	}
+
+	if (Actors_Create(player1, &player1_c, rules) != GST_SUCCESS ||
+		Actors_Create(player2, &player2_c, rules) != GST_SUCCESS)
+	{
+		printf("Could not create the players\n");
+		return (1);
+	}
+
+	if (!TablebaseCovers(player1, counters) || !TablebaseCovers(player2, counters))
+	{
+		printf("The tablebase was solved for a different number of counters\n");
+		return (1);
+	}
+
+	if (counters > 1U)
+	{
+		Game_InitCounters(game, rules, counterStates, counters, player1, player2);
+	}
+	else
+	{
+		Game_Init(game, rules, player1, player2);
+	}
 
 	Game_Spin(game);
 
+	if (LOG_ENABLED(LOG_DEBUG))
+	{
+		PrintSearchStats("Player 1 search", player1);
+		PrintSearchStats("Player 2 search", player2);
+	}
+	DumpTrace(tracePath);
+
+	Actors_Destroy(player1);
+	Actors_Destroy(player2);
+
 	return (0);
 }
\ No newline at end of file
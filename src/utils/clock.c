@@ -1,8 +1,8 @@
-/** @file hashtable.c
+/** @file clock.c
  * 
  * @brief 
- * A hashtable to store the results of AI actions. So trees don't
- * have to be explored more than once
+ * Reads the monotonic clock, for the searches that time their moves
+ * or run to a deadline.
  *
  * @par       
  * COPYRIGHT NOTICE: (c) 2021 Graham Power.  All rights reserved.
@@ -20,7 +20,9 @@
  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */ 
 
-#include "hashtable.h"
+#include "clock.h"
+
+#include <time.h>
 
 /************************** Constant Definitions *****************************/
 
@@ -30,45 +32,17 @@
 
 /************************** Function Definitions *****************************/
 
-GStatus Hashtable_Init(hashtable_t table)
-{
-    unsigned int i;
-    for (i = 0U; i < HASH_MAX_CAPACITY; i++)
-    {
-        table->hash_used[i] = 0U;
-    }
-
-    return GST_SUCCESS;
-};
-
-GStatus Hashtable_Put(hashtable_t table, uint8_t Score, uint8_t MyTurn, float Reward)
-{
-    unsigned long hash = (1U + MyTurn)*Score;
-    if (hash >= HASH_MAX_CAPACITY)
-    {
-        return GST_FAILURE;
-    }
-
-    table->hash_map[hash] = Reward;
-
-    return GST_SUCCESS;
-};
-
-GStatus Hashtable_Get(hashtable_t table, uint8_t Score, uint8_t MyTurn, float *Reward)
+/**
+ * @brief Reads the monotonic clock in nanoseconds.
+ * 
+ * @return uint64_t The nanoseconds since an arbitrary point, which never goes backwards.
+ */
+uint64_t Clock_Nanoseconds(void)
 {
-    unsigned long hash = (1U + MyTurn)*Score;
-    if (hash >= HASH_MAX_CAPACITY)
-    {
-        return GST_FAILURE;
-    }
-    if (table->hash_used[hash] == 0U)
-    {
-        return GST_FAILURE;
-    }
-
-    *Reward = table->hash_map[hash];
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
 
-    return GST_SUCCESS;
+    return (uint64_t) ts.tv_sec * UINT64_C(1000000000) + (uint64_t) ts.tv_nsec;
 };
 
-/*** end of file ***/
\ No newline at end of file
+/*** end of file ***/
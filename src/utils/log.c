@@ -0,0 +1,275 @@
+/** @file log.c
+ * 
+ * @brief 
+ * Runtime log levels, and a trace sink for the solvers. Trace records
+ * are written in binary to a ring buffer owned by the writing thread,
+ * and only formatted as text when they are dumped.
+ *
+ * @par       
+ * COPYRIGHT NOTICE: (c) 2021 Graham Power.  All rights reserved.
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */ 
+
+#include "log.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+/************************** Constant Definitions *****************************/
+
+/**************************** Type Definitions *******************************/
+
+// The trace records of one thread. Written counts every record ever
+// written, the ring holds the last Mask + 1 of them.
+struct trace_ring
+{
+    struct trace_record *Records;
+    uint64_t Written;
+    uint64_t Mask;
+    uint32_t Thread;            // The order threads first traced in
+    struct trace_ring *Next;
+};
+
+// Only set before games start, so threads can read it without locking.
+uint8_t Log_Level = LOG_DEFAULT_LEVEL;
+
+static const char *const LogNames[] = {
+    [LOG_QUIET] = "quiet",
+    [LOG_INFO]  = "info",
+    [LOG_DEBUG] = "debug",
+    [LOG_TRACE] = "trace",
+};
+
+static _Thread_local struct trace_ring *LocalRing = NULL;
+static struct trace_ring *Rings = NULL;
+static uint32_t RingCount = 0U;
+static pthread_mutex_t RingsLock = PTHREAD_MUTEX_INITIALIZER;
+
+/************************** Function Prototypes ******************************/
+
+static struct trace_ring *Trace_NewRing(void);
+static void Trace_Format(FILE *Out, const struct trace_record *Record);
+
+/************************** Function Definitions *****************************/
+
+/**
+ * @brief 
+ * Sets the log level. Levels above LOG_MAX_LEVEL are compiled out, 
+ * so they are capped to it.
+ * 
+ * @param Level Any of the LOG_ levels in log.h.
+ * @return GStatus GST_FAILURE if the level is unknown, GST_SUCCESS otherwise.
+ */
+GStatus Log_SetLevel(uint8_t Level)
+{
+    if (Level > LOG_TRACE)
+    {
+        return GST_FAILURE;
+    }
+    Log_Level = (Level > LOG_MAX_LEVEL) ? LOG_MAX_LEVEL : Level;
+
+    return GST_SUCCESS;
+};
+
+/**
+ * @brief Finds the log level with the passed in name, or number.
+ * 
+ * @param Name Any of quiet, info, debug and trace, or 0 to 3.
+ * @param Level Pointer to a uint. Log_Parse stores the level here.
+ * @return GStatus GST_SUCCESS if the name is known, GST_FAILURE otherwise.
+ */
+GStatus Log_Parse(const char *Name, uint8_t *Level)
+{
+    uint8_t i;
+    for (i = 0U; i <= LOG_TRACE; i++)
+    {
+        if (strcmp(Name, LogNames[i]) == 0 || (Name[0] == (char) ('0' + i) && Name[1] == '\0'))
+        {
+            *Level = i;
+            return GST_SUCCESS;
+        }
+    }
+
+    return GST_FAILURE;
+};
+
+/**
+ * @brief 
+ * Copies a record into the ring of the calling thread. The ring is 
+ * allocated the first time a thread traces. Records are dropped if 
+ * it can't be.
+ * 
+ * @param Record The record to write.
+ */
+void Trace_Write(const struct trace_record *Record)
+{
+    struct trace_ring *ring = LocalRing;
+
+    if (ring == NULL)
+    {
+        ring = Trace_NewRing();
+        if (ring == NULL)
+        {
+            return;
+        }
+    }
+    ring->Records[ring->Written & ring->Mask] = *Record;
+    ring->Written++;
+}
+
+/**
+ * @brief 
+ * Formats every record still held by every thread as text, oldest 
+ * first, and empties the rings. Threads must not trace while their 
+ * ring is dumped, so it is meant to be called between games, or once 
+ * the threads playing them have been joined.
+ * 
+ * @param Out The file to write the text to.
+ * @return GStatus The success of the dump.
+ */
+GStatus Trace_Dump(FILE *Out)
+{
+    struct trace_ring *ring;
+    uint64_t first;
+    uint64_t i;
+
+    pthread_mutex_lock(&RingsLock);
+    for (ring = Rings; ring != NULL; ring = ring->Next)
+    {
+        if (ring->Written == 0U)
+        {
+            continue;
+        }
+        first = (ring->Written > ring->Mask + 1U) ? ring->Written - (ring->Mask + 1U) : 0U;
+        if (RingCount > 1U || first > 0U)
+        {
+            fprintf(Out, "==== Trace of thread %" PRIu32 ", %" PRIu64 " oldest records dropped ====\n", ring->Thread, first);
+        }
+        for (i = first; i < ring->Written; i++)
+        {
+            Trace_Format(Out, &ring->Records[i & ring->Mask]);
+        }
+        ring->Written = 0U;
+    }
+    pthread_mutex_unlock(&RingsLock);
+
+    return GST_SUCCESS;
+};
+
+/**
+ * @brief 
+ * Releases the ring of every thread. No thread may trace again 
+ * afterwards, except the calling one.
+ * 
+ * @return GStatus The success of the release.
+ */
+GStatus Trace_Free(void)
+{
+    struct trace_ring *ring;
+
+    pthread_mutex_lock(&RingsLock);
+    while (Rings != NULL)
+    {
+        ring = Rings;
+        Rings = ring->Next;
+        free(ring->Records);
+        free(ring);
+    }
+    RingCount = 0U;
+    LocalRing = NULL;
+    pthread_mutex_unlock(&RingsLock);
+
+    return GST_SUCCESS;
+};
+
+/**
+ * @brief Allocates the ring of the calling thread and registers it for Trace_Dump.
+ */
+static struct trace_ring *Trace_NewRing(void)
+{
+    struct trace_ring *ring = malloc(sizeof(struct trace_ring));
+    uint64_t size = 2U;
+
+    while (size < TRACE_RING_CAPACITY)
+    {
+        size <<= 1;
+    }
+    if (ring == NULL)
+    {
+        return NULL;
+    }
+    ring->Records = malloc(size*sizeof(struct trace_record));
+    if (ring->Records == NULL)
+    {
+        free(ring);
+        return NULL;
+    }
+    ring->Written = 0U;
+    ring->Mask = size - 1U;
+
+    pthread_mutex_lock(&RingsLock);
+    ring->Thread = RingCount++;
+    ring->Next = Rings;
+    Rings = ring;
+    pthread_mutex_unlock(&RingsLock);
+
+    LocalRing = ring;
+
+    return ring;
+}
+
+/**
+ * @brief Writes one record as a line of text.
+ */
+static void Trace_Format(FILE *Out, const struct trace_record *Record)
+{
+    uint64_t i;
+
+    switch (Record->Event)
+    {
+    case TRACE_REWARD:
+        // Indented by depth, so the search tree can be read off the trace
+        for (i = 0U; i < Record->Arg; i++)
+        {
+            fputc('\t', Out);
+        }
+        fprintf(Out, "Reward Score(%" PRIu64 "), Depth(%" PRIu64 "), MyTurn(%u), Reward(%" PRId64 ")\n",
+            Record->Score, Record->Arg, Record->Turn, Record->Value.Integer);
+        break;
+    case TRACE_REWARD_HIT:
+        fprintf(Out, "Reward Score (%" PRId64 ") -- Using Transposition Table Stored Value!\n", Record->Value.Integer);
+        break;
+    case TRACE_CANDIDATE:
+        fprintf(Out, "Calculate Add %" PRIu64 " Reward...\n", Record->Arg);
+        break;
+    case TRACE_CANDIDATE_END:
+        fprintf(Out, "Add %" PRIu64 " Reward: %" PRId64 "\n", Record->Arg, Record->Value.Integer);
+        break;
+    case TRACE_BEST:
+        fprintf(Out, "Best Move Is Add %" PRIu64 "\n", Record->Arg);
+        break;
+    case TRACE_SOLVE:
+        fprintf(Out, "Solve Score(%" PRIu64 "), MyTurn(%u), Value(%" PRId64 ")\n", Record->Score, Record->Turn, Record->Value.Integer);
+        break;
+    case TRACE_LOOKUP:
+        fprintf(Out, "Best Move Is Add %" PRIu64 " (Table Lookup)\n", Record->Arg);
+        break;
+    default:
+        fprintf(Out, "Unknown trace event %u\n", Record->Event);
+        break;
+    }
+}
+
+/*** end of file ***/
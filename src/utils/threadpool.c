@@ -0,0 +1,338 @@
+/** @file threadpool.c
+ * 
+ * @brief 
+ * A work-stealing thread pool. Every worker owns a deque of tasks,
+ * takes work from its own end, and steals from the other end of
+ * another worker's deque when it runs out.
+ *
+ * @par       
+ * COPYRIGHT NOTICE: (c) 2021 Graham Power.  All rights reserved.
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */ 
+
+#include "threadpool.h"
+
+#include <stdlib.h>
+#include <sched.h>
+#include <unistd.h>
+
+/************************** Constant Definitions *****************************/
+
+/**************************** Type Definitions *******************************/
+
+struct worker_arg
+{
+    threadpool_t Pool;
+    uint32_t Worker;
+};
+
+/************************** Function Prototypes ******************************/
+
+static GStatus Deque_Push(struct wsdeque *deque, struct task *task);
+static struct task *Deque_Take(struct wsdeque *deque);
+static struct task *Deque_Steal(struct wsdeque *deque);
+static void *ThreadPool_Worker(void *Arg);
+
+/************************** Function Definitions *****************************/
+
+/**
+ * @brief 
+ * Initializes a pool of workers. No threads are started until
+ * ThreadPool_Run.
+ * 
+ * @param pool The pool to initialize.
+ * @param threads The number of workers, 0 for one per core.
+ * @param capacity The most tasks one worker's deque holds, rounded up to a power of two.
+ * @return GStatus GST_FAILURE if the deques could not be allocated, GST_SUCCESS otherwise.
+ */
+GStatus ThreadPool_Init(threadpool_t pool, uint32_t threads, uint64_t capacity)
+{
+    uint32_t i;
+    int64_t size = 2;
+
+    while ((uint64_t) size < capacity)
+    {
+        size <<= 1;
+    }
+
+    pool->Threads = (threads == 0U) ? ThreadPool_Cores() : threads;
+    pool->NextSubmit = 0U;
+    atomic_init(&pool->Pending, 0U);
+    pool->Handles = calloc(pool->Threads, sizeof(pthread_t));
+    pool->Deques = calloc(pool->Threads, sizeof(struct wsdeque));
+    if (pool->Handles == NULL || pool->Deques == NULL)
+    {
+        ThreadPool_Free(pool);
+        return GST_FAILURE;
+    }
+
+    for (i = 0U; i < pool->Threads; i++)
+    {
+        atomic_init(&pool->Deques[i].Top, 0);
+        atomic_init(&pool->Deques[i].Bottom, 0);
+        pool->Deques[i].Mask = size - 1;
+        pool->Deques[i].Buffer = calloc(size, sizeof(pool->Deques[i].Buffer[0]));
+        if (pool->Deques[i].Buffer == NULL)
+        {
+            ThreadPool_Free(pool);
+            return GST_FAILURE;
+        }
+    }
+
+    return GST_SUCCESS;
+};
+
+/**
+ * @brief Releases the deques allocated by ThreadPool_Init.
+ * 
+ * @param pool The pool to release.
+ * @return GStatus The success of the release.
+ */
+GStatus ThreadPool_Free(threadpool_t pool)
+{
+    uint32_t i;
+
+    if (pool->Deques != NULL)
+    {
+        for (i = 0U; i < pool->Threads; i++)
+        {
+            free(pool->Deques[i].Buffer);
+        }
+    }
+    free(pool->Deques);
+    free(pool->Handles);
+    pool->Deques = NULL;
+    pool->Handles = NULL;
+
+    return GST_SUCCESS;
+};
+
+/**
+ * @brief 
+ * Adds a task before the pool runs. Tasks are dealt round robin
+ * over the workers, who steal from each other to even out the load.
+ * 
+ * @param pool The pool to add the task to.
+ * @param task The task to run.
+ * @return GStatus GST_FAILURE if the deque of the next worker is full, GST_SUCCESS otherwise.
+ */
+GStatus ThreadPool_Submit(threadpool_t pool, struct task *task)
+{
+    if (Deque_Push(&pool->Deques[pool->NextSubmit], task) != GST_SUCCESS)
+    {
+        return GST_FAILURE;
+    }
+    atomic_fetch_add_explicit(&pool->Pending, 1U, memory_order_relaxed);
+    pool->NextSubmit = (pool->NextSubmit + 1U) % pool->Threads;
+
+    return GST_SUCCESS;
+};
+
+/**
+ * @brief 
+ * Adds a task from inside a running task. Only the worker running
+ * the calling task may push to its own deque. If the deque is full
+ * the task is run right away instead.
+ * 
+ * @param pool The running pool.
+ * @param Worker The index of the worker running the calling task.
+ * @param task The task to run.
+ * @return GStatus The success of adding the task.
+ */
+GStatus ThreadPool_Spawn(threadpool_t pool, uint32_t Worker, struct task *task)
+{
+    atomic_fetch_add_explicit(&pool->Pending, 1U, memory_order_relaxed);
+    if (Deque_Push(&pool->Deques[Worker], task) != GST_SUCCESS)
+    {
+        task->Run(pool, Worker, task->Arg);
+        atomic_fetch_sub_explicit(&pool->Pending, 1U, memory_order_release);
+    }
+
+    return GST_SUCCESS;
+};
+
+/**
+ * @brief 
+ * Starts every worker and waits until all submitted tasks, and
+ * every task they spawned, have finished. The calling thread is
+ * used as worker 0.
+ * 
+ * @param pool The pool to run.
+ * @return GStatus GST_FAILURE if a thread could not be started, GST_SUCCESS otherwise.
+ */
+GStatus ThreadPool_Run(threadpool_t pool)
+{
+    struct worker_arg *args = calloc(pool->Threads, sizeof(struct worker_arg));
+    GStatus Status = GST_SUCCESS;
+    uint32_t started;
+    uint32_t i;
+
+    if (args == NULL)
+    {
+        return GST_FAILURE;
+    }
+
+    for (i = 0U; i < pool->Threads; i++)
+    {
+        args[i].Pool = pool;
+        args[i].Worker = i;
+    }
+
+    for (started = 1U; started < pool->Threads; started++)
+    {
+        if (pthread_create(&pool->Handles[started], NULL, ThreadPool_Worker, &args[started]) != 0)
+        {
+            // The started workers steal the remaining work
+            Status = GST_FAILURE;
+            break;
+        }
+    }
+    ThreadPool_Worker(&args[0]);
+
+    for (i = 1U; i < started; i++)
+    {
+        pthread_join(pool->Handles[i], NULL);
+    }
+    free(args);
+
+    return Status;
+};
+
+/**
+ * @brief Gets the number of cores available to the process.
+ * 
+ * @return uint32_t The number of online cores, at least 1.
+ */
+uint32_t ThreadPool_Cores(void)
+{
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+
+    return (cores < 1) ? 1U : (uint32_t) cores;
+};
+
+/**
+ * @brief 
+ * The loop of one worker. Runs tasks from its own deque first, then
+ * steals from the others, until no task is pending anywhere.
+ */
+static void *ThreadPool_Worker(void *Arg)
+{
+    struct worker_arg *worker = (struct worker_arg *) Arg;
+    threadpool_t pool = worker->Pool;
+    struct task *task;
+    uint32_t victim = worker->Worker;
+    uint32_t i;
+
+    while (atomic_load_explicit(&pool->Pending, memory_order_acquire) > 0U)
+    {
+        task = Deque_Take(&pool->Deques[worker->Worker]);
+        for (i = 1U; task == NULL && i < pool->Threads; i++)
+        {
+            victim = (victim + 1U) % pool->Threads;
+            if (victim != worker->Worker)
+            {
+                task = Deque_Steal(&pool->Deques[victim]);
+            }
+        }
+
+        if (task == NULL)
+        {
+            sched_yield();
+            continue;
+        }
+
+        task->Run(pool, worker->Worker, task->Arg);
+        atomic_fetch_sub_explicit(&pool->Pending, 1U, memory_order_release);
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Pushes a task on the owners end of a deque.
+ */
+static GStatus Deque_Push(struct wsdeque *deque, struct task *task)
+{
+    int64_t b = atomic_load_explicit(&deque->Bottom, memory_order_relaxed);
+    int64_t t = atomic_load_explicit(&deque->Top, memory_order_acquire);
+
+    if (b - t > deque->Mask)
+    {
+        return GST_FAILURE;
+    }
+    atomic_store_explicit(&deque->Buffer[b & deque->Mask], task, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&deque->Bottom, b + 1, memory_order_relaxed);
+
+    return GST_SUCCESS;
+}
+
+/**
+ * @brief Takes a task from the owners end of a deque, NULL if it is empty.
+ */
+static struct task *Deque_Take(struct wsdeque *deque)
+{
+    int64_t b = atomic_load_explicit(&deque->Bottom, memory_order_relaxed) - 1;
+    int64_t t;
+    struct task *task = NULL;
+
+    atomic_store_explicit(&deque->Bottom, b, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    t = atomic_load_explicit(&deque->Top, memory_order_relaxed);
+
+    if (t <= b)
+    {
+        task = atomic_load_explicit(&deque->Buffer[b & deque->Mask], memory_order_relaxed);
+        if (t == b)
+        {
+            // The last task, race the thieves for it
+            if (!atomic_compare_exchange_strong_explicit(&deque->Top, &t, t + 1, memory_order_seq_cst, memory_order_relaxed))
+            {
+                task = NULL;
+            }
+            atomic_store_explicit(&deque->Bottom, b + 1, memory_order_relaxed);
+        }
+    }
+    else
+    {
+        atomic_store_explicit(&deque->Bottom, b + 1, memory_order_relaxed);
+    }
+
+    return task;
+}
+
+/**
+ * @brief Steals a task from the other end of a deque, NULL if it is empty or another thief won.
+ */
+static struct task *Deque_Steal(struct wsdeque *deque)
+{
+    int64_t t = atomic_load_explicit(&deque->Top, memory_order_acquire);
+    int64_t b;
+    struct task *task = NULL;
+
+    atomic_thread_fence(memory_order_seq_cst);
+    b = atomic_load_explicit(&deque->Bottom, memory_order_acquire);
+    if (t < b)
+    {
+        task = atomic_load_explicit(&deque->Buffer[t & deque->Mask], memory_order_relaxed);
+        if (!atomic_compare_exchange_strong_explicit(&deque->Top, &t, t + 1, memory_order_seq_cst, memory_order_relaxed))
+        {
+            task = NULL;
+        }
+    }
+
+    return task;
+}
+
+/*** end of file ***/
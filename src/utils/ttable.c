@@ -0,0 +1,320 @@
+/** @file ttable.c
+ * 
+ * @brief 
+ * A transposition table to store the results of AI searches, so
+ * game states don't have to be explored more than once. Entries
+ * are found by a 64-bit key over the game state using open
+ * addressing, in a table whose capacity is a power of two.
+ * Tables can be probed and stored to by many threads at once
+ * without locks, see TTable_Shared.
+ *
+ * @par       
+ * COPYRIGHT NOTICE: (c) 2021 Graham Power.  All rights reserved.
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */ 
+
+#include "ttable.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+/************************** Constant Definitions *****************************/
+
+// Key 0 marks an empty slot, a state that hashes to it is moved here
+#define TTABLE_KEY_ZERO     0x9E3779B97F4A7C15ULL
+
+/**************************** Type Definitions *******************************/
+
+static struct ttable SharedTable;
+static pthread_once_t SharedOnce = PTHREAD_ONCE_INIT;
+
+/************************** Function Prototypes ******************************/
+
+static uint64_t TTable_Mix(uint64_t x);
+static uint64_t TTable_Pack(const struct ttdata *Data);
+static void TTable_Unpack(uint64_t Word, struct ttdata *Data);
+static void TTable_InitShared(void);
+
+/************************** Function Definitions *****************************/
+
+/**
+ * @brief 
+ * Allocates an empty table. The capacity is rounded up to the
+ * next power of two so keys can be mapped to slots with a mask.
+ * 
+ * @param table The table to initialize.
+ * @param capacity The minimum number of entries the table holds.
+ * @return GStatus GST_FAILURE if the entries could not be allocated, GST_SUCCESS otherwise.
+ */
+GStatus TTable_Init(ttable_t table, uint64_t capacity)
+{
+    uint64_t size = TTABLE_PROBE_LIMIT;
+    while (size < capacity && size <= (SIZE_MAX / sizeof(struct ttentry)) / 2U)
+    {
+        size <<= 1;
+    }
+
+    table->Entries = calloc(size, sizeof(struct ttentry));
+    if (table->Entries == NULL)
+    {
+        table->Mask = 0U;
+        return GST_FAILURE;
+    }
+    table->Mask = size - 1U;
+    table->Shared = 0U;
+    memset(&table->Stats, 0, sizeof(table->Stats));
+
+    return GST_SUCCESS;
+};
+
+/**
+ * @brief Releases the entries allocated by TTable_Init.
+ * 
+ * @param table The table to release.
+ * @return GStatus The success of the release.
+ */
+GStatus TTable_Free(ttable_t table)
+{
+    free(table->Entries);
+    table->Entries = NULL;
+    table->Mask = 0U;
+
+    return GST_SUCCESS;
+};
+
+/**
+ * @brief 
+ * Gets the table shared by every player of the process, allocated 
+ * with TTABLE_SHARED_CAPACITY entries the first time it is asked 
+ * for. Any thread may probe and store at any time, so states one 
+ * game solves are found by every other game, on any thread. It is 
+ * never freed.
+ * 
+ * @return ttable_t The shared table, NULL if it could not be allocated.
+ */
+ttable_t TTable_Shared(void)
+{
+    pthread_once(&SharedOnce, TTable_InitShared);
+
+    return (SharedTable.Entries != NULL) ? &SharedTable : NULL;
+};
+
+/**
+ * @brief 
+ * Empties every slot of the table and resets its stats. No other 
+ * thread may use the table during the clear.
+ * 
+ * @param table The table to clear.
+ * @return GStatus The success of the clear.
+ */
+GStatus TTable_Clear(ttable_t table)
+{
+    memset(table->Entries, 0, (table->Mask + 1U)*sizeof(struct ttentry));
+    memset(&table->Stats, 0, sizeof(table->Stats));
+
+    return GST_SUCCESS;
+};
+
+/**
+ * @brief 
+ * Calculates the key of a game state. The rules are part of the
+ * key, so games with different targets, moves or endings never
+ * share entries.
+ * 
+ * @param rules The rules of the game the state belongs to.
+ * @param Score The score of the game.
+ * @param Turn Whose turn it is in the state.
+ * @param Ply
+ * How far the state is from the root of the search, for solvers
+ * whose values depend on it. 0 otherwise.
+ * @return uint64_t The key of the state, never 0.
+ */
+uint64_t TTable_Key(rules_t rules, uint64_t Score, uint8_t Turn, uint64_t Ply)
+{
+    uint64_t key = TTable_Mix(rules->Target) ^ TTable_Mix(rules->MaxAdvancement + 0x632BE59BD9B4E019ULL) ^ rules->MoveHash;
+    key ^= TTable_Mix(rules->Ending + 0xD1B54A32D192ED03ULL);
+    key = TTable_Mix(key ^ ((Score << 1) | (Turn & 1U)));
+    key = TTable_Mix(key + Ply);
+
+    return (key == 0U) ? TTABLE_KEY_ZERO : key;
+};
+
+/**
+ * @brief 
+ * Stores the data for a key. The key replaces its own entry if it
+ * already has one, or takes the first empty slot in its probe window.
+ * When the window is full of other keys the entry with the shallowest
+ * Depth is replaced. Safe to call from many threads at once.
+ * 
+ * @param table The table to store the data in.
+ * @param Key The key of the state, from TTable_Key.
+ * @param Data The data to store.
+ * @return GStatus The success of the store.
+ */
+GStatus TTable_Store(ttable_t table, uint64_t Key, const struct ttdata *Data)
+{
+    struct ttentry *victim = NULL;
+    struct ttentry *entry;
+    uint64_t i;
+    uint64_t key;
+    uint64_t data;
+    uint64_t victimKey = 0U;
+    uint64_t word = TTable_Pack(Data);
+    uint8_t depth;
+    uint8_t shallowest = UINT8_MAX;
+
+    for (i = 0U; i < TTABLE_PROBE_LIMIT; i++)
+    {
+        entry = &table->Entries[(Key + i) & table->Mask];
+        data = atomic_load_explicit(&entry->Data, memory_order_relaxed);
+        key = atomic_load_explicit(&entry->Key, memory_order_relaxed) ^ data;
+        if (key == Key || key == 0U)
+        {
+            victim = entry;
+            victimKey = key;
+            break;
+        }
+
+        depth = (uint8_t) (data >> 48);
+        if (victim == NULL || depth < shallowest)
+        {
+            victim = entry;
+            victimKey = key;
+            shallowest = depth;
+        }
+    }
+
+    if (!table->Shared)
+    {
+        table->Stats.Stores++;
+        table->Stats.Replacements += (victimKey != Key && victimKey != 0U) ? 1U : 0U;
+    }
+    // Racing stores may mix their words, which then fail the check in TTable_Probe
+    atomic_store_explicit(&victim->Data, word, memory_order_relaxed);
+    atomic_store_explicit(&victim->Key, Key ^ word, memory_order_relaxed);
+
+    return GST_SUCCESS;
+};
+
+/**
+ * @brief Looks up the data stored for a key.
+ * 
+ * @param table The table to look in.
+ * @param Key The key of the state, from TTable_Key.
+ * @param Data Pointer to the data. TTable_Probe stores the entry here when found.
+ * @return GStatus GST_SUCCESS if the key was found, GST_FAILURE otherwise.
+ */
+GStatus TTable_Probe(ttable_t table, uint64_t Key, struct ttdata *Data)
+{
+    struct ttentry *entry;
+    uint64_t i;
+    uint64_t key;
+    uint64_t data;
+
+    for (i = 0U; i < TTABLE_PROBE_LIMIT; i++)
+    {
+        entry = &table->Entries[(Key + i) & table->Mask];
+        data = atomic_load_explicit(&entry->Data, memory_order_relaxed);
+        key = atomic_load_explicit(&entry->Key, memory_order_relaxed) ^ data;
+        if (key == Key)
+        {
+            TTable_Unpack(data, Data);
+            if (!table->Shared)
+            {
+                table->Stats.Probes++;
+                table->Stats.Hits++;
+            }
+            return GST_SUCCESS;
+        }
+        if (key == 0U)
+        {
+            break;
+        }
+    }
+    if (!table->Shared)
+    {
+        table->Stats.Probes++;
+        table->Stats.Misses++;
+    }
+
+    return GST_FAILURE;
+};
+
+/**
+ * @brief Copies out the probe and store counters of the table, all 0 for the shared table.
+ * 
+ * @param table The table to read.
+ * @param Stats Pointer to the stats. TTable_GetStats stores the counters here.
+ * @return GStatus The success of the read.
+ */
+GStatus TTable_GetStats(ttable_t table, struct ttstats *Stats)
+{
+    *Stats = table->Stats;
+
+    return GST_SUCCESS;
+};
+
+/**
+ * @brief Allocates the shared table, run once by TTable_Shared.
+ */
+static void TTable_InitShared(void)
+{
+    if (TTable_Init(&SharedTable, TTABLE_SHARED_CAPACITY) == GST_SUCCESS)
+    {
+        SharedTable.Shared = 1U;
+    }
+}
+
+/**
+ * @brief The splitmix64 finalizer, spreads every input bit over the output.
+ */
+static uint64_t TTable_Mix(uint64_t x)
+{
+    x ^= x >> 30;
+    x *= 0xBF58476D1CE4E5B9ULL;
+    x ^= x >> 27;
+    x *= 0x94D049BB133111EBULL;
+    x ^= x >> 31;
+
+    return x;
+}
+
+/**
+ * @brief Packs data as Value | Move << 32 | Depth << 48 | Flags << 56.
+ */
+static uint64_t TTable_Pack(const struct ttdata *Data)
+{
+    uint32_t value;
+    memcpy(&value, &Data->Value, sizeof(value));
+
+    return (uint64_t) value
+        | ((uint64_t) Data->Move << 32)
+        | ((uint64_t) Data->Depth << 48)
+        | ((uint64_t) Data->Flags << 56);
+}
+
+/**
+ * @brief Unpacks data packed by TTable_Pack.
+ */
+static void TTable_Unpack(uint64_t Word, struct ttdata *Data)
+{
+    uint32_t value = (uint32_t) Word;
+    memcpy(&Data->Value, &value, sizeof(value));
+    Data->Move = (uint16_t) (Word >> 32);
+    Data->Depth = (uint8_t) (Word >> 48);
+    Data->Flags = (uint8_t) (Word >> 56);
+}
+
+/*** end of file ***/
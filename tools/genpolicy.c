@@ -0,0 +1,114 @@
+/** @file genpolicy.c
+ * 
+ * @brief 
+ * Build tool that solves the game for the rules in parameters.h 
+ * with the Dynamic table solver, and writes the best move for every 
+ * score to a C header. The header is compiled into the Compiled 
+ * player, so it plays without solving anything at runtime.
+ *
+ * @par       
+ * COPYRIGHT NOTICE: (c) 2021 Graham Power.  All rights reserved.
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */ 
+
+/***************************** Include Files *********************************/
+
+#include "parameters.h"
+
+#include <stdio.h>
+#include <stdint.h>
+#include <inttypes.h>
+
+#include "status.h"
+#include "game.h"
+#include "dynamic.h"
+
+/************************** Constant Definitions *****************************/
+
+#define POLICY_MOVES_PER_LINE   16U
+
+/**************************** Type Definitions *******************************/
+
+/************************** Function Prototypes ******************************/
+
+/************************** Function Definitions *****************************/
+
+/**
+ * @brief Gets the smallest unsigned type that holds every move.
+ */
+static const char *MoveType(uint64_t maxAdvancement)
+{
+	if (maxAdvancement <= UINT8_MAX)
+	{
+		return "uint8_t";
+	}
+	if (maxAdvancement <= UINT16_MAX)
+	{
+		return "uint16_t";
+	}
+	return "uint32_t";
+}
+
+int main(int argc, char *argv[])
+{
+	struct rules rules_s;
+	struct Dynamic Dynamic;
+	struct Actor Actor;
+	uint64_t Score;
+	FILE *file;
+
+	if (argc != 2)
+	{
+		fprintf(stderr, "Usage: %s policy.h\n", argv[0]);
+		return (1);
+	}
+
+	if (Game_InitRules(&rules_s, MAX_STATE, MAX_STATE_ADVANCEMENT) != GST_SUCCESS ||
+		Dynamic_InitTable(&Actor, &Dynamic, &rules_s) != GST_SUCCESS)
+	{
+		fprintf(stderr, "Could not solve the game for the rules in parameters.h\n");
+		return (1);
+	}
+
+	file = fopen(argv[1], "w");
+	if (file == NULL)
+	{
+		fprintf(stderr, "Could not open %s\n", argv[1]);
+		Dynamic_Free(&Dynamic);
+		return (1);
+	}
+
+	fprintf(file, "/** @file policy.h\n");
+	fprintf(file, " * \n");
+	fprintf(file, " * @brief \n");
+	fprintf(file, " * The best move for every score, for the rules in parameters.h.\n");
+	fprintf(file, " * Generated by tools/genpolicy.c, don't edit it by hand.\n");
+	fprintf(file, " */ \n\n");
+	fprintf(file, "#ifndef GNP_POLICY_H\n");
+	fprintf(file, "#define GNP_POLICY_H\n\n");
+	fprintf(file, "#include <stdint.h>\n\n");
+	fprintf(file, "#define POLICY_TARGET           %" PRIu64 "U\n", rules_s.Target);
+	fprintf(file, "#define POLICY_MAX_ADVANCEMENT  %" PRIu64 "U\n\n", rules_s.MaxAdvancement);
+	fprintf(file, "static const %s PolicyMoves[POLICY_TARGET] = {", MoveType(rules_s.MaxAdvancement));
+	for (Score = 0U; Score < rules_s.Target; Score++)
+	{
+		fprintf(file, "%s%" PRIu32 ",", (Score % POLICY_MOVES_PER_LINE == 0U) ? "\n    " : " ", Dynamic.Moves[Score]);
+	}
+	fprintf(file, "\n};\n\n");
+	fprintf(file, "#endif /* GNP_POLICY_H */\n");
+
+	Dynamic_Free(&Dynamic);
+
+	return (fclose(file) == 0) ? 0 : 1;
+}
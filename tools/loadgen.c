@@ -0,0 +1,538 @@
+/** @file loadgen.c
+ * 
+ * @brief 
+ * Load generator for the game server. Opens many connections to a
+ * server started with -S, plays random legal moves in every one at
+ * once, and checks every reply against its own copy of the game.
+ * Prints the games and requests a second and the round trip times,
+ * and exits with 1 if any reply was wrong. With -r it first sends
+ * requests for the largest games a client may ask for, and checks
+ * that the server refuses or plays them without going down.
+ *
+ * @par       
+ * COPYRIGHT NOTICE: (c) 2021 Graham Power.  All rights reserved.
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */ 
+
+/***************************** Include Files *********************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+
+#include "status.h"
+#include "parameters.h"
+
+/************************** Constant Definitions *****************************/
+
+#define LOADGEN_DEFAULT_CONNECTIONS	64U
+#define LOADGEN_DEFAULT_GAMES		100U
+#define LOADGEN_DEFAULT_TARGET		20U
+#define LOADGEN_DEFAULT_MAX			2U
+#define LOADGEN_LINE_MAX			128U
+#define LOADGEN_EVENTS				256U
+#define LOADGEN_PROBE_SECONDS		10
+
+/**************************** Type Definitions *******************************/
+
+struct connection
+{
+	int Fd;
+	char In[LOADGEN_LINE_MAX];
+	uint32_t InLength;
+	uint64_t Games;			// Games finished on this connection
+	uint64_t Score;			// The score once the server has answered the last move
+	uint64_t Move;			// The last move sent, 0 for NEW
+	uint8_t First;			// The client moves first in the game
+	double Sent;			// When the last request was sent
+	uint8_t Quitting;
+};
+
+struct loadgen
+{
+	uint64_t Target;
+	uint64_t Max;
+	uint8_t Misere;
+	const char *Player;
+	const char *Ending;
+	uint64_t Games;			// Games every connection plays
+	uint64_t Random;		// xorshift64* state
+	uint64_t Requests;
+	uint64_t Finished;
+	uint64_t Errors;
+	double *Latencies;		// Every round trip, in seconds
+	uint64_t LatencyCount;
+	uint64_t LatencyCapacity;
+};
+
+/************************** Function Prototypes ******************************/
+
+/************************** Function Definitions *****************************/
+
+static void Usage(const char *name)
+{
+	fprintf(stderr, "Usage: %s -a address [-c connections] [-g games] [-p player] [-n target] [-k max advancement] [-e ending] [-s seed] [-r]\n", name);
+	fprintf(stderr, "  -a  The address the server listens on, unix:PATH or tcp:PORT\n");
+	fprintf(stderr, "  -c  The connections playing at once (default %u)\n", LOADGEN_DEFAULT_CONNECTIONS);
+	fprintf(stderr, "  -g  The games every connection plays (default %u)\n", LOADGEN_DEFAULT_GAMES);
+	fprintf(stderr, "  -p  The player type the server plays (default table)\n");
+	fprintf(stderr, "  -n  The target of the games (default %u)\n", LOADGEN_DEFAULT_TARGET);
+	fprintf(stderr, "  -k  The max advancement of the games (default %u)\n", LOADGEN_DEFAULT_MAX);
+	fprintf(stderr, "  -e  The ending of the games, normal, misere or first (default normal)\n");
+	fprintf(stderr, "  -s  The seed of the moves played (default 1)\n");
+	fprintf(stderr, "  -r  Check the server copes with the largest games first\n");
+}
+
+static double Now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double) ts.tv_sec + (double) ts.tv_nsec * 1e-9;
+}
+
+static uint64_t Next(struct loadgen *Load)
+{
+	uint64_t x = Load->Random;
+	x ^= x >> 12;
+	x ^= x << 25;
+	x ^= x >> 27;
+	Load->Random = x;
+
+	return x * 0x2545F4914F6CDD1DULL;
+}
+
+static int CompareLatency(const void *a, const void *b)
+{
+	double x = *(const double *) a;
+	double y = *(const double *) b;
+
+	return (x > y) - (x < y);
+}
+
+/**
+ * @brief Opens a connection to unix:PATH or tcp:PORT on localhost, -1 if it fails.
+ */
+static int Connect(const char *Address)
+{
+	struct sockaddr_un Unix;
+	struct sockaddr_in Inet;
+	int fd = -1;
+
+	if (strncmp(Address, "unix:", 5U) == 0 && strlen(&Address[5]) < sizeof(Unix.sun_path))
+	{
+		memset(&Unix, 0, sizeof(Unix));
+		Unix.sun_family = AF_UNIX;
+		strcpy(Unix.sun_path, &Address[5]);
+		fd = socket(AF_UNIX, SOCK_STREAM, 0);
+		if (fd >= 0 && connect(fd, (struct sockaddr *) &Unix, sizeof(Unix)) != 0)
+		{
+			close(fd);
+			fd = -1;
+		}
+	}
+	else if (strncmp(Address, "tcp:", 4U) == 0)
+	{
+		memset(&Inet, 0, sizeof(Inet));
+		Inet.sin_family = AF_INET;
+		Inet.sin_port = htons((uint16_t) strtoul(&Address[4], NULL, 10));
+		Inet.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+		fd = socket(AF_INET, SOCK_STREAM, 0);
+		if (fd >= 0 && connect(fd, (struct sockaddr *) &Inet, sizeof(Inet)) != 0)
+		{
+			close(fd);
+			fd = -1;
+		}
+	}
+
+	if (fd >= 0)
+	{
+		fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+	}
+
+	return fd;
+}
+
+/**
+ * @brief 
+ * Sends one request. Requests are far smaller than a socket buffer 
+ * and only one is in flight per connection, so it is sent whole.
+ */
+static GStatus Send(struct loadgen *Load, struct connection *Connection, const char *Request)
+{
+	size_t length = strlen(Request);
+	ssize_t sent;
+
+	Connection->Sent = Now();
+	Load->Requests++;
+	sent = send(Connection->Fd, Request, length, MSG_NOSIGNAL);
+
+	return (sent == (ssize_t) length) ? GST_SUCCESS : GST_FAILURE;
+}
+
+/**
+ * @brief Starts the next game of a connection, the connections take turns at moving first.
+ */
+static GStatus Start(struct loadgen *Load, struct connection *Connection)
+{
+	char Request[LOADGEN_LINE_MAX];
+
+	Connection->Score = 0U;
+	Connection->Move = 0U;
+	Connection->First = ((Connection->Games + (uint64_t) Connection->Fd) % 2U == 0U) ? 1U : 0U;
+	snprintf(Request, sizeof(Request), "NEW %s %u %" PRIu64 " %" PRIu64 " %s\n", Load->Player,
+		Connection->First ? 1U : 2U, Load->Target, Load->Max, Load->Ending);
+
+	return Send(Load, Connection, Request);
+}
+
+/**
+ * @brief 
+ * Checks a reply against the game, and sends the next request. 
+ * Returns GST_FAILURE once the connection is done with.
+ */
+static GStatus Reply(struct loadgen *Load, struct connection *Connection, const char *Line)
+{
+	char Request[LOADGEN_LINE_MAX];
+	char Word[8];
+	uint64_t Advancement;
+	uint64_t Score;
+	uint64_t Expected = Connection->Score + Connection->Move;
+	uint64_t Move;
+	uint64_t Legal;
+	uint8_t ClientWins;
+	uint8_t ServerMoves;
+
+	if (Load->LatencyCount == Load->LatencyCapacity)
+	{
+		Load->LatencyCapacity = (Load->LatencyCapacity == 0U) ? 4096U : 2U*Load->LatencyCapacity;
+		Load->Latencies = realloc(Load->Latencies, Load->LatencyCapacity*sizeof(double));
+		if (Load->Latencies == NULL)
+		{
+			return GST_FAILURE;
+		}
+	}
+	Load->Latencies[Load->LatencyCount++] = Now() - Connection->Sent;
+
+	if (Connection->Quitting)
+	{
+		Load->Errors += (strcmp(Line, "BYE") == 0) ? 0U : 1U;
+		return GST_FAILURE;
+	}
+
+	// The server moves unless the client starts or the clients move ended the game
+	ServerMoves = (Connection->Move == 0U) ? !Connection->First : (Expected < Load->Target);
+	if (sscanf(Line, "%7s %" SCNu64 " %" SCNu64, Word, &Advancement, &Score) != 3 ||
+		Score != Expected + Advancement || Advancement > Load->Max || Score > Load->Target ||
+		(Advancement != 0U) != ServerMoves)
+	{
+		fprintf(stderr, "Unexpected reply on %d after %" PRIu64 " + %" PRIu64 ": %s\n", Connection->Fd, Connection->Score, Connection->Move, Line);
+		Load->Errors++;
+		return GST_FAILURE;
+	}
+
+	if (strcmp(Word, "PLAY") == 0)
+	{
+		if (Score == Load->Target)
+		{
+			fprintf(stderr, "Game on %d goes on at the target: %s\n", Connection->Fd, Line);
+			Load->Errors++;
+			return GST_FAILURE;
+		}
+		Legal = (Load->Target - Score < Load->Max) ? Load->Target - Score : Load->Max;
+		Move = 1U + Next(Load) % Legal;
+		Connection->Score = Score;
+		Connection->Move = Move;
+		snprintf(Request, sizeof(Request), "MOVE %" PRIu64 "\n", Move);
+		return Send(Load, Connection, Request);
+	}
+
+	// The game ends at the target, the mover who ends it wins unless it is misere
+	ClientWins = ((Advancement == 0U) != Load->Misere) ? 1U : 0U;
+	if (Score != Load->Target || strcmp(Word, ClientWins ? "WIN" : "LOSS") != 0)
+	{
+		fprintf(stderr, "Wrong result on %d: %s\n", Connection->Fd, Line);
+		Load->Errors++;
+		return GST_FAILURE;
+	}
+
+	Load->Finished++;
+	Connection->Games++;
+	if (Connection->Games < Load->Games)
+	{
+		return Start(Load, Connection);
+	}
+	Connection->Quitting = 1U;
+
+	return Send(Load, Connection, "QUIT\n");
+}
+
+/**
+ * @brief 
+ * Sends requests for games at the largest targets clients may ask 
+ * for, one at a time, and checks every one is answered in time with 
+ * the expected reply. A server that can't play a game must refuse it, 
+ * not crash or stall.
+ */
+static GStatus Probe(const char *Address)
+{
+	struct timeval Timeout = { .tv_sec = LOADGEN_PROBE_SECONDS };
+	char Requests[8][LOADGEN_LINE_MAX];
+	const char *Expected[8] = { "PLAY", "ERR", "ERR", "PLAY", "PLAY", "ERR", "ERR", "LOSS" };
+	char Line[LOADGEN_LINE_MAX];
+	GStatus Status = GST_SUCCESS;
+	size_t length;
+	ssize_t got;
+	int fd = Connect(Address);
+	int i;
+
+	snprintf(Requests[0], LOADGEN_LINE_MAX, "NEW dynamic 2 %lu 3\n", SERVER_MAX_TARGET);
+	snprintf(Requests[1], LOADGEN_LINE_MAX, "NEW mcts 2 %lu 3\n", SERVER_MAX_MCTS_TARGET + 1UL);
+	snprintf(Requests[2], LOADGEN_LINE_MAX, "NEW table 2 %lu 3\n", SERVER_MAX_TARGET + 1UL);
+	snprintf(Requests[3], LOADGEN_LINE_MAX, "NEW alphabeta 1 %lu 3\n", SERVER_MAX_TARGET);
+	snprintf(Requests[4], LOADGEN_LINE_MAX, "MOVE 3\n");
+	// Moves as large as the target cost the solvers that try every move from every state
+	snprintf(Requests[5], LOADGEN_LINE_MAX, "NEW dynamic 2 %lu %lu misere\n", SERVER_MAX_TARGET, SERVER_MAX_TARGET);
+	snprintf(Requests[6], LOADGEN_LINE_MAX, "NEW bitset 2 %lu %lu\n", SERVER_MAX_TARGET, SERVER_MAX_TARGET);
+	snprintf(Requests[7], LOADGEN_LINE_MAX, "NEW dynamic 2 %lu %lu\n", SERVER_MAX_TARGET, SERVER_MAX_TARGET);
+
+	if (fd < 0)
+	{
+		fprintf(stderr, "Could not connect to %s\n", Address);
+		return GST_FAILURE;
+	}
+	fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) & ~O_NONBLOCK);
+	setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &Timeout, sizeof(Timeout));
+
+	for (i = 0; i < 8 && Status == GST_SUCCESS; i++)
+	{
+		length = strlen(Requests[i]);
+		Status = (send(fd, Requests[i], length, MSG_NOSIGNAL) == (ssize_t) length) ? GST_SUCCESS : GST_FAILURE;
+
+		// Replies are one line, read up to its end
+		for (length = 0U; Status == GST_SUCCESS && (length == 0U || Line[length - 1U] != '\n'); length += (size_t) got)
+		{
+			got = recv(fd, &Line[length], sizeof(Line) - 1U - length, 0);
+			Status = (got > 0) ? GST_SUCCESS : GST_FAILURE;
+		}
+		Line[(length > 0U) ? length - 1U : 0U] = '\0';
+		Requests[i][strlen(Requests[i]) - 1U] = '\0';
+		if (Status != GST_SUCCESS || strncmp(Line, Expected[i], strlen(Expected[i])) != 0)
+		{
+			fprintf(stderr, "Probe %s expected %s, got %s\n", Requests[i], Expected[i], (Status == GST_SUCCESS) ? Line : "no reply");
+			Status = GST_FAILURE;
+		}
+	}
+	close(fd);
+	printf("Probe: %s\n", (Status == GST_SUCCESS) ? "passed" : "failed");
+
+	return Status;
+}
+
+int main(int argc, char *argv[])
+{
+	struct loadgen Load = {
+		.Target = LOADGEN_DEFAULT_TARGET, .Max = LOADGEN_DEFAULT_MAX, .Player = "table",
+		.Ending = "normal", .Games = LOADGEN_DEFAULT_GAMES, .Random = 1U,
+	};
+	struct epoll_event Events[LOADGEN_EVENTS];
+	struct epoll_event Event;
+	struct connection *Connections;
+	struct connection *Connection;
+	const char *Address = NULL;
+	uint64_t connections = LOADGEN_DEFAULT_CONNECTIONS;
+	uint8_t probe = 0U;
+	uint64_t open = 0U;
+	uint64_t i;
+	ssize_t got;
+	ssize_t j;
+	double start;
+	double elapsed;
+	double total = 0.0;
+	int epoll;
+	int count;
+	int e;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "a:c:g:p:n:k:e:s:rh")) != -1)
+	{
+		switch (opt)
+		{
+		case 'a':
+			Address = optarg;
+			break;
+		case 'c':
+			connections = strtoull(optarg, NULL, 10);
+			break;
+		case 'g':
+			Load.Games = strtoull(optarg, NULL, 10);
+			break;
+		case 'p':
+			Load.Player = optarg;
+			break;
+		case 'n':
+			Load.Target = strtoull(optarg, NULL, 10);
+			break;
+		case 'k':
+			Load.Max = strtoull(optarg, NULL, 10);
+			break;
+		case 'e':
+			Load.Ending = optarg;
+			break;
+		case 's':
+			Load.Random = strtoull(optarg, NULL, 10);
+			break;
+		case 'r':
+			probe = 1U;
+			break;
+		default:
+			Usage(argv[0]);
+			return (opt == 'h') ? 0 : 1;
+		}
+	}
+	if (Address == NULL || connections == 0U || Load.Games == 0U || Load.Target == 0U || Load.Max == 0U ||
+		(strcmp(Load.Ending, "normal") != 0 && strcmp(Load.Ending, "misere") != 0 && strcmp(Load.Ending, "first") != 0))
+	{
+		Usage(argv[0]);
+		return (1);
+	}
+	Load.Misere = (strcmp(Load.Ending, "misere") == 0) ? 1U : 0U;
+	Load.Random = (Load.Random == 0U) ? 1U : Load.Random;
+	if (probe && Probe(Address) != GST_SUCCESS)
+	{
+		return (1);
+	}
+
+	epoll = epoll_create1(0);
+	Connections = calloc(connections, sizeof(struct connection));
+	if (epoll < 0 || Connections == NULL)
+	{
+		fprintf(stderr, "Could not set up the connections\n");
+		return (1);
+	}
+
+	start = Now();
+	for (i = 0U; i < connections; i++)
+	{
+		Connection = &Connections[i];
+		Connection->Fd = Connect(Address);
+		memset(&Event, 0, sizeof(Event));
+		Event.events = EPOLLIN;
+		Event.data.ptr = Connection;
+		if (Connection->Fd < 0 || epoll_ctl(epoll, EPOLL_CTL_ADD, Connection->Fd, &Event) != 0 || Start(&Load, Connection) != GST_SUCCESS)
+		{
+			fprintf(stderr, "Could not connect to %s\n", Address);
+			Load.Errors++;
+			break;
+		}
+		open++;
+	}
+
+	while (open > 0U)
+	{
+		count = epoll_wait(epoll, Events, LOADGEN_EVENTS, -1);
+		if (count < 0 && errno == EINTR)
+		{
+			continue;
+		}
+		if (count < 0)
+		{
+			break;
+		}
+
+		for (e = 0; e < count; e++)
+		{
+			Connection = (struct connection *) Events[e].data.ptr;
+			got = recv(Connection->Fd, Connection->In + Connection->InLength, sizeof(Connection->In) - Connection->InLength, 0);
+			if (got < 0 && (errno == EAGAIN || errno == EINTR))
+			{
+				continue;
+			}
+			if (got <= 0)
+			{
+				// The server hung up before the game was over
+				Load.Errors += Connection->Quitting ? 0U : 1U;
+				close(Connection->Fd);
+				open--;
+				continue;
+			}
+
+			Connection->InLength += (uint32_t) got;
+			for (j = 0; j < (ssize_t) Connection->InLength; j++)
+			{
+				if (Connection->In[j] != '\n')
+				{
+					continue;
+				}
+				Connection->In[j] = '\0';
+				if (Reply(&Load, Connection, Connection->In) != GST_SUCCESS)
+				{
+					close(Connection->Fd);
+					open--;
+					Connection->InLength = 0U;
+					break;
+				}
+				// Only one request is in flight, so nothing follows the reply
+				Connection->InLength = 0U;
+				break;
+			}
+			if (Connection->InLength == sizeof(Connection->In))
+			{
+				fprintf(stderr, "Reply on %d is too long\n", Connection->Fd);
+				Load.Errors++;
+				close(Connection->Fd);
+				open--;
+			}
+		}
+	}
+	elapsed = Now() - start;
+
+	for (i = 0U; i < Load.LatencyCount; i++)
+	{
+		total += Load.Latencies[i];
+	}
+	if (Load.LatencyCount > 0U)
+	{
+		qsort(Load.Latencies, Load.LatencyCount, sizeof(double), CompareLatency);
+	}
+
+	printf("Games: %" PRIu64 " of %" PRIu64 "\n", Load.Finished, connections*Load.Games);
+	printf("Requests: %" PRIu64 "\n", Load.Requests);
+	printf("Errors: %" PRIu64 "\n", Load.Errors);
+	printf("Games/s: %.0f\n", (double) Load.Finished / elapsed);
+	printf("Requests/s: %.0f\n", (double) Load.Requests / elapsed);
+	if (Load.LatencyCount > 0U)
+	{
+		printf("Round trip us: mean %.1f, p50 %.1f, p99 %.1f, max %.1f\n", 1e6 * total / (double) Load.LatencyCount,
+			1e6 * Load.Latencies[Load.LatencyCount / 2U], 1e6 * Load.Latencies[(Load.LatencyCount * 99U) / 100U],
+			1e6 * Load.Latencies[Load.LatencyCount - 1U]);
+	}
+
+	free(Load.Latencies);
+	free(Connections);
+	close(epoll);
+
+	return (Load.Errors == 0U && Load.Finished == connections*Load.Games) ? 0 : 1;
+}